@@ -0,0 +1,222 @@
+#include <lambda/lambda.hpp>
+#include <lambda/crc.hpp>
+
+#include "bench.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace baseline
+{
+
+// Straightforward implementations of each algorithm, as a reference
+// for the lambda versions.
+
+/// \brief Edit distance by dynamic programming over two rows.
+size_t levenshtein(const std::string &left, const std::string &right)
+{
+    std::vector<size_t> previous(right.size() + 1);
+    std::vector<size_t> current(right.size() + 1);
+    for (size_t j = 0; j <= right.size(); ++j) previous[j] = j;
+    for (size_t i = 1; i <= left.size(); ++i)
+    {
+        current[0] = i;
+        for (size_t j = 1; j <= right.size(); ++j)
+        {
+            current[j] = std::min({ previous[j] + 1, current[j - 1] + 1,
+                previous[j - 1] + (left[i - 1] == right[j - 1] ? 0 : 1) });
+        }
+        std::swap(previous, current);
+    }
+    return previous[right.size()];
+}
+
+/// \brief CRC by polynomial long division over the bits of the message.
+std::vector<bool> crc(const std::vector<uint8_t> &data,
+                      const std::vector<bool> &poly)
+{
+    const size_t degree = poly.size() - 1;
+    std::vector<bool> bits;
+    for (uint8_t byte : data)
+    {
+        for (int bit = 7; bit >= 0; --bit)
+        {
+            bits.push_back((byte >> bit) & 1);
+        }
+    }
+    bits.resize(bits.size() + degree, false);
+    for (size_t i = 0; i + degree < bits.size(); ++i)
+    {
+        if (!bits[i]) continue;
+        for (size_t j = 0; j < poly.size(); ++j)
+        {
+            bits[i + j] = bits[i + j] ^ poly[j];
+        }
+    }
+    return std::vector<bool>(bits.end() - degree, bits.end());
+}
+
+/// \brief One generation of an elementary cellular automaton, which
+/// grows by a cell on each side.
+std::vector<bool> next_generation(uint8_t rule,
+                                  const std::vector<bool> &state)
+{
+    const size_t size = state.size();
+    std::vector<bool> next(size + 2);
+    unsigned window = 0;
+    for (size_t i = 0; i < size + 2; ++i)
+    {
+        window = ((window << 1) | (i < size && state[i])) & 7;
+        next[i] = (rule >> window) & 1;
+    }
+    return next;
+}
+
+/// \brief Newton's method with the derivative given.
+template <class F, class D>
+double newton_raphson(F f, D dfdx, double x, size_t maxiter, double epsilon)
+{
+    for (size_t i = 0; i < maxiter && std::abs(f(x)) > epsilon; ++i)
+    {
+        x -= f(x)/dfdx(x);
+    }
+    return x;
+}
+
+} // namespace baseline
+
+namespace
+{
+
+namespace bench = lambda::bench;
+
+std::string random_string(std::mt19937 &gen, size_t length)
+{
+    std::uniform_int_distribution<int> letter('a', 'd');
+    std::string s(length, ' ');
+    for (char &c : s) c = letter(gen);
+    return s;
+}
+
+void edit_distance(std::mt19937 &gen)
+{
+    for (size_t n : { 16, 128, 1024 })
+    {
+        const std::string a = random_string(gen, n);
+        const std::string b = random_string(gen, n);
+        const size_t iterations = 20000000/(n*n) + 1;
+        const std::string size = std::to_string(n);
+        size_t d = 0;
+
+        double lambda_ns = bench::measure([&] ()
+        {
+            d = lambda::levenshtein(a, b);
+            bench::do_not_optimize(d);
+        }, iterations);
+        bench::report("levenshtein, lambda, " + size, lambda_ns, 2*n);
+
+        double baseline_ns = bench::measure([&] ()
+        {
+            d = baseline::levenshtein(a, b);
+            bench::do_not_optimize(d);
+        }, iterations);
+        bench::report("levenshtein, baseline, " + size, baseline_ns, 2*n);
+    }
+}
+
+void checksum(std::mt19937 &gen)
+{
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<uint8_t> data(4096);
+    for (uint8_t &b : data) b = byte(gen);
+
+    std::vector<bool> poly;
+    for (int bit = 32; bit >= 0; --bit)
+    {
+        poly.push_back((0x104C11DB7ull >> bit) & 1);
+    }
+    const size_t iterations = 1000;
+    std::vector<bool> result;
+
+    double lambda_ns = bench::measure([&] ()
+    {
+        result = lambda::crc(data, poly);
+        bench::do_not_optimize(result);
+    }, iterations);
+    bench::report("crc32, lambda, 4 KiB", lambda_ns, data.size());
+
+    double baseline_ns = bench::measure([&] ()
+    {
+        result = baseline::crc(data, poly);
+        bench::do_not_optimize(result);
+    }, iterations/10);
+    bench::report("crc32, baseline, 4 KiB", baseline_ns, data.size());
+}
+
+void automaton(std::mt19937 &gen)
+{
+    std::bernoulli_distribution alive(0.5);
+    std::vector<bool> state(10000);
+    for (size_t i = 0; i < state.size(); ++i) state[i] = alive(gen);
+    const size_t iterations = 1000;
+    std::vector<bool> next;
+
+    double lambda_ns = bench::measure([&] ()
+    {
+        next = lambda::next_generation(30, state);
+        bench::do_not_optimize(next);
+    }, iterations);
+    bench::report("next_generation, lambda, 10000 cells", lambda_ns);
+
+    double baseline_ns = bench::measure([&] ()
+    {
+        next = baseline::next_generation(30, state);
+        bench::do_not_optimize(next);
+    }, iterations);
+    bench::report("next_generation, baseline, 10000 cells", baseline_ns);
+}
+
+void root_finding()
+{
+    auto f = [] (double x) { return x*x*x - 2*x - 5; };
+    auto dfdx = [] (double x) { return 3*x*x - 2; };
+    const size_t iterations = 100000;
+    double root = 0;
+
+    double lambda_ns = bench::measure([&] ()
+    {
+        root = lambda::newton_raphson(f, 2, 1000, 1e-12);
+        bench::do_not_optimize(root);
+    }, iterations);
+    bench::report("newton_raphson, lambda", lambda_ns);
+
+    double baseline_ns = bench::measure([&] ()
+    {
+        root = baseline::newton_raphson(f, dfdx, 2, 1000, 1e-12);
+        bench::do_not_optimize(root);
+    }, iterations);
+    bench::report("newton_raphson, baseline", baseline_ns);
+}
+
+} // namespace
+
+namespace lambda
+{
+
+namespace bench
+{
+
+void algorithm_benchmarks(std::mt19937 &gen)
+{
+    edit_distance(gen);
+    checksum(gen);
+    automaton(gen);
+    root_finding();
+}
+
+} // namespace bench
+
+} // namespace lambda
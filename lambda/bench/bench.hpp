@@ -0,0 +1,123 @@
+#ifndef LAMBDA_BENCH_HPP
+#define LAMBDA_BENCH_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/*!
+    \file
+    \brief A minimal timing harness for lambda benchmarks. Results are
+    printed as they are measured, and can be written as JSON at the end
+    of the run for tracking over time.
+*/
+
+namespace lambda
+{
+
+namespace bench
+{
+
+/// \brief Prevent the compiler from optimizing away a value.
+template <class T> void do_not_optimize(const T &value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+/// \brief Run a function repeatedly, and get the mean time taken
+/// per call in nanoseconds.
+template <class F> double measure(F &&f, size_t iterations)
+{
+    for (size_t i = 0; i < iterations/10 + 1; ++i) f();
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) f();
+    auto stop = std::chrono::steady_clock::now();
+
+    std::chrono::duration<double, std::nano> elapsed = stop - start;
+    return elapsed.count() / iterations;
+}
+
+/// \brief The measurements of one benchmark. bytes_per_op and
+/// flops_per_op are the memory traffic and floating point operations
+/// counted for one call; zero when they are not meaningful.
+struct result
+{
+    std::string name;
+    double ns_per_op;
+    double bytes_per_op;
+    double flops_per_op;
+};
+
+/// \brief Every result reported so far.
+inline std::vector<result>& results()
+{
+    static std::vector<result> all;
+    return all;
+}
+
+/// \brief Print the result of a benchmark, and record it.
+inline void report(const std::string &name, double ns_per_op,
+                   double bytes_per_op = 0, double flops_per_op = 0)
+{
+    results().push_back({ name, ns_per_op, bytes_per_op, flops_per_op });
+
+    std::cout << std::left << std::setw(48) << name
+        << std::right << std::fixed << std::setprecision(1)
+        << std::setw(12) << ns_per_op << " ns/op";
+    if (flops_per_op > 0)
+    {
+        std::cout << std::setw(10) << flops_per_op/ns_per_op << " GFLOP/s";
+    }
+    std::cout << std::endl;
+}
+
+/// \brief Write every recorded result as JSON, as an array of objects
+/// with the fields name, ns_per_op, bytes_per_op and gflops; the last
+/// two are null when they were not counted.
+inline void write_json(std::ostream &os)
+{
+    os << "{\n  \"benchmarks\": [";
+    const char *separator = "\n";
+    for (const result &r : results())
+    {
+        os << separator << "    {\"name\": \"";
+        for (char c : r.name)
+        {
+            if (c == '"' || c == '\\') os << '\\';
+            os << c;
+        }
+        os << "\", \"ns_per_op\": " << std::setprecision(6)
+            << std::defaultfloat << r.ns_per_op << ", \"bytes_per_op\": ";
+        if (r.bytes_per_op > 0) os << r.bytes_per_op;
+        else os << "null";
+        os << ", \"gflops\": ";
+        if (r.flops_per_op > 0) os << r.flops_per_op/r.ns_per_op;
+        else os << "null";
+        os << "}";
+        separator = ",\n";
+    }
+    os << "\n  ]\n}\n";
+}
+
+/// \brief Static and batched matrix operations, and kalman filtering,
+/// against naive baselines; see matrix_bench.cpp.
+void matrix_benchmarks(std::mt19937 &gen);
+
+/// \brief Static and dynamic matrices and kalman filtering against
+/// Eigen; see eigen_bench.cpp.
+void eigen_benchmarks(std::mt19937 &gen);
+
+/// \brief levenshtein, crc, next_generation and newton_raphson against
+/// naive baselines; see algorithm_bench.cpp.
+void algorithm_benchmarks(std::mt19937 &gen);
+
+} // namespace bench
+
+} // namespace lambda
+
+#endif // LAMBDA_BENCH_HPP
@@ -0,0 +1,599 @@
+#include <lambda/lambda.hpp>
+
+#include "bench.hpp"
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+/// \brief Fills a lambda matrix and an Eigen matrix with the same random
+/// elements, plus a multiple of the identity to keep them well
+/// conditioned.
+template <size_t N, class E>
+void random_pair(std::mt19937 &gen, lambda::matrix<N, N> &m, E &e,
+                 double diagonal = 0)
+{
+    std::uniform_real_distribution<double> dist(-1, 1);
+    for (size_t i = 0; i < N; ++i)
+    {
+        for (size_t j = 0; j < N; ++j)
+        {
+            m(i, j) = dist(gen) + (i == j ? diagonal : 0);
+            e(i, j) = m(i, j);
+        }
+    }
+}
+
+/// \brief Multiplication, determinant and inverse of NxN matrices.
+template <size_t N> void static_matrix(std::mt19937 &gen)
+{
+    using namespace lambda;
+    using eigen_matrix = Eigen::Matrix<double, N, N>;
+
+    matrix<N, N> A, B, C;
+    eigen_matrix eA, eB, eC;
+    random_pair(gen, A, eA, 4.0);
+    random_pair(gen, B, eB, 4.0);
+    double d = 0;
+
+    const size_t iterations = 20000000/(N*N*N);
+    const std::string size = std::to_string(N) + "x" + std::to_string(N);
+    const double element = sizeof(double);
+    const double multiply_flops = 2*N*N*N, lu_flops = 2*N*N*N/3.0;
+
+    double multiply_ns = bench::measure([&] ()
+    {
+        C = A * B;
+        bench::do_not_optimize(C);
+    }, iterations);
+    bench::report("A*B, lambda, " + size, multiply_ns,
+                  3*N*N*element, multiply_flops);
+
+    double eigen_multiply_ns = bench::measure([&] ()
+    {
+        eC.noalias() = eA * eB;
+        bench::do_not_optimize(eC);
+    }, iterations);
+    bench::report("A*B, Eigen, " + size, eigen_multiply_ns,
+                  3*N*N*element, multiply_flops);
+
+    double det_ns = bench::measure([&] ()
+    {
+        d = det(A);
+        bench::do_not_optimize(d);
+    }, iterations);
+    bench::report("det(A), lambda, " + size, det_ns, N*N*element, lu_flops);
+
+    double eigen_det_ns = bench::measure([&] ()
+    {
+        d = eA.determinant();
+        bench::do_not_optimize(d);
+    }, iterations);
+    bench::report("det(A), Eigen, " + size, eigen_det_ns,
+                  N*N*element, lu_flops);
+
+    double inverse_ns = bench::measure([&] ()
+    {
+        C = inverse(A);
+        bench::do_not_optimize(C);
+    }, iterations);
+    bench::report("inverse(A), lambda, " + size, inverse_ns,
+                  2*N*N*element, 3*lu_flops);
+
+    double eigen_inverse_ns = bench::measure([&] ()
+    {
+        eC = eA.inverse();
+        bench::do_not_optimize(eC);
+    }, iterations);
+    bench::report("inverse(A), Eigen, " + size, eigen_inverse_ns,
+                  2*N*N*element, 3*lu_flops);
+}
+
+template <size_t... N>
+void static_matrices(std::mt19937 &gen, std::index_sequence<N...>)
+{
+    (static_matrix<N + 2>(gen), ...);
+}
+
+/// \brief Multiplication of large, dynamically sized matrices, into a
+/// new matrix and in place with gemm.
+void dynamic_matrices(std::mt19937 &gen)
+{
+    using namespace lambda;
+
+    std::uniform_real_distribution<double> dist(-1, 1);
+    for (size_t n : { 64, 128, 256, 1024 })
+    {
+        std::vector<double> a(n*n), b(n*n);
+        for (double &x : a) x = dist(gen);
+        for (double &x : b) x = dist(gen);
+        const dynamic_matrix A(n, n, a), B(n, n, b);
+        const Eigen::MatrixXd eA = Eigen::Map<Eigen::Matrix<double,
+            Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>(a.data(), n, n);
+        const Eigen::MatrixXd eB = Eigen::Map<Eigen::Matrix<double,
+            Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>(b.data(), n, n);
+        Eigen::MatrixXd eC(n, n);
+        dynamic_matrix C(n, n);
+
+        const size_t iterations = 50000000/(n*n*n) + 1;
+        const std::string size = std::to_string(n) + "x" + std::to_string(n);
+        const double bytes = 3.0*n*n*sizeof(double), flops = 2.0*n*n*n;
+
+        double multiply_ns = bench::measure([&] ()
+        {
+            dynamic_matrix C = A * B;
+            bench::do_not_optimize(C);
+        }, iterations);
+        bench::report("A*B, lambda dynamic, " + size, multiply_ns,
+                      bytes, flops);
+
+        double gemm_ns = bench::measure([&] ()
+        {
+            gemm(1, A, B, 0, C);
+            bench::do_not_optimize(C);
+        }, iterations);
+        bench::report("gemm, lambda dynamic, " + size, gemm_ns,
+                      bytes, flops);
+
+        double eigen_multiply_ns = bench::measure([&] ()
+        {
+            eC.noalias() = eA * eB;
+            bench::do_not_optimize(eC);
+        }, iterations);
+        bench::report("A*B, Eigen dynamic, " + size, eigen_multiply_ns,
+                      bytes, flops);
+    }
+}
+
+/// \brief LU, Cholesky and QR factorization of large, dynamically sized
+/// matrices.
+void dynamic_factorizations(std::mt19937 &gen)
+{
+    using namespace lambda;
+
+    std::uniform_real_distribution<double> dist(-1, 1);
+    for (size_t n : { 256, 2000 })
+    {
+        std::vector<double> a(n*n);
+        for (double &x : a) x = dist(gen);
+        const dynamic_matrix A(n, n, a);
+        const Eigen::MatrixXd eA = Eigen::Map<Eigen::Matrix<double,
+            Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>(a.data(), n, n);
+        dynamic_matrix S(n, n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t j = 0; j < n; ++j) S(i, j) = A(i, j) + A(j, i);
+            S(i, i) += 3.0*n;
+        }
+        const Eigen::MatrixXd eS = Eigen::Map<const Eigen::Matrix<double,
+            Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>(
+            S.data().data(), n, n);
+
+        const size_t iterations = 500000000/(n*n*n) + 1;
+        const std::string size = std::to_string(n) + "x" + std::to_string(n);
+        const double bytes = 1.0*n*n*sizeof(double), cube = 1.0*n*n*n;
+
+        double lu_ns = bench::measure([&] ()
+        {
+            dynamic_lu lu(A);
+            bench::do_not_optimize(lu);
+        }, iterations);
+        bench::report("LU, lambda dynamic, " + size, lu_ns,
+                      bytes, 2*cube/3);
+
+        double eigen_lu_ns = bench::measure([&] ()
+        {
+            Eigen::PartialPivLU<Eigen::MatrixXd> lu(eA);
+            bench::do_not_optimize(lu);
+        }, iterations);
+        bench::report("LU, Eigen dynamic, " + size, eigen_lu_ns,
+                      bytes, 2*cube/3);
+
+        double cholesky_ns = bench::measure([&] ()
+        {
+            dynamic_cholesky cholesky(S);
+            bench::do_not_optimize(cholesky);
+        }, iterations);
+        bench::report("Cholesky, lambda dynamic, " + size, cholesky_ns,
+                      bytes, cube/3);
+
+        double eigen_cholesky_ns = bench::measure([&] ()
+        {
+            Eigen::LLT<Eigen::MatrixXd> cholesky(eS);
+            bench::do_not_optimize(cholesky);
+        }, iterations);
+        bench::report("Cholesky, Eigen dynamic, " + size, eigen_cholesky_ns,
+                      bytes, cube/3);
+
+        double qr_ns = bench::measure([&] ()
+        {
+            dynamic_qr qr(A);
+            bench::do_not_optimize(qr);
+        }, iterations);
+        bench::report("QR, lambda dynamic, " + size, qr_ns,
+                      bytes, 4*cube/3);
+
+        double eigen_qr_ns = bench::measure([&] ()
+        {
+            Eigen::HouseholderQR<Eigen::MatrixXd> qr(eA);
+            bench::do_not_optimize(qr);
+        }, iterations);
+        bench::report("QR, Eigen dynamic, " + size, eigen_qr_ns,
+                      bytes, 4*cube/3);
+    }
+}
+
+/// \brief The kalman filter of lambda::kalman_filter, written with
+/// Eigen.
+template <int M, int N> struct eigen_kalman_filter
+{
+    Eigen::Matrix<double, N, 1> state;
+    Eigen::Matrix<double, N, N> state_covariance;
+    Eigen::Matrix<double, N, N> state_transition;
+    Eigen::Matrix<double, M, N> measurement_model;
+    Eigen::Matrix<double, M, M> sensor_noise;
+    Eigen::Matrix<double, N, N> process_noise;
+
+    void predict()
+    {
+        state = state_transition * state;
+        state_covariance = state_transition * state_covariance *
+            state_transition.transpose() + process_noise;
+    }
+
+    void update(const Eigen::Matrix<double, M, 1> &meas)
+    {
+        const Eigen::Matrix<double, M, 1> residual =
+            meas - measurement_model * state;
+        const Eigen::Matrix<double, M, M> innovation_covariance =
+            sensor_noise + measurement_model * state_covariance *
+            measurement_model.transpose();
+        const Eigen::Matrix<double, N, M> kalman_gain = state_covariance *
+            measurement_model.transpose() * innovation_covariance.inverse();
+        state += kalman_gain * residual;
+        state_covariance = (Eigen::Matrix<double, N, N>::Identity() -
+            kalman_gain * measurement_model) * state_covariance;
+    }
+};
+
+/// \brief One predict and update of a filter with N states and M
+/// measurements. Each call starts from the same filter, so the
+/// covariances do not drift over the run.
+template <size_t M, size_t N> void kalman(std::mt19937 &gen)
+{
+    using namespace lambda;
+
+    matrix<N, N> F;
+    Eigen::Matrix<double, N, N> eF;
+    random_pair(gen, F, eF, 1.0);
+    F *= 0.5;
+    eF *= 0.5;
+
+    std::uniform_real_distribution<double> dist(-1, 1);
+    matrix<M, N> H;
+    Eigen::Matrix<double, M, N> eH;
+    column_vector<N> x;
+    Eigen::Matrix<double, N, 1> ex;
+    column_vector<M> z;
+    Eigen::Matrix<double, M, 1> ez;
+    for (size_t i = 0; i < M*N; ++i) eH(i / N, i % N) = H[i] = dist(gen);
+    for (size_t i = 0; i < N; ++i) ex(i) = x[i] = dist(gen);
+    for (size_t i = 0; i < M; ++i) ez(i) = z[i] = dist(gen);
+
+    const kalman_filter<M, N> filter(x, identity<N, N>(), F, H,
+        identity<M, M>()*0.1, identity<N, N>()*0.01);
+    eigen_kalman_filter<M, N> eigen_filter{ ex,
+        Eigen::Matrix<double, N, N>::Identity(), eF, eH,
+        Eigen::Matrix<double, M, M>::Identity()*0.1,
+        Eigen::Matrix<double, N, N>::Identity()*0.01 };
+
+    const size_t iterations = 20000000/(N*N*N);
+    const std::string size = std::to_string(M) + "x" + std::to_string(N);
+
+    double lambda_ns = bench::measure([&] ()
+    {
+        kalman_filter<M, N> f = filter;
+        f.predict();
+        f.update(z);
+        bench::do_not_optimize(f);
+    }, iterations);
+    bench::report("kalman predict+update, lambda, " + size, lambda_ns);
+
+    double eigen_ns = bench::measure([&] ()
+    {
+        eigen_kalman_filter<M, N> f = eigen_filter;
+        f.predict();
+        f.update(ez);
+        bench::do_not_optimize(f);
+    }, iterations);
+    bench::report("kalman predict+update, Eigen, " + size, eigen_ns);
+}
+
+/// \brief SVD of NxN matrices by one-sided Jacobi, against Eigen's
+/// JacobiSVD; for 3x3, also the fast SVD, one matrix at a time and
+/// batched.
+template <size_t N> void singular_value_decomposition(std::mt19937 &gen)
+{
+    using namespace lambda;
+    using eigen_matrix = Eigen::Matrix<double, N, N>;
+
+    matrix<N, N> A, U, S, V_star;
+    eigen_matrix eA;
+    random_pair(gen, A, eA);
+
+    const size_t iterations = 2000000/(N*N*N);
+    const std::string size = std::to_string(N) + "x" + std::to_string(N);
+
+    double svd_ns = bench::measure([&] ()
+    {
+        std::tie(U, S, V_star) = svd(A);
+        bench::do_not_optimize(U);
+        bench::do_not_optimize(S);
+        bench::do_not_optimize(V_star);
+    }, iterations);
+    bench::report("svd(A), lambda, " + size, svd_ns);
+
+    double eigen_svd_ns = bench::measure([&] ()
+    {
+        Eigen::JacobiSVD<eigen_matrix> svd(eA,
+            Eigen::ComputeFullU | Eigen::ComputeFullV);
+        bench::do_not_optimize(svd);
+    }, iterations);
+    bench::report("svd(A), Eigen JacobiSVD, " + size, eigen_svd_ns);
+
+    if constexpr (N == 3)
+    {
+        double fast_ns = bench::measure([&] ()
+        {
+            std::tie(U, S, V_star) = fast_svd(A);
+            bench::do_not_optimize(U);
+            bench::do_not_optimize(S);
+            bench::do_not_optimize(V_star);
+        }, iterations);
+        bench::report("fast_svd(A), lambda, " + size, fast_ns);
+
+        const size_t count = 4096;
+        std::vector<matrix<3, 3>> mats(count);
+        std::uniform_real_distribution<double> dist(-1, 1);
+        for (auto &m : mats)
+        {
+            for (size_t i = 0; i < 9; ++i) m[i] = dist(gen);
+        }
+        const matrix_batch<3, 3> batch(mats);
+        double batch_ns = bench::measure([&] ()
+        {
+            auto result = fast_svd(batch);
+            bench::do_not_optimize(result);
+        }, iterations/count + 1);
+        bench::report("fast_svd, lambda batch, per matrix, " + size,
+                      batch_ns/count);
+    }
+}
+
+/// \brief Overdetermined MxN least squares, by QR, by the normal
+/// equations, and batched.
+template <size_t M, size_t N> void least_squares_fit(std::mt19937 &gen)
+{
+    using namespace lambda;
+
+    std::uniform_real_distribution<double> dist(-1, 1);
+    matrix<M, N> A;
+    column_vector<M> b;
+    column_vector<N> x;
+    Eigen::Matrix<double, M, N> eA;
+    Eigen::Matrix<double, M, 1> eb;
+    Eigen::Matrix<double, N, 1> ex;
+    for (size_t i = 0; i < M; ++i)
+    {
+        for (size_t j = 0; j < N; ++j)
+        {
+            eA(i, j) = A(i, j) = dist(gen);
+        }
+        eb(i) = b[i] = dist(gen);
+    }
+
+    const size_t iterations = 2000000/(M*N*N);
+    const std::string size = std::to_string(M) + "x" + std::to_string(N);
+
+    double qr_ns = bench::measure([&] ()
+    {
+        x = least_squares(A, b);
+        bench::do_not_optimize(x);
+    }, iterations);
+    bench::report("least_squares(A, b), lambda, " + size, qr_ns);
+
+    double normal_ns = bench::measure([&] ()
+    {
+        const matrix<N, M> At = transpose(A);
+        x = cholesky_factorization<N>(At*A).solve(matrix<N, 1>(At*b));
+        bench::do_not_optimize(x);
+    }, iterations);
+    bench::report("normal equations, lambda Cholesky, " + size, normal_ns);
+
+    double eigen_ns = bench::measure([&] ()
+    {
+        ex = eA.householderQr().solve(eb);
+        bench::do_not_optimize(ex);
+    }, iterations);
+    bench::report("least squares, Eigen HouseholderQR, " + size, eigen_ns);
+
+    const size_t count = 4096;
+    std::vector<matrix<M, N>> mats(count);
+    std::vector<column_vector<M>> vectors(count);
+    for (size_t k = 0; k < count; ++k)
+    {
+        for (size_t i = 0; i < M*N; ++i) mats[k][i] = dist(gen);
+        for (size_t i = 0; i < M; ++i) vectors[k][i] = dist(gen);
+    }
+    const matrix_batch<M, N> batch_A(mats);
+    const vector_batch<M> batch_b(vectors);
+    double batch_ns = bench::measure([&] ()
+    {
+        auto result = least_squares(batch_A, batch_b);
+        bench::do_not_optimize(result);
+    }, iterations/count + 1);
+    bench::report("least_squares, lambda batch, per system, " + size,
+                  batch_ns/count);
+}
+
+/// \brief Gets the largest element of |AV - V diag(lambda)|, over the
+/// largest element of |A|, for an eigendecomposition of A.
+template <size_t N, class V, class W>
+double eigen_residual(const lambda::matrix<N, N> &a, const V &values,
+                      const W &vectors)
+{
+    double residual = 0, scale = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        for (size_t j = 0; j < N; ++j)
+        {
+            double sum = -vectors(i, j)*values[j];
+            for (size_t k = 0; k < N; ++k)
+            {
+                sum += a(i, k)*vectors(k, j);
+            }
+            residual = std::max(residual, std::abs(sum));
+            scale = std::max(scale, std::abs(a(i, j)));
+        }
+    }
+    return residual/scale;
+}
+
+/// \brief Eigendecomposition of NxN symmetric matrices, with the largest
+/// relative residual of each method over a set of random matrices.
+template <size_t N> void symmetric_eigendecomposition(std::mt19937 &gen)
+{
+    using namespace lambda;
+    using eigen_matrix = Eigen::Matrix<double, N, N>;
+
+    const size_t count = 1000;
+    std::uniform_real_distribution<double> dist(-1, 1);
+    std::vector<matrix<N, N>> mats(count);
+    std::vector<eigen_matrix> eigen_mats(count);
+    for (size_t k = 0; k < count; ++k)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            for (size_t j = 0; j <= i; ++j)
+            {
+                mats[k](i, j) = mats[k](j, i) = dist(gen);
+                eigen_mats[k](i, j) = eigen_mats[k](j, i) = mats[k](i, j);
+            }
+        }
+    }
+
+    const size_t iterations = 2000000/(N*N*N);
+    const std::string size = std::to_string(N) + "x" + std::to_string(N);
+    column_vector<N> values;
+    matrix<N, N> vectors;
+    size_t next = 0;
+
+    double jacobi_ns = bench::measure([&] ()
+    {
+        std::tie(values, vectors) = symmetric_eigen(mats[next]);
+        next = (next + 1) % count;
+        bench::do_not_optimize(values);
+        bench::do_not_optimize(vectors);
+    }, iterations);
+    bench::report("symmetric_eigen(A), lambda, " + size, jacobi_ns);
+
+    Eigen::SelfAdjointEigenSolver<eigen_matrix> solver;
+    double eigen_ns = bench::measure([&] ()
+    {
+        solver.compute(eigen_mats[next]);
+        next = (next + 1) % count;
+        bench::do_not_optimize(solver);
+    }, iterations);
+    bench::report("SelfAdjointEigenSolver, Eigen, " + size, eigen_ns);
+
+    double residual = 0, eigen_residual_max = 0, fast_residual = 0,
+        direct_residual = 0;
+    for (size_t k = 0; k < count; ++k)
+    {
+        std::tie(values, vectors) = symmetric_eigen(mats[k]);
+        residual = std::max(residual,
+                            eigen_residual(mats[k], values, vectors));
+        solver.compute(eigen_mats[k]);
+        eigen_residual_max = std::max(eigen_residual_max,
+            eigen_residual(mats[k], solver.eigenvalues(),
+                           solver.eigenvectors()));
+    }
+
+    if constexpr (N == 3)
+    {
+        double fast_ns = bench::measure([&] ()
+        {
+            std::tie(values, vectors) = fast_symmetric_eigen(mats[next]);
+            next = (next + 1) % count;
+            bench::do_not_optimize(values);
+            bench::do_not_optimize(vectors);
+        }, iterations);
+        bench::report("fast_symmetric_eigen(A), lambda, " + size, fast_ns);
+
+        double direct_ns = bench::measure([&] ()
+        {
+            solver.computeDirect(eigen_mats[next]);
+            next = (next + 1) % count;
+            bench::do_not_optimize(solver);
+        }, iterations);
+        bench::report("SelfAdjointEigenSolver direct, Eigen, " + size,
+                      direct_ns);
+
+        for (size_t k = 0; k < count; ++k)
+        {
+            std::tie(values, vectors) = fast_symmetric_eigen(mats[k]);
+            fast_residual = std::max(fast_residual,
+                eigen_residual(mats[k], values, vectors));
+            solver.computeDirect(eigen_mats[k]);
+            direct_residual = std::max(direct_residual,
+                eigen_residual(mats[k], solver.eigenvalues(),
+                               solver.eigenvectors()));
+        }
+    }
+
+    std::cout << "  largest relative residual |AV - V diag(lambda)|, "
+        << size << ": lambda " << std::scientific << std::setprecision(1)
+        << residual << ", Eigen " << eigen_residual_max;
+    if constexpr (N == 3)
+    {
+        std::cout << ", lambda fast " << fast_residual
+            << ", Eigen direct " << direct_residual;
+    }
+    std::cout << std::defaultfloat << std::endl;
+}
+
+} // namespace
+
+namespace lambda
+{
+
+namespace bench
+{
+
+void eigen_benchmarks(std::mt19937 &gen)
+{
+    static_matrices(gen, std::make_index_sequence<11>());
+    dynamic_matrices(gen);
+    dynamic_factorizations(gen);
+    kalman<2, 4>(gen);
+    kalman<3, 9>(gen);
+    kalman<6, 18>(gen);
+    singular_value_decomposition<3>(gen);
+    singular_value_decomposition<6>(gen);
+    least_squares_fit<12, 4>(gen);
+    least_squares_fit<30, 6>(gen);
+    symmetric_eigendecomposition<3>(gen);
+    symmetric_eigendecomposition<6>(gen);
+}
+
+} // namespace bench
+
+} // namespace lambda
@@ -0,0 +1,63 @@
+#include "bench.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const std::map<std::string, void (*)(std::mt19937&)> suites = {
+    { "matrix", lambda::bench::matrix_benchmarks },
+    { "eigen", lambda::bench::eigen_benchmarks },
+    { "algorithms", lambda::bench::algorithm_benchmarks },
+};
+
+int usage(const char *program)
+{
+    std::cerr << "usage: " << program << " [--json FILE] [SUITE...]\n"
+        << "suites:";
+    for (const auto &suite : suites) std::cerr << " " << suite.first;
+    std::cerr << std::endl;
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string json;
+    std::vector<std::string> selected;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc) json = argv[++i];
+        else if (suites.count(arg)) selected.push_back(arg);
+        else return usage(argv[0]);
+    }
+    if (selected.empty())
+    {
+        for (const auto &suite : suites) selected.push_back(suite.first);
+    }
+
+    std::mt19937 gen(0);
+    for (const std::string &name : selected)
+    {
+        suites.at(name)(gen);
+    }
+
+    if (!json.empty())
+    {
+        std::ofstream out(json);
+        lambda::bench::write_json(out);
+        if (!out)
+        {
+            std::cerr << "Cannot write results to " << json << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,641 @@
+#include <lambda/lambda.hpp>
+
+#include "bench.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace eager
+{
+
+// The eager operators lambda::matrix used before expression templates,
+// kept here as a baseline. Each returns a new matrix.
+
+template <size_t M, size_t N>
+lambda::matrix<M, N> add(const lambda::matrix<M, N> &left,
+                         const lambda::matrix<M, N> &right)
+{
+    lambda::matrix<M, N> ret;
+    for (size_t i = 0; i < M; ++i)
+    {
+        for (size_t j = 0; j < N; ++j)
+        {
+            ret(i, j) = left(i, j) + right(i, j);
+        }
+    }
+    return ret;
+}
+
+template <size_t M, size_t N, size_t P>
+lambda::matrix<M, P> multiply(const lambda::matrix<M, N> &left,
+                              const lambda::matrix<N, P> &right)
+{
+    lambda::matrix<M, P> ret;
+    for (size_t i = 0; i < M; ++i)
+    {
+        for (size_t j = 0; j < P; ++j)
+        {
+            double sum = 0;
+            for (size_t k = 0; k < N; ++k)
+            {
+                sum += left(i, k) * right(k, j);
+            }
+            ret(i, j) = sum;
+        }
+    }
+    return ret;
+}
+
+template <size_t M, size_t N>
+lambda::matrix<N, M> transpose(const lambda::matrix<M, N> &m)
+{
+    lambda::matrix<N, M> ret;
+    for (size_t i = 0; i < M; ++i)
+    {
+        for (size_t j = 0; j < N; ++j)
+        {
+            ret(j, i) = m(i, j);
+        }
+    }
+    return ret;
+}
+
+// Determinant by cofactor expansion, and inverse by reducing [A | I],
+// as lambda::det and lambda::inverse were before LU factorization.
+
+template <size_t N> double cofactor_det(const lambda::matrix<N, N> &m)
+{
+    double sum = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        lambda::matrix<N-1, N-1> sub;
+        for (size_t r = 1; r < N; ++r)
+        {
+            size_t j = 0;
+            for (size_t c = 0; c < N - 1; ++c, ++j)
+            {
+                if (j == i) ++j;
+                sub(r - 1, c) = m(r, j);
+            }
+        }
+        double d = m(0, i) * cofactor_det(sub);
+        sum += (i % 2 == 0 ? d : -d);
+    }
+    return sum;
+}
+
+template <> double cofactor_det(const lambda::matrix<1, 1> &m)
+{
+    return m[0];
+}
+
+template <size_t N>
+lambda::matrix<N, N> rref_inverse(const lambda::matrix<N, N> &m)
+{
+    auto reduced = lambda::rref(lambda::augment(m, lambda::identity<N, N>()));
+    lambda::matrix<N, N> inv;
+    for (size_t r = 0; r < N; ++r)
+    {
+        for (size_t c = 0; c < N; ++c)
+        {
+            inv(r, c) = reduced(r, N + c);
+        }
+    }
+    return inv;
+}
+
+} // namespace eager
+
+template <size_t N> lambda::matrix<N, N> random_matrix(std::mt19937 &gen)
+{
+    std::uniform_real_distribution<double> dist(-1, 1);
+    lambda::matrix<N, N> m;
+    for (size_t i = 0; i < N*N; ++i) m[i] = dist(gen);
+    return m;
+}
+
+/// \brief Covariance propagation, F*P*F^T + Q, as done by
+/// lambda::kalman_filter::predict().
+template <size_t N> void covariance_propagation(std::mt19937 &gen)
+{
+    using namespace lambda;
+
+    const auto F = random_matrix<N>(gen);
+    const auto Q = random_matrix<N>(gen);
+    const auto P = random_matrix<N>(gen);
+    lambda::matrix<N, N> result;
+    const size_t iterations = 2000000/(N*N*N);
+    const std::string size = std::to_string(N) + "x" + std::to_string(N);
+
+    double eager_ns = bench::measure([&] ()
+    {
+        result = eager::add(eager::multiply(eager::multiply(F, P),
+            eager::transpose(F)), Q);
+        bench::do_not_optimize(result);
+    }, iterations);
+    bench::report("F*P*F^T + Q, eager, " + size, eager_ns);
+
+    double fused_ns = bench::measure([&] ()
+    {
+        result = F * P * transpose(F) + Q;
+        bench::do_not_optimize(result);
+    }, iterations);
+    bench::report("F*P*F^T + Q, fused, " + size, fused_ns);
+
+    const symmetric_matrix<N> Ps(P), Qs(Q);
+    symmetric_matrix<N> packed;
+    double packed_ns = bench::measure([&] ()
+    {
+        packed = symmetric_product(F, Ps) + Qs;
+        bench::do_not_optimize(packed);
+    }, iterations);
+    bench::report("F*P*F^T + Q, packed, " + size, packed_ns);
+}
+
+/// \brief Multiplication of an NxN matrix by an NxN matrix and by an
+/// N-vector, through lambda::kernels.
+template <size_t N> void multiplication(std::mt19937 &gen)
+{
+    using namespace lambda;
+
+    const auto A = random_matrix<N>(gen);
+    const auto B = random_matrix<N>(gen);
+    const column_vector<N> x = B * column_vector<N>();
+    matrix<N, N> C;
+    column_vector<N> y;
+    const size_t iterations = 10000000/(N*N*N);
+    const std::string size = std::to_string(N) + "x" + std::to_string(N);
+    const double bytes = 3*N*N*sizeof(double), flops = 2*N*N*N;
+    const double vec_bytes = (N*N + 2*N)*sizeof(double), vec_flops = 2*N*N;
+
+    double eager_ns = bench::measure([&] ()
+    {
+        C = eager::multiply(A, B);
+        bench::do_not_optimize(C);
+    }, iterations);
+    bench::report("A*B, eager, " + size, eager_ns, bytes, flops);
+
+    double kernel_ns = bench::measure([&] ()
+    {
+        C = A * B;
+        bench::do_not_optimize(C);
+    }, iterations);
+    bench::report("A*B, kernel, " + size, kernel_ns, bytes, flops);
+
+    double eager_vec_ns = bench::measure([&] ()
+    {
+        y = eager::multiply(A, x);
+        bench::do_not_optimize(y);
+    }, iterations*N);
+    bench::report("A*x, eager, " + size, eager_vec_ns,
+                  vec_bytes, vec_flops);
+
+    double kernel_vec_ns = bench::measure([&] ()
+    {
+        y = A * x;
+        bench::do_not_optimize(y);
+    }, iterations*N);
+    bench::report("A*x, kernel, " + size, kernel_vec_ns,
+                  vec_bytes, vec_flops);
+}
+
+/// \brief Determinant, inverse and linear solves of an NxN matrix, with
+/// the cofactor and row reduction baselines.
+template <size_t N> void factorization(std::mt19937 &gen)
+{
+    using namespace lambda;
+
+    const matrix<N, N> A = random_matrix<N>(gen) + 4.0*identity<N, N>();
+    matrix<N, N> inv;
+    double d = 0;
+    const size_t iterations = 10000000/(N*N*N);
+    const std::string size = std::to_string(N) + "x" + std::to_string(N);
+
+    if (N <= 8)
+    {
+        double cofactor_ns = bench::measure([&] ()
+        {
+            d = eager::cofactor_det(A);
+            bench::do_not_optimize(d);
+        }, N <= 6 ? iterations : 100);
+        bench::report("det(A), cofactor, " + size, cofactor_ns);
+    }
+
+    double det_ns = bench::measure([&] ()
+    {
+        d = det(A);
+        bench::do_not_optimize(d);
+    }, iterations);
+    bench::report("det(A), LU, " + size, det_ns);
+
+    double rref_ns = bench::measure([&] ()
+    {
+        inv = eager::rref_inverse(A);
+        bench::do_not_optimize(inv);
+    }, iterations);
+    bench::report("inverse(A), rref, " + size, rref_ns);
+
+    double inverse_ns = bench::measure([&] ()
+    {
+        inv = inverse(A, d);
+        bench::do_not_optimize(inv);
+        bench::do_not_optimize(d);
+    }, iterations);
+    bench::report("inverse(A) and det(A), LU, " + size, inverse_ns);
+
+    double invert_ns = bench::measure([&] ()
+    {
+        inv = A;
+        invert(inv);
+        bench::do_not_optimize(inv);
+    }, iterations);
+    bench::report("invert(A), Gauss-Jordan in place, " + size, invert_ns);
+
+    const column_vector<N> b = A * column_vector<N>();
+    column_vector<N> x;
+    double inverse_solve_ns = bench::measure([&] ()
+    {
+        x = inverse(A) * b;
+        bench::do_not_optimize(x);
+    }, iterations);
+    bench::report("inverse(A)*b, " + size, inverse_solve_ns);
+
+    double solve_ns = bench::measure([&] ()
+    {
+        x = solve(A, b);
+        bench::do_not_optimize(x);
+    }, iterations);
+    bench::report("solve(A, b), " + size, solve_ns);
+
+    const lu_factorization<N> lu(A);
+    double lu_solve_ns = bench::measure([&] ()
+    {
+        x = lu.solve(b);
+        bench::do_not_optimize(x);
+    }, iterations);
+    bench::report("lu.solve(b), factored once, " + size, lu_solve_ns);
+}
+
+/// \brief Discretization of a continuous-time model, exp(A dt), for a
+/// small and a large timestep, and a matrix power.
+template <size_t N> void exponential(std::mt19937 &gen)
+{
+    using namespace lambda;
+
+    const auto A = random_matrix<N>(gen);
+    matrix<N, N> F;
+    const size_t iterations = 10000000/(N*N*N*10);
+    const std::string size = std::to_string(N) + "x" + std::to_string(N);
+
+    for (double dt : { 0.01, 10.0 })
+    {
+        double expm_ns = bench::measure([&] ()
+        {
+            F = expm(matrix<N, N>(A * dt));
+            bench::do_not_optimize(F);
+        }, iterations);
+        bench::report("expm(A*" + std::to_string(dt).substr(0, 4) +
+            "), " + size, expm_ns);
+    }
+
+    double pow_ns = bench::measure([&] ()
+    {
+        F = pow(A, 100);
+        bench::do_not_optimize(F);
+    }, iterations);
+    bench::report("pow(A, 100), " + size, pow_ns);
+}
+
+/// \brief Operations over many 3-vectors and 3x3 matrices, as arrays of
+/// lambda::matrix and as a lambda::matrix_batch. Times are per matrix.
+void batched(std::mt19937 &gen)
+{
+    using namespace lambda;
+
+    const size_t K = 10000;
+    const size_t iterations = 200;
+    std::vector<matrix<3, 3>> rotations;
+    std::vector<column_vector<3>> points, others;
+    for (size_t k = 0; k < K; ++k)
+    {
+        rotations.push_back(random_matrix<3>(gen));
+        points.push_back(random_matrix<3>(gen) * unitx);
+        others.push_back(random_matrix<3>(gen) * unity);
+    }
+    const matrix_batch<3, 3> R(rotations);
+    const vector_batch<3> P(points), Q(others);
+    const matrix<3, 3> A = random_matrix<3>(gen);
+
+    std::vector<matrix<3, 3>> products(K);
+    std::vector<column_vector<3>> results(K);
+
+    double aos_multiply_ns = bench::measure([&] ()
+    {
+        for (size_t k = 0; k < K; ++k)
+        {
+            products[k] = rotations[k] * rotations[k];
+        }
+        bench::do_not_optimize(products);
+    }, iterations);
+    bench::report("R*R, array of matrices", aos_multiply_ns/K);
+
+    double soa_multiply_ns = bench::measure([&] ()
+    {
+        auto RR = R * R;
+        bench::do_not_optimize(RR);
+    }, iterations);
+    bench::report("R*R, matrix_batch", soa_multiply_ns/K);
+
+    double aos_rotate_ns = bench::measure([&] ()
+    {
+        for (size_t k = 0; k < K; ++k)
+        {
+            results[k] = A * points[k];
+        }
+        bench::do_not_optimize(results);
+    }, iterations);
+    bench::report("A*p, array of matrices", aos_rotate_ns/K);
+
+    double soa_rotate_ns = bench::measure([&] ()
+    {
+        auto AP = A * P;
+        bench::do_not_optimize(AP);
+    }, iterations);
+    bench::report("A*p, matrix_batch", soa_rotate_ns/K);
+
+    double aos_cross_ns = bench::measure([&] ()
+    {
+        for (size_t k = 0; k < K; ++k)
+        {
+            results[k] = cross_product(points[k], others[k]);
+        }
+        bench::do_not_optimize(results);
+    }, iterations);
+    bench::report("p x q, array of matrices", aos_cross_ns/K);
+
+    double soa_cross_ns = bench::measure([&] ()
+    {
+        auto PQ = cross_product(P, Q);
+        bench::do_not_optimize(PQ);
+    }, iterations);
+    bench::report("p x q, matrix_batch", soa_cross_ns/K);
+
+    double aos_normalize_ns = bench::measure([&] ()
+    {
+        for (size_t k = 0; k < K; ++k)
+        {
+            results[k] = normalize(points[k]);
+        }
+        bench::do_not_optimize(results);
+    }, iterations);
+    bench::report("normalize(p), array of matrices", aos_normalize_ns/K);
+
+    double soa_normalize_ns = bench::measure([&] ()
+    {
+        auto N = normalize(P);
+        bench::do_not_optimize(N);
+    }, iterations);
+    bench::report("normalize(p), matrix_batch", soa_normalize_ns/K);
+}
+
+/// \brief Rigid transformation of a point cloud the size of a lidar
+/// frame. Times are per point.
+void point_cloud(std::mt19937 &gen)
+{
+    using namespace lambda;
+
+    const size_t K = 2000000;
+    const size_t iterations = 10;
+    const se3 tf(quaternion(0.3, -0.2, 0.9, 0.1),
+                 column_vector<3>(10, 20, -5));
+    std::vector<column_vector<3>> points;
+    for (size_t k = 0; k < K; ++k)
+    {
+        points.push_back(random_matrix<3>(gen) * unitx);
+    }
+    std::vector<column_vector<3>> results(K);
+    const vector_batch<3> batch(points);
+    const size_t threads = std::thread::hardware_concurrency();
+
+    double loop_ns = bench::measure([&] ()
+    {
+        for (size_t k = 0; k < K; ++k)
+        {
+            results[k] = tf.rotation() * points[k] + tf.translation();
+        }
+        bench::do_not_optimize(results);
+    }, iterations);
+    bench::report("R*p + t, per point", loop_ns/K);
+
+    double apply_ns = bench::measure([&] ()
+    {
+        tf.apply(&points[0](0, 0), &results[0](0, 0), K);
+        bench::do_not_optimize(results);
+    }, iterations);
+    bench::report("se3::apply, 1 thread", apply_ns/K);
+
+    double threaded_ns = bench::measure([&] ()
+    {
+        tf.apply(&points[0](0, 0), &results[0](0, 0), K, threads);
+        bench::do_not_optimize(results);
+    }, iterations);
+    bench::report("se3::apply, " + std::to_string(threads) + " threads",
+                  threaded_ns/K);
+
+    double batch_ns = bench::measure([&] ()
+    {
+        auto transformed = tf * batch;
+        bench::do_not_optimize(transformed);
+    }, iterations);
+    bench::report("se3 * vector_batch", batch_ns/K);
+
+    vector_batch<3> transformed(K);
+    double batch_apply_ns = bench::measure([&] ()
+    {
+        tf.apply(batch, transformed);
+        bench::do_not_optimize(transformed);
+    }, iterations);
+    bench::report("se3::apply, vector_batch", batch_apply_ns/K);
+}
+
+/// \brief Products, sums and norms of large dynamic matrices, on one
+/// thread and on successively more, up to one per hardware thread.
+void thread_scaling(std::mt19937 &gen)
+{
+    using namespace lambda;
+
+    std::uniform_real_distribution<double> dist(-1, 1);
+    const size_t n = 1024, big = 4096;
+    dynamic_matrix A(n, n), B(n, n), C(n, n), X(big, big), Y(big, big);
+    for (size_t i = 0; i < n*n; ++i)
+    {
+        A[i] = dist(gen);
+        B[i] = dist(gen);
+    }
+    for (size_t i = 0; i < big*big; ++i)
+    {
+        X[i] = dist(gen);
+        Y[i] = dist(gen);
+    }
+
+    std::vector<size_t> counts;
+    const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t t = 1; t < hardware; t *= 2) counts.push_back(t);
+    counts.push_back(hardware);
+
+    for (size_t threads : counts)
+    {
+        set_thread_count(threads);
+        const std::string suffix = ", " + std::to_string(threads) +
+            (threads == 1 ? " thread" : " threads");
+
+        double gemm_ns = bench::measure([&] ()
+        {
+            gemm(1, A, B, 0, C);
+            bench::do_not_optimize(C);
+        }, 3);
+        bench::report("gemm, 1024x1024" + suffix, gemm_ns,
+                      3.0*n*n*sizeof(double), 2.0*n*n*n);
+
+        double add_ns = bench::measure([&] ()
+        {
+            X += Y;
+            bench::do_not_optimize(X);
+        }, 5);
+        bench::report("X += Y, 4096x4096" + suffix, add_ns,
+                      3.0*big*big*sizeof(double), 1.0*big*big);
+
+        double norm_ns = bench::measure([&] ()
+        {
+            double norm = frobenius_norm(X);
+            bench::do_not_optimize(norm);
+        }, 5);
+        bench::report("frobenius_norm, 4096x4096" + suffix, norm_ns,
+                      1.0*big*big*sizeof(double), 2.0*big*big);
+    }
+    set_thread_count(0);
+}
+
+/// \brief Products of the five-point Laplacian of a 512x512 grid, a
+/// typical mesh matrix, with one and eight dense columns; and a matrix
+/// of 1% nonzeros multiplying a vector, stored sparsely and densely.
+void sparse(std::mt19937 &gen)
+{
+    using namespace lambda;
+
+    std::uniform_real_distribution<double> dist(-1, 1);
+    const size_t grid = 512, n = grid*grid;
+    sparse_builder laplacian(n, n);
+    laplacian.reserve(5*n);
+    for (size_t r = 0; r < grid; ++r)
+    {
+        for (size_t c = 0; c < grid; ++c)
+        {
+            const size_t i = r*grid + c;
+            laplacian.add(i, i, 4);
+            if (r > 0) laplacian.add(i, i - grid, -1);
+            if (r + 1 < grid) laplacian.add(i, i + grid, -1);
+            if (c > 0) laplacian.add(i, i - 1, -1);
+            if (c + 1 < grid) laplacian.add(i, i + 1, -1);
+        }
+    }
+    const sparse_matrix L = laplacian.build();
+    dynamic_matrix x(n, 1), X(n, 8);
+    for (size_t i = 0; i < n; ++i) x[i] = dist(gen);
+    for (size_t i = 0; i < 8*n; ++i) X[i] = dist(gen);
+    const double nnz = L.nonzeros();
+    const double stored = nnz*(sizeof(double) + sizeof(size_t));
+
+    double spmv_ns = bench::measure([&] ()
+    {
+        dynamic_matrix y = L*x;
+        bench::do_not_optimize(y);
+    }, 20);
+    bench::report("sparse*vector, 512^2 laplacian", spmv_ns,
+                  stored + 2.0*n*sizeof(double), 2*nnz);
+
+    double spmm_ns = bench::measure([&] ()
+    {
+        dynamic_matrix Y = L*X;
+        bench::do_not_optimize(Y);
+    }, 10);
+    bench::report("sparse*dense, 512^2 laplacian, 8 columns", spmm_ns,
+                  stored + 16.0*n*sizeof(double), 16*nnz);
+
+    double transposed_ns = bench::measure([&] ()
+    {
+        dynamic_matrix Y = transpose_multiply(L, X);
+        bench::do_not_optimize(Y);
+    }, 10);
+    bench::report("transpose_multiply, 512^2 laplacian, 8 columns",
+                  transposed_ns, stored + 16.0*n*sizeof(double), 16*nnz);
+
+    const size_t m = 2048;
+    std::uniform_real_distribution<double> unit(0, 1);
+    dynamic_matrix D(m, m), v(m, 1);
+    for (size_t i = 0; i < m*m; ++i)
+    {
+        if (unit(gen) < 0.01) D[i] = dist(gen);
+    }
+    for (size_t i = 0; i < m; ++i) v[i] = dist(gen);
+    const sparse_matrix S(D);
+
+    double dense_ns = bench::measure([&] ()
+    {
+        dynamic_matrix y = D*v;
+        bench::do_not_optimize(y);
+    }, 20);
+    bench::report("dense*vector, 2048x2048, 1% nonzero", dense_ns,
+                  1.0*m*m*sizeof(double), 2.0*m*m);
+
+    double sparse_ns = bench::measure([&] ()
+    {
+        dynamic_matrix y = S*v;
+        bench::do_not_optimize(y);
+    }, 200);
+    bench::report("sparse*vector, 2048x2048, 1% nonzero", sparse_ns,
+                  S.nonzeros()*(sizeof(double) + sizeof(size_t)) +
+                  2.0*m*sizeof(double), 2.0*S.nonzeros());
+}
+
+namespace lambda
+{
+
+namespace bench
+{
+
+void matrix_benchmarks(std::mt19937 &gen)
+{
+    multiplication<3>(gen);
+    multiplication<4>(gen);
+    multiplication<6>(gen);
+    multiplication<9>(gen);
+
+    covariance_propagation<3>(gen);
+    covariance_propagation<6>(gen);
+    covariance_propagation<9>(gen);
+    covariance_propagation<12>(gen);
+    covariance_propagation<18>(gen);
+
+    factorization<3>(gen);
+    factorization<4>(gen);
+    factorization<6>(gen);
+    factorization<9>(gen);
+    factorization<12>(gen);
+
+    exponential<3>(gen);
+    exponential<6>(gen);
+    exponential<9>(gen);
+
+    batched(gen);
+    point_cloud(gen);
+    thread_scaling(gen);
+    sparse(gen);
+}
+
+} // namespace bench
+
+} // namespace lambda
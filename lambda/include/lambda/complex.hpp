@@ -1,6 +1,11 @@
 #ifndef LAMBDA_COMPLEX_HPP
 #define LAMBDA_COMPLEX_HPP
 
+#include <charconv>
+#include <iostream>
+
+#include "lambda/scalar.hpp"
+
 /*! 
     \file
     \brief Defines lambda::complex and supporting operations
@@ -19,6 +24,9 @@ class complex
     /// \brief Default constructor.
     complex();
 
+    /// \brief Construct a complex number with no imaginary component.
+    complex(double real);
+
     /// \brief Construct with a real and imaginary component.
     complex(double real, double imag);
 
@@ -85,6 +93,22 @@ complex operator / (complex c, double scalar);
 /// \brief Negate a complex number.
 complex operator - (complex c);
 
+/// \brief Compare two complex numbers for equality.
+bool operator == (complex c1, complex c2);
+
+/// \brief Compare two complex numbers for inequality.
+bool operator != (complex c1, complex c2);
+
+/// \brief Print a complex number to a std::ostream.
+std::ostream& operator << (std::ostream &os, complex c);
+
+/// \brief Write a complex number as re+imi, with each part in fixed
+/// notation with precision decimal places, into the buffer
+/// [first, last), without allocating. Follows std::to_chars: if the
+/// text does not fit, returns last and std::errc::value_too_large.
+std::to_chars_result to_chars(char *first, char *last, complex c,
+                              int precision = 3);
+
 /// \brief Get the argument of a complex number.
 double arg(complex c);
 
@@ -94,6 +118,27 @@ double norm(complex c);
 /// \brief Get the conjugate of a complex number.
 complex conj(complex c);
 
+/// \brief Lets lambda::matrix hold complex elements.
+template <> struct scalar_traits<complex>
+{
+    using real_type = double;
+
+    static real_type magnitude(const complex &x)
+    {
+        return norm(x);
+    }
+
+    static real_type squared_magnitude(const complex &x)
+    {
+        return x.real()*x.real() + x.imag()*x.imag();
+    }
+
+    static complex conjugate(const complex &x)
+    {
+        return conj(x);
+    }
+};
+
 } // namespace lambda
 
 #endif // LAMBDA_COMPLEX_HPP
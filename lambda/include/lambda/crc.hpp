@@ -2,6 +2,7 @@
 #define LAMBDA_CRC_HPP
 
 #include <bitset>
+#include <cstdint>
 #include <sstream>
 #include <vector>
 #include <iostream>
@@ -9,6 +10,12 @@
 namespace lambda
 {
 
+/// \brief Compute the cyclic redundancy check of some bytes, the
+/// remainder of dividing the message, most significant bit first and
+/// followed by degree zeros, by a polynomial. The coefficients of the
+/// polynomial are listed from the highest degree, which must be set,
+/// to the lowest; the remainder is listed likewise. The degree can be
+/// at most 64.
 std::vector<bool> crc(const std::vector<uint8_t> &data,
                       const std::vector<bool> &poly);
 
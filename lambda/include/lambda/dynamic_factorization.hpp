@@ -0,0 +1,166 @@
+#ifndef LAMBDA_DYNAMIC_FACTORIZATION_HPP
+#define LAMBDA_DYNAMIC_FACTORIZATION_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+#include "lambda/dynamic_matrix.hpp"
+
+/*!
+    \file
+    \brief Defines the LU, Cholesky and QR factorizations of dynamic
+    matrices. Each is computed once, when constructed, and can then
+    solve any number of systems. The factorizations are blocked, so that
+    almost all of their work is done by gemm, and is split between
+    threads in the same way.
+*/
+
+namespace lambda
+{
+
+/// \brief The LU factorization PA = LU of a square matrix, with partial
+/// pivoting. A singular matrix can be factored, but not solved with.
+class dynamic_lu
+{
+    public:
+
+    /// \brief Factor a square matrix. Throws std::invalid_argument if
+    /// it is not square.
+    explicit dynamic_lu(const dynamic_matrix &m);
+
+    /// \brief Get the number of rows, and columns, of the matrix.
+    size_t size() const;
+
+    /// \brief Check whether a zero pivot showed the matrix to be
+    /// singular.
+    bool singular() const;
+
+    /// \brief Get L and U packed into one matrix: L below the diagonal,
+    /// whose own diagonal is all ones, and U on and above it.
+    const dynamic_matrix& packed() const;
+
+    /// \brief Get the permutation: row i of PA is row permutation()[i]
+    /// of A.
+    const std::pmr::vector<size_t>& permutation() const;
+
+    /// \brief Get the determinant of the matrix.
+    double det() const;
+
+    /// \brief Solve AX = B, for any number of columns of B. Throws
+    /// std::invalid_argument if B has the wrong number of rows, and
+    /// std::domain_error if the matrix is singular.
+    dynamic_matrix solve(const dynamic_matrix &B) const;
+
+    /// \brief Get the inverse of the matrix. Throws std::domain_error if
+    /// it is singular.
+    dynamic_matrix inverse() const;
+
+    private:
+
+    dynamic_matrix _lu;
+    std::pmr::vector<size_t> _perm;
+    int _sign;
+};
+
+/// \brief The Cholesky factorization A = LL^T of a symmetric positive
+/// definite matrix. Only the lower triangle of A is read.
+class dynamic_cholesky
+{
+    public:
+
+    /// \brief Factor a symmetric positive definite matrix. Throws
+    /// std::invalid_argument if it is not square, and std::domain_error
+    /// if it is not positive definite.
+    explicit dynamic_cholesky(const dynamic_matrix &m);
+
+    /// \brief Get the number of rows, and columns, of the matrix.
+    size_t size() const;
+
+    /// \brief Get the lower triangular factor L.
+    dynamic_matrix lower() const;
+
+    /// \brief Get the determinant of the matrix.
+    double det() const;
+
+    /// \brief Solve AX = B, for any number of columns of B. Throws
+    /// std::invalid_argument if B has the wrong number of rows.
+    dynamic_matrix solve(const dynamic_matrix &B) const;
+
+    /// \brief Get the inverse of the matrix.
+    dynamic_matrix inverse() const;
+
+    private:
+
+    /// \brief L in the lower triangle, and its transpose in the upper.
+    dynamic_matrix _l;
+};
+
+/// \brief The QR factorization A = QR of an MxN matrix, M >= N, by
+/// Householder reflections, where Q is orthogonal and R upper
+/// triangular. Q is kept as the reflections rather than formed.
+class dynamic_qr
+{
+    public:
+
+    /// \brief Factor a matrix with at least as many rows as columns.
+    /// Throws std::invalid_argument if it has fewer.
+    explicit dynamic_qr(const dynamic_matrix &m);
+
+    /// \brief Get the number of rows of the matrix.
+    size_t rows() const;
+
+    /// \brief Get the number of columns of the matrix.
+    size_t columns() const;
+
+    /// \brief Get the first N columns of Q, an MxN matrix with
+    /// orthonormal columns.
+    dynamic_matrix q() const;
+
+    /// \brief Get the NxN upper triangular factor R.
+    dynamic_matrix r() const;
+
+    /// \brief Get the determinant of the matrix. Throws
+    /// std::invalid_argument if it is not square.
+    double det() const;
+
+    /// \brief Get the X which minimizes the Frobenius norm of AX - B,
+    /// for any number of columns of B; for a square matrix, the
+    /// solution of AX = B. Throws std::invalid_argument if B has the
+    /// wrong number of rows, and std::domain_error if the matrix does
+    /// not have full column rank.
+    dynamic_matrix solve(const dynamic_matrix &B) const;
+
+    /// \brief Get the inverse of the matrix. Throws
+    /// std::invalid_argument if it is not square, and std::domain_error
+    /// if it is singular.
+    dynamic_matrix inverse() const;
+
+    private:
+
+    /// \brief R on and above the diagonal, and the Householder vectors
+    /// below it, each with an implicit leading one.
+    dynamic_matrix _qr;
+    /// \brief The scale of each reflection, I - tau*v*v^T.
+    std::pmr::vector<double> _tau;
+    /// \brief The triangular factor T of each panel of reflections,
+    /// whose product is I - Y*T*Y^T; the panel starting at column k is
+    /// at row k.
+    dynamic_matrix _t;
+};
+
+/// \brief Compute the determinant of a square matrix, by LU
+/// factorization.
+double det(const dynamic_matrix &m);
+
+/// \brief Compute the inverse of a square matrix, by LU factorization.
+/// Throws std::domain_error if it is singular.
+dynamic_matrix inverse(const dynamic_matrix &m);
+
+/// \brief Solve AX = B for a square matrix A, by LU factorization.
+/// Throws std::domain_error if A is singular.
+dynamic_matrix solve(const dynamic_matrix &A, const dynamic_matrix &B);
+
+} // namespace lambda
+
+#endif // LAMBDA_DYNAMIC_FACTORIZATION_HPP
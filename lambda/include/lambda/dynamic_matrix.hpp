@@ -6,9 +6,13 @@
 #include <cstdint>
 #include <iostream>
 #include <iomanip>
+#include <memory_resource>
 #include <sstream>
+#include <type_traits>
+#include <utility>
 
 #include "lambda/matrix.hpp"
+#include "lambda/memory.hpp"
 
 /*!
     \file
@@ -26,22 +30,56 @@ class dynamic_matrix
 {
     public:
 
+    // Each constructor allocates from the given memory resource, by
+    // default matrix_resource(); a matrix keeps its resource when
+    // assigned to, so that it can reuse its storage.
+
     /// \brief Copy constructor.
-    dynamic_matrix(const dynamic_matrix &other);
+    dynamic_matrix(const dynamic_matrix &other,
+                   std::pmr::memory_resource *resource = matrix_resource());
+
+    /// \brief Move constructor; takes the elements of other, and its
+    /// memory resource, leaving it an empty 0x0 matrix.
+    dynamic_matrix(dynamic_matrix &&other) noexcept;
 
     /// \brief Construct with dimensions only.
-    dynamic_matrix(size_t rows, size_t columns);
+    dynamic_matrix(size_t rows, size_t columns,
+                   std::pmr::memory_resource *resource = matrix_resource());
 
     /// \brief Construct with dimensions and contents.
     dynamic_matrix(size_t rows, size_t columns,
-                   const std::vector<double> &data);
+                   const std::vector<double> &data,
+                   std::pmr::memory_resource *resource = matrix_resource());
 
     template <size_t M, size_t N>
-    dynamic_matrix(const lambda::matrix<M, N> &mat);
+    dynamic_matrix(const lambda::matrix<M, N> &mat,
+                   std::pmr::memory_resource *resource = matrix_resource());
 
-    /// \brief Assignment operator.
+    /// \brief Assignment operator. Reuses the existing storage if it is
+    /// large enough.
     dynamic_matrix& operator = (const dynamic_matrix &m);
 
+    /// \brief Move assignment operator. Takes the elements of m if it
+    /// uses the same memory resource, and otherwise copies them into
+    /// this matrix's storage; m is left an empty 0x0 matrix.
+    dynamic_matrix& operator = (dynamic_matrix &&m);
+
+    /// \brief Add a matrix of the same size to this one, in place.
+    dynamic_matrix& operator += (const dynamic_matrix &m);
+
+    /// \brief Subtract a matrix of the same size from this one, in place.
+    dynamic_matrix& operator -= (const dynamic_matrix &m);
+
+    /// \brief Multiply this matrix by a scalar, in place.
+    dynamic_matrix& operator *= (double scalar);
+
+    /// \brief Divide this matrix by a scalar, in place.
+    dynamic_matrix& operator /= (double divisor);
+
+    /// \brief Multiply this matrix on the right by another. The product
+    /// needs its own storage, which then replaces this matrix's.
+    dynamic_matrix& operator *= (const dynamic_matrix &m);
+
     /// \brief Get the number of rows in this matrix.
     size_t rows() const;
 
@@ -79,12 +117,17 @@ class dynamic_matrix
     double& at(size_t i, size_t j);
 
     /// \brief Get a const ref to the underlying data of this matrix.
-    const std::vector<double>& data() const;
+    /// This is a std::pmr::vector, not a std::vector, so callers which
+    /// need a std::vector must copy it, e.g. with its begin and end.
+    const std::pmr::vector<double>& data() const;
+
+    /// \brief Get the memory resource this matrix allocates from.
+    std::pmr::memory_resource* resource() const;
 
     private:
 
     /// \brief Matrix elements stored here.
-    std::vector<double> _data;
+    std::pmr::vector<double> _data;
     size_t _rows, _columns;
 
     /// \brief Throws an exception if an index is out of bounds.
@@ -95,60 +138,130 @@ class dynamic_matrix
 };
 
 template <size_t M, size_t N>
-dynamic_matrix::dynamic_matrix(const lambda::matrix<M, N> &mat)
-    : _data(begin(mat.data()), end(mat.data())), _rows(M), _columns(N) { }
+dynamic_matrix::dynamic_matrix(const lambda::matrix<M, N> &mat,
+                               std::pmr::memory_resource *resource)
+    : _data(begin(mat.data()), end(mat.data()), resource),
+    _rows(M), _columns(N) { }
 
 bool operator == (const dynamic_matrix &left,
                   const dynamic_matrix &right);
 
 /// \brief X basis vector.
-const dynamic_matrix dunitx();
+const dynamic_matrix& dunitx();
 
 /// \brief Y basis vector.
-const dynamic_matrix dunity();
+const dynamic_matrix& dunity();
 
 /// \brief Z basis vector.
-const dynamic_matrix dunitz();
+const dynamic_matrix& dunitz();
+
+/// \brief Write the text of a matrix, as printed by operator <<, into
+/// the buffer [first, last) without allocating. Follows std::to_chars:
+/// if the text does not fit, returns last and std::errc::value_too_large.
+std::to_chars_result to_chars(char *first, char *last,
+                              const dynamic_matrix &m);
 
-/// \brief Print a matrix to a std::ostream.
+/// \brief Print a matrix to a std::ostream, with three decimal places.
+/// The stream's precision and flags are left unchanged.
 std::ostream& operator << (std::ostream &os, const dynamic_matrix &m);
 
 /// \brief Produces a multiline string representation of a matrix.
 std::string pretty(const dynamic_matrix &m);
 
+/// \brief Get the Frobenius norm of a matrix, the square root of the
+/// sum of the squares of its elements.
+double frobenius_norm(const dynamic_matrix &m);
+
+// Elementwise operations on large matrices, and products through gemm,
+// are split between lambda::thread_count() threads; see parallel.hpp.
+// The arithmetic operators below come in overloads for rvalue operands,
+// which take over the storage of an expiring operand for the result,
+// so that a chain such as A*B + C - 2*D allocates once per product or
+// scaled copy, rather than once per operator.
+
 /// \brief Multiplication of a matrix by a scalar.
-template <class T>
+template <class T, typename std::enable_if<
+    std::is_arithmetic<T>::value, int>::type = 0>
 dynamic_matrix operator * (const dynamic_matrix &m, T scalar)
 {
-    auto ret = m;
-    for (size_t i = 0; i < m.rows(); ++i)
-    {
-        for (size_t j = 0; j < m.columns(); ++j)
-        {
-            ret(i, j) *= scalar;
-        }
-    }
+    dynamic_matrix ret = m;
+    ret *= scalar;
     return ret;
 }
 
+/// \brief Multiplication of a matrix by a scalar, reusing the storage
+/// of m.
+template <class T, typename std::enable_if<
+    std::is_arithmetic<T>::value, int>::type = 0>
+dynamic_matrix operator * (dynamic_matrix &&m, T scalar)
+{
+    m *= scalar;
+    return std::move(m);
+}
+
 /// \brief Multiplication of a matrix by a scalar.
-template <class T>
+template <class T, typename std::enable_if<
+    std::is_arithmetic<T>::value, int>::type = 0>
 dynamic_matrix operator * (T scalar, const dynamic_matrix &m)
 {
     return m*scalar;
 }
 
+/// \brief Multiplication of a matrix by a scalar, reusing the storage
+/// of m.
+template <class T, typename std::enable_if<
+    std::is_arithmetic<T>::value, int>::type = 0>
+dynamic_matrix operator * (T scalar, dynamic_matrix &&m)
+{
+    return std::move(m)*scalar;
+}
+
 /// \brief Division of a matrix by a scalar.
-template <class T>
+template <class T, typename std::enable_if<
+    std::is_arithmetic<T>::value, int>::type = 0>
 dynamic_matrix operator / (const dynamic_matrix &m, T divisor)
 {
     return m*(1.0/divisor);
 }
 
+/// \brief Division of a matrix by a scalar, reusing the storage of m.
+template <class T, typename std::enable_if<
+    std::is_arithmetic<T>::value, int>::type = 0>
+dynamic_matrix operator / (dynamic_matrix &&m, T divisor)
+{
+    return std::move(m)*(1.0/divisor);
+}
+
 /// \brief Addition of two matrices.
 dynamic_matrix operator + (const dynamic_matrix &left,
                            const dynamic_matrix &right);
 
+/// \brief Addition of two matrices, reusing the storage of left.
+dynamic_matrix operator + (dynamic_matrix &&left,
+                           const dynamic_matrix &right);
+
+/// \brief Addition of two matrices, reusing the storage of right.
+dynamic_matrix operator + (const dynamic_matrix &left,
+                           dynamic_matrix &&right);
+
+/// \brief Addition of two matrices, reusing the storage of left.
+dynamic_matrix operator + (dynamic_matrix &&left, dynamic_matrix &&right);
+
+/// \brief Subtraction of two matrices.
+dynamic_matrix operator - (const dynamic_matrix &left,
+                           const dynamic_matrix &right);
+
+/// \brief Subtraction of two matrices, reusing the storage of left.
+dynamic_matrix operator - (dynamic_matrix &&left,
+                           const dynamic_matrix &right);
+
+/// \brief Subtraction of two matrices, reusing the storage of right.
+dynamic_matrix operator - (const dynamic_matrix &left,
+                           dynamic_matrix &&right);
+
+/// \brief Subtraction of two matrices, reusing the storage of left.
+dynamic_matrix operator - (dynamic_matrix &&left, dynamic_matrix &&right);
+
 /// \brief Multiplication of two matrices.
 dynamic_matrix operator * (const dynamic_matrix &left,
                            const dynamic_matrix &right);
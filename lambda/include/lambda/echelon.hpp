@@ -16,8 +16,8 @@ namespace lambda
 {
 
 /// \brief Swap two rows in a matrix.
-template <size_t M, size_t N>
-matrix<M, N> swap_rows(const matrix<M, N> &m, size_t r1, size_t r2)
+template <size_t M, size_t N, class T>
+matrix<M, N, T> swap_rows(const matrix<M, N, T> &m, size_t r1, size_t r2)
 {
     if (r1 >= M)
     {
@@ -43,17 +43,17 @@ matrix<M, N> swap_rows(const matrix<M, N> &m, size_t r1, size_t r2)
 }
 
 /// \brief Swap two columns in a matrix.
-template <size_t M, size_t N>
-matrix<M, N> swap_cols(const matrix<M, N> &m, size_t c1, size_t c2)
+template <size_t M, size_t N, class T>
+matrix<M, N, T> swap_cols(const matrix<M, N, T> &m, size_t c1, size_t c2)
 {
-    if (c1 >= M)
+    if (c1 >= N)
     {
         std::stringstream ss;
         ss << "Column " << c1 << " is out of bounds of "
             << M << "x" << N << " matrix";
         throw std::out_of_range(ss.str());
     }
-    if (c2 >= M)
+    if (c2 >= N)
     {
         std::stringstream ss;
         ss << "Column " << c2 << " is out of bounds of "
@@ -69,79 +69,341 @@ matrix<M, N> swap_cols(const matrix<M, N> &m, size_t c1, size_t c2)
     return ret;
 }
 
-/// \brief Get the RREF form of a matrix.
-template <size_t M, size_t N>
-matrix<M, N> rref(const matrix<M, N> &m)
+namespace detail
+{
+
+/// \brief Swap two rows of a matrix in place, from column c onwards.
+template <size_t M, size_t N, class T>
+void swap_rows(matrix<M, N, T> &m, size_t r1, size_t r2, size_t c = 0)
+{
+    for (; c < N; ++c)
+    {
+        std::swap(m(r1, c), m(r2, c));
+    }
+}
+
+/// \brief Find the row at or below r with the largest magnitude element
+/// in column c.
+template <size_t M, size_t N, class T>
+size_t pivot_row(const matrix<M, N, T> &m, size_t r, size_t c)
+{
+    size_t pivot = r;
+    auto largest = scalar_traits<T>::magnitude(m(r, c));
+    for (size_t i = r + 1; i < M; ++i)
+    {
+        auto mag = scalar_traits<T>::magnitude(m(i, c));
+        if (mag > largest)
+        {
+            largest = mag;
+            pivot = i;
+        }
+    }
+    return pivot;
+}
+
+} // namespace detail
+
+/// \brief Get the RREF form of a matrix. Rows are exchanged to pivot on
+/// the largest element of each column.
+template <size_t M, size_t N, class T>
+matrix<M, N, T> rref(const matrix<M, N, T> &m)
 {
     auto ret = m;
     size_t lead = 0;
-    for (size_t r = 0; r < M; ++r)
+    for (size_t r = 0; r < M && lead < N; ++r, ++lead)
     {
-        size_t i = r;
-        while (ret(i, lead) == 0)
+        size_t i = detail::pivot_row(ret, r, lead);
+        while (ret(i, lead) == T(0))
         {
-            ++i;
-            if (M == i)
+            if (N == ++lead)
             {
-                i = r;
-                ++lead;
-                if (N == lead)
-                {
-                    return ret;
-                }
+                return ret;
             }
+            i = detail::pivot_row(ret, r, lead);
         }
-        swap_rows(ret, i, r);
-        if (ret(r, lead) != 0)
+        detail::swap_rows(ret, i, r, lead);
+
+        const T div = ret(r, lead);
+        ret(r, lead) = T(1);
+        for (size_t k = lead + 1; k < N; ++k)
         {
-            auto div = ret(r, lead);
-            for (size_t k = 0; k < N; ++k)
-            {
-                ret(r, k) /= div;
-            }
+            ret(r, k) /= div;
         }
         for (size_t p = 0; p < M; ++p)
         {
-            if (p != r)
+            if (p != r && ret(p, lead) != T(0))
             {
-                auto mult = ret(p, lead);
-                for (size_t k = 0; k < N; ++k)
+                const T mult = ret(p, lead);
+                ret(p, lead) = T(0);
+                for (size_t k = lead + 1; k < N; ++k)
                 {
                     ret(p, k) -= mult*ret(r, k);
                 }
             }
         }
-        ++lead;
     }
     return ret;
 }
 
 /// \brief Get the RREF of a 1x1 matrix.
-matrix<1, 1> rref(const matrix<1, 1> &m);
+template <class T>
+matrix<1, 1, T> rref(const matrix<1, 1, T> &m)
+{
+    return m;
+}
 
-/// \brief Compute the inverse of a square matrix.
-template <size_t N>
-matrix<N, N> inverse(const matrix<N, N> &mat)
+/// \brief Compute the inverse of a square matrix, and its determinant,
+/// from a single LU factorization. Throws if the matrix is singular.
+template <size_t N, class T>
+matrix<N, N, T> inverse(const matrix<N, N, T> &mat, T &determinant)
 {
-    if (!is_invertible(mat))
+    matrix<N, N, T> lu = mat;
+    std::array<size_t, N> perm{};
+    int sign = detail::lu_factor(lu, perm);
+    determinant = detail::lu_det(lu, sign);
+    if (sign == 0)
     {
         std::stringstream ss;
         ss << "Cannot invert matrix " << mat
             << ", which is singular";
         throw std::domain_error(ss.str());
     }
-    auto reduced = rref(augment(mat, identity<N, N>()));
-    matrix<N, N> inv;
-    for (size_t r = 0; r < N; ++r)
+    return detail::lu_solve(lu, perm, identity<N, N, T>());
+}
+
+namespace detail
+{
+
+/// \brief Invert a square matrix in place, by Gauss-Jordan elimination
+/// with partial pivoting. The columns of the inverse are built up in the
+/// columns of m that have already been eliminated, so no other matrix
+/// is needed. Returns false if m is singular, in which case its contents
+/// are unspecified.
+template <size_t N, class T>
+bool gauss_jordan(matrix<N, N, T> &m)
+{
+    std::array<size_t, N> swapped{};
+    for (size_t k = 0; k < N; ++k)
     {
+        const size_t p = pivot_row(m, k, k);
+        if (m(p, k) == T(0))
+        {
+            return false;
+        }
+        swap_rows(m, p, k);
+        swapped[k] = p;
+
+        const T inv_pivot = T(1)/m(k, k);
+        m(k, k) = T(1);
         for (size_t c = 0; c < N; ++c)
         {
-            inv(r, c) = reduced(r, N + c);
+            m(k, c) *= inv_pivot;
+        }
+        for (size_t r = 0; r < N; ++r)
+        {
+            if (r != k)
+            {
+                const T mult = m(r, k);
+                m(r, k) = T(0);
+                for (size_t c = 0; c < N; ++c)
+                {
+                    m(r, c) -= mult*m(k, c);
+                }
+            }
         }
     }
+
+    // Exchanging rows of m exchanged columns of its inverse; undo them
+    // in reverse order.
+    for (size_t k = N; k-- > 0; )
+    {
+        if (swapped[k] != k)
+        {
+            for (size_t r = 0; r < N; ++r)
+            {
+                std::swap(m(r, k), m(r, swapped[k]));
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+
+/// \brief Invert a square matrix in place. Throws if the matrix is
+/// singular, in which case the contents of m are unspecified.
+template <size_t N, class T>
+void invert(matrix<N, N, T> &m)
+{
+    if (!detail::gauss_jordan(m))
+    {
+        std::stringstream ss;
+        ss << "Cannot invert " << N << "x" << N
+            << " matrix, which is singular";
+        throw std::domain_error(ss.str());
+    }
+}
+
+/// \brief Compute the inverse of a square matrix.
+template <size_t N, class T>
+matrix<N, N, T> inverse(const matrix<N, N, T> &mat)
+{
+    auto inv = mat;
+    if (!detail::gauss_jordan(inv))
+    {
+        std::stringstream ss;
+        ss << "Cannot invert matrix " << mat
+            << ", which is singular";
+        throw std::domain_error(ss.str());
+    }
     return inv;
 }
 
+namespace detail
+{
+
+/// \brief Throws std::domain_error for a singular matrix, from the
+/// closed-form inverses.
+template <size_t N, class T>
+[[noreturn]] void singular_inverse(const matrix<N, N, T> &mat)
+{
+    std::stringstream ss;
+    ss << "Cannot invert matrix " << mat
+        << ", which is singular";
+    throw std::domain_error(ss.str());
+}
+
+} // namespace detail
+
+/// \brief Compute the inverse of a 3x3 matrix, as its adjugate over its
+/// determinant.
+template <class T>
+matrix<3, 3, T> inverse(const matrix<3, 3, T> &m)
+{
+    // The first column of the adjugate also expands the determinant.
+    const T a00 = m(1,1)*m(2,2) - m(1,2)*m(2,1);
+    const T a10 = m(1,2)*m(2,0) - m(1,0)*m(2,2);
+    const T a20 = m(1,0)*m(2,1) - m(1,1)*m(2,0);
+    const T d = m(0,0)*a00 + m(0,1)*a10 + m(0,2)*a20;
+    if (d == T(0))
+    {
+        detail::singular_inverse(m);
+    }
+    const T s = T(1)/d;
+    return matrix<3, 3, T>(
+        a00*s, (m(0,2)*m(2,1) - m(0,1)*m(2,2))*s,
+            (m(0,1)*m(1,2) - m(0,2)*m(1,1))*s,
+        a10*s, (m(0,0)*m(2,2) - m(0,2)*m(2,0))*s,
+            (m(0,2)*m(1,0) - m(0,0)*m(1,2))*s,
+        a20*s, (m(0,1)*m(2,0) - m(0,0)*m(2,1))*s,
+            (m(0,0)*m(1,1) - m(0,1)*m(1,0))*s);
+}
+
+/// \brief Compute the inverse of a 4x4 matrix, as its adjugate over its
+/// determinant, from the 2x2 minors of its top and bottom halves.
+template <class T>
+matrix<4, 4, T> inverse(const matrix<4, 4, T> &m)
+{
+    const T s0 = m(0,0)*m(1,1) - m(1,0)*m(0,1);
+    const T s1 = m(0,0)*m(1,2) - m(1,0)*m(0,2);
+    const T s2 = m(0,0)*m(1,3) - m(1,0)*m(0,3);
+    const T s3 = m(0,1)*m(1,2) - m(1,1)*m(0,2);
+    const T s4 = m(0,1)*m(1,3) - m(1,1)*m(0,3);
+    const T s5 = m(0,2)*m(1,3) - m(1,2)*m(0,3);
+
+    const T c5 = m(2,2)*m(3,3) - m(3,2)*m(2,3);
+    const T c4 = m(2,1)*m(3,3) - m(3,1)*m(2,3);
+    const T c3 = m(2,1)*m(3,2) - m(3,1)*m(2,2);
+    const T c2 = m(2,0)*m(3,3) - m(3,0)*m(2,3);
+    const T c1 = m(2,0)*m(3,2) - m(3,0)*m(2,2);
+    const T c0 = m(2,0)*m(3,1) - m(3,0)*m(2,1);
+
+    const T d = s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+    if (d == T(0))
+    {
+        detail::singular_inverse(m);
+    }
+    const T s = T(1)/d;
+    return matrix<4, 4, T>(
+        ( m(1,1)*c5 - m(1,2)*c4 + m(1,3)*c3)*s,
+        (-m(0,1)*c5 + m(0,2)*c4 - m(0,3)*c3)*s,
+        ( m(3,1)*s5 - m(3,2)*s4 + m(3,3)*s3)*s,
+        (-m(2,1)*s5 + m(2,2)*s4 - m(2,3)*s3)*s,
+
+        (-m(1,0)*c5 + m(1,2)*c2 - m(1,3)*c1)*s,
+        ( m(0,0)*c5 - m(0,2)*c2 + m(0,3)*c1)*s,
+        (-m(3,0)*s5 + m(3,2)*s2 - m(3,3)*s1)*s,
+        ( m(2,0)*s5 - m(2,2)*s2 + m(2,3)*s1)*s,
+
+        ( m(1,0)*c4 - m(1,1)*c2 + m(1,3)*c0)*s,
+        (-m(0,0)*c4 + m(0,1)*c2 - m(0,3)*c0)*s,
+        ( m(3,0)*s4 - m(3,1)*s2 + m(3,3)*s0)*s,
+        (-m(2,0)*s4 + m(2,1)*s2 - m(2,3)*s0)*s,
+
+        (-m(1,0)*c3 + m(1,1)*c1 - m(1,2)*c0)*s,
+        ( m(0,0)*c3 - m(0,1)*c1 + m(0,2)*c0)*s,
+        (-m(3,0)*s3 + m(3,1)*s1 - m(3,2)*s0)*s,
+        ( m(2,0)*s3 - m(2,1)*s1 + m(2,2)*s0)*s);
+}
+
+/// \brief Solve the linear system A x = b for x, where b may have several
+/// columns, by Gaussian elimination with partial pivoting. The inverse of
+/// A is never formed. Throws if A is singular.
+template <size_t N, size_t P, class T>
+matrix<N, P, T> solve(const matrix<N, N, T> &A, const matrix<N, P, T> &b)
+{
+    auto a = A;
+    auto x = b;
+    for (size_t k = 0; k < N; ++k)
+    {
+        const size_t p = detail::pivot_row(a, k, k);
+        if (a(p, k) == T(0))
+        {
+            std::stringstream ss;
+            ss << "Cannot solve system with matrix " << A
+                << ", which is singular";
+            throw std::domain_error(ss.str());
+        }
+        if (p != k)
+        {
+            detail::swap_rows(a, p, k, k);
+            detail::swap_rows(x, p, k);
+        }
+
+        const T inv_pivot = T(1)/a(k, k);
+        for (size_t r = k + 1; r < N; ++r)
+        {
+            const T mult = a(r, k) * inv_pivot;
+            for (size_t c = k + 1; c < N; ++c)
+            {
+                a(r, c) -= mult*a(k, c);
+            }
+            for (size_t c = 0; c < P; ++c)
+            {
+                x(r, c) -= mult*x(k, c);
+            }
+        }
+    }
+
+    for (size_t r = N; r-- > 0; )
+    {
+        for (size_t k = r + 1; k < N; ++k)
+        {
+            const T u = a(r, k);
+            for (size_t c = 0; c < P; ++c)
+            {
+                x(r, c) -= u*x(k, c);
+            }
+        }
+        const T inv_pivot = T(1)/a(r, r);
+        for (size_t c = 0; c < P; ++c)
+        {
+            x(r, c) *= inv_pivot;
+        }
+    }
+    return x;
+}
+
 } // namespace lambda
 
 #endif // LAMBDA_ECHELON_HPP
@@ -0,0 +1,162 @@
+#ifndef LAMBDA_EXPONENTIAL_HPP
+#define LAMBDA_EXPONENTIAL_HPP
+
+#include <cmath>
+#include <stdexcept>
+
+#include "lambda/matrix.hpp"
+#include "lambda/echelon.hpp"
+
+/*!
+    \file
+    \brief Defines lambda::expm, the exponential of a square matrix.
+*/
+
+namespace lambda
+{
+
+namespace detail
+{
+
+/// \brief The largest 1-norm for which each Pade approximant, of degree
+/// 3, 5, 7, 9 and 13, gives exp(A) to double precision. From Higham,
+/// "The Scaling and Squaring Method for the Matrix Exponential
+/// Revisited", 2005.
+constexpr double pade_theta[] = { 1.495585217958292e-2,
+    2.539398330063230e-1, 9.504178996162932e-1, 2.097847961257068,
+    5.371920351148152 };
+
+/// \brief Numerator coefficients of the degree 3, 5, 7 and 9 Pade
+/// approximants to exp(x).
+constexpr double pade3[] = { 120, 60, 12, 1 };
+constexpr double pade5[] = { 30240, 15120, 3360, 420, 30, 1 };
+constexpr double pade7[] = { 17297280, 8648640, 1995840, 277200,
+    25200, 1512, 56, 1 };
+constexpr double pade9[] = { 17643225600, 8821612800, 2075673600,
+    302702400, 30270240, 2162160, 110880, 3960, 90, 1 };
+constexpr double pade13[] = { 64764752532480000, 32382376266240000,
+    7771770303897600, 1187353796428800, 129060195264000,
+    10559470521600, 670442572800, 33522128640, 1323241920, 40840800,
+    960960, 16380, 182, 1 };
+
+/// \brief The 1-norm of a matrix; its largest absolute column sum, or
+/// NaN if any element is NaN.
+template <size_t N, class T>
+typename scalar_traits<T>::real_type one_norm(const matrix<N, N, T> &m)
+{
+    typename scalar_traits<T>::real_type largest = 0;
+    for (size_t c = 0; c < N; ++c)
+    {
+        typename scalar_traits<T>::real_type sum = 0;
+        for (size_t r = 0; r < N; ++r)
+        {
+            sum += scalar_traits<T>::magnitude(m(r, c));
+        }
+        if (sum > largest || std::isnan(sum))
+        {
+            largest = sum;
+        }
+    }
+    return largest;
+}
+
+/// \brief Evaluates the degree D Pade approximant to exp(A), given the
+/// even powers of A, A2 = A^2 and so on; r(A) = (V - U)^-1 (V + U),
+/// where U holds the odd terms and V the even ones.
+template <size_t D, size_t N, class T>
+matrix<N, N, T> pade(const matrix<N, N, T> &A, const double (&b)[D + 1])
+{
+    matrix<N, N, T> power = identity<N, N, T>();
+    const matrix<N, N, T> A2 = A * A;
+    matrix<N, N, T> odd, even;
+    for (size_t k = 0; 2*k < D; ++k)
+    {
+        if (k > 0)
+        {
+            power = power * A2;
+        }
+        even += T(b[2*k]) * power;
+        odd += T(b[2*k + 1]) * power;
+    }
+    const matrix<N, N, T> U = A * odd;
+    return solve(matrix<N, N, T>(even - U), matrix<N, N, T>(even + U));
+}
+
+/// \brief Evaluates the degree 13 Pade approximant to exp(A), using
+/// only A^2, A^4 and A^6.
+template <size_t N, class T>
+matrix<N, N, T> pade13_approximant(const matrix<N, N, T> &A)
+{
+    const double (&b)[14] = pade13;
+    const matrix<N, N, T> I = identity<N, N, T>();
+    const matrix<N, N, T> A2 = A * A;
+    const matrix<N, N, T> A4 = A2 * A2;
+    const matrix<N, N, T> A6 = A4 * A2;
+
+    const matrix<N, N, T> odd_high =
+        T(b[13])*A6 + T(b[11])*A4 + T(b[9])*A2;
+    const matrix<N, N, T> odd = A6 * odd_high +
+        T(b[7])*A6 + T(b[5])*A4 + T(b[3])*A2 + T(b[1])*I;
+    const matrix<N, N, T> U = A * odd;
+
+    const matrix<N, N, T> even_high =
+        T(b[12])*A6 + T(b[10])*A4 + T(b[8])*A2;
+    const matrix<N, N, T> V = A6 * even_high +
+        T(b[6])*A6 + T(b[4])*A4 + T(b[2])*A2 + T(b[0])*I;
+
+    return solve(matrix<N, N, T>(V - U), matrix<N, N, T>(V + U));
+}
+
+} // namespace detail
+
+/// \brief Compute the exponential of a square matrix, by scaling and
+/// squaring with Pade approximants. The lowest degree approximant which
+/// is accurate for the 1-norm of the matrix is used; past the largest,
+/// the matrix is scaled down by a power of two 2^s, and the result is
+/// squared s times. Throws std::domain_error if any element of the
+/// matrix is infinite or NaN.
+template <size_t N, class T>
+matrix<N, N, T> expm(const matrix<N, N, T> &A)
+{
+    const auto norm = detail::one_norm(A);
+    if (!std::isfinite(norm))
+    {
+        throw std::domain_error("Cannot compute exponential of matrix "
+                                "with non-finite elements");
+    }
+
+    if (norm <= detail::pade_theta[0])
+    {
+        return detail::pade<3>(A, detail::pade3);
+    }
+    if (norm <= detail::pade_theta[1])
+    {
+        return detail::pade<5>(A, detail::pade5);
+    }
+    if (norm <= detail::pade_theta[2])
+    {
+        return detail::pade<7>(A, detail::pade7);
+    }
+    if (norm <= detail::pade_theta[3])
+    {
+        return detail::pade<9>(A, detail::pade9);
+    }
+
+    int s = 0;
+    if (norm > detail::pade_theta[4])
+    {
+        s = static_cast<int>(std::ceil(std::log2(
+            norm / detail::pade_theta[4])));
+    }
+    const matrix<N, N, T> scaled = A * T(std::ldexp(1.0, -s));
+    matrix<N, N, T> ret = detail::pade13_approximant(scaled);
+    for (int i = 0; i < s; ++i)
+    {
+        ret = ret * ret;
+    }
+    return ret;
+}
+
+} // namespace lambda
+
+#endif // LAMBDA_EXPONENTIAL_HPP
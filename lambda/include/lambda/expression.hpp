@@ -0,0 +1,498 @@
+#ifndef LAMBDA_EXPRESSION_HPP
+#define LAMBDA_EXPRESSION_HPP
+
+#include <cstddef>
+#include <type_traits>
+
+/*!
+    \file
+    \brief Defines the expression templates used for lambda::matrix
+    arithmetic. Operators build lightweight expression nodes, which
+    are only evaluated, in a single pass, when assigned to a matrix.
+*/
+
+namespace lambda
+{
+
+/// \brief Forward declaration of lambda::matrix.
+template <size_t M, size_t N, class T = double> class matrix;
+
+/// \brief Base class of every matrix-valued expression, including
+/// lambda::matrix itself. E is the concrete expression type.
+template <class E> class matrix_expression
+{
+    public:
+
+    /// \brief Get a reference to the concrete expression.
+    constexpr const E& self() const
+    {
+        return static_cast<const E&>(*this);
+    }
+};
+
+/// \brief Element-wise access to an expression. Each expression
+/// type specializes this; evaluators of nodes hold evaluators
+/// of their children.
+template <class E> class evaluator;
+
+/// \brief Matrices are held by reference in expressions; every
+/// other expression node is small and held by value.
+template <class E> struct expression_storage
+{
+    using type = const E;
+};
+
+template <size_t M, size_t N, class T>
+struct expression_storage<matrix<M, N, T>>
+{
+    using type = const matrix<M, N, T>&;
+};
+
+/// \brief Whether an expression can be read element-wise at little
+/// cost. Products materialize operands which are not direct, so
+/// that each element of those operands is computed only once.
+template <class E> struct is_direct : std::false_type { };
+
+template <size_t M, size_t N, class T>
+struct is_direct<matrix<M, N, T>> : std::true_type { };
+
+/// \brief Element-wise sum of two expressions.
+template <class L, class R>
+class sum_expr : public matrix_expression<sum_expr<L, R>>
+{
+    static_assert(L::rows == R::rows && L::cols == R::cols,
+        "Cannot add matrices of different dimensions");
+    static_assert(std::is_same<typename L::value_type,
+                               typename R::value_type>::value,
+        "Cannot add matrices of different element types");
+
+    public:
+
+    using value_type = typename L::value_type;
+
+    static constexpr size_t rows = L::rows;
+    static constexpr size_t cols = L::cols;
+
+    constexpr sum_expr(const L &left, const R &right)
+        : _left(left), _right(right) { }
+
+    constexpr const L& left() const { return _left; }
+    constexpr const R& right() const { return _right; }
+
+    /// \brief Whether this expression reads from the matrix at p.
+    constexpr bool reads(const void *p) const
+    {
+        return _left.reads(p) || _right.reads(p);
+    }
+
+    /// \brief Whether evaluating this expression directly into the
+    /// matrix at p could read elements which were already written.
+    constexpr bool aliases(const void *p) const
+    {
+        return _left.aliases(p) || _right.aliases(p);
+    }
+
+    private:
+
+    typename expression_storage<L>::type _left;
+    typename expression_storage<R>::type _right;
+};
+
+/// \brief Element-wise difference of two expressions.
+template <class L, class R>
+class difference_expr : public matrix_expression<difference_expr<L, R>>
+{
+    static_assert(L::rows == R::rows && L::cols == R::cols,
+        "Cannot subtract matrices of different dimensions");
+    static_assert(std::is_same<typename L::value_type,
+                               typename R::value_type>::value,
+        "Cannot subtract matrices of different element types");
+
+    public:
+
+    using value_type = typename L::value_type;
+
+    static constexpr size_t rows = L::rows;
+    static constexpr size_t cols = L::cols;
+
+    constexpr difference_expr(const L &left, const R &right)
+        : _left(left), _right(right) { }
+
+    constexpr const L& left() const { return _left; }
+    constexpr const R& right() const { return _right; }
+
+    constexpr bool reads(const void *p) const
+    {
+        return _left.reads(p) || _right.reads(p);
+    }
+
+    constexpr bool aliases(const void *p) const
+    {
+        return _left.aliases(p) || _right.aliases(p);
+    }
+
+    private:
+
+    typename expression_storage<L>::type _left;
+    typename expression_storage<R>::type _right;
+};
+
+/// \brief Negation of an expression.
+template <class E>
+class negate_expr : public matrix_expression<negate_expr<E>>
+{
+    public:
+
+    using value_type = typename E::value_type;
+
+    static constexpr size_t rows = E::rows;
+    static constexpr size_t cols = E::cols;
+
+    constexpr explicit negate_expr(const E &expr) : _expr(expr) { }
+
+    constexpr const E& expr() const { return _expr; }
+
+    constexpr bool reads(const void *p) const { return _expr.reads(p); }
+    constexpr bool aliases(const void *p) const { return _expr.aliases(p); }
+
+    private:
+
+    typename expression_storage<E>::type _expr;
+};
+
+/// \brief Multiplication of an expression by a scalar.
+template <class E>
+class scale_expr : public matrix_expression<scale_expr<E>>
+{
+    public:
+
+    using value_type = typename E::value_type;
+
+    static constexpr size_t rows = E::rows;
+    static constexpr size_t cols = E::cols;
+
+    constexpr scale_expr(const E &expr, const value_type &scalar)
+        : _expr(expr), _scalar(scalar) { }
+
+    constexpr const E& expr() const { return _expr; }
+    constexpr const value_type& scalar() const { return _scalar; }
+
+    constexpr bool reads(const void *p) const { return _expr.reads(p); }
+    constexpr bool aliases(const void *p) const { return _expr.aliases(p); }
+
+    private:
+
+    typename expression_storage<E>::type _expr;
+    value_type _scalar;
+};
+
+/// \brief Transpose of an expression. No data is moved; element
+/// (i, j) of the transpose is read as element (j, i) of the operand.
+template <class E>
+class transpose_expr : public matrix_expression<transpose_expr<E>>
+{
+    public:
+
+    using value_type = typename E::value_type;
+
+    static constexpr size_t rows = E::cols;
+    static constexpr size_t cols = E::rows;
+
+    constexpr explicit transpose_expr(const E &expr) : _expr(expr) { }
+
+    constexpr const E& expr() const { return _expr; }
+
+    constexpr bool reads(const void *p) const { return _expr.reads(p); }
+    constexpr bool aliases(const void *p) const { return _expr.reads(p); }
+
+    private:
+
+    typename expression_storage<E>::type _expr;
+};
+
+template <class E>
+struct is_direct<transpose_expr<E>> : is_direct<E> { };
+
+/// \brief Matrix product of two expressions.
+template <class L, class R>
+class product_expr : public matrix_expression<product_expr<L, R>>
+{
+    static_assert(L::cols == R::rows,
+        "Cannot multiply matrices of incompatible dimensions");
+    static_assert(std::is_same<typename L::value_type,
+                               typename R::value_type>::value,
+        "Cannot multiply matrices of different element types");
+
+    public:
+
+    using value_type = typename L::value_type;
+
+    static constexpr size_t rows = L::rows;
+    static constexpr size_t cols = R::cols;
+
+    constexpr product_expr(const L &left, const R &right)
+        : _left(left), _right(right) { }
+
+    constexpr const L& left() const { return _left; }
+    constexpr const R& right() const { return _right; }
+
+    constexpr bool reads(const void *p) const
+    {
+        return _left.reads(p) || _right.reads(p);
+    }
+
+    /// \brief Operands which are not direct are materialized before
+    /// anything is written, so only direct operands can alias.
+    constexpr bool aliases(const void *p) const
+    {
+        return (is_direct<L>::value && _left.reads(p)) ||
+               (is_direct<R>::value && _right.reads(p));
+    }
+
+    private:
+
+    typename expression_storage<L>::type _left;
+    typename expression_storage<R>::type _right;
+};
+
+template <size_t M, size_t N, class T> class evaluator<matrix<M, N, T>>
+{
+    public:
+
+    constexpr explicit evaluator(const matrix<M, N, T> &m) : _m(m) { }
+
+    constexpr T operator () (size_t i, size_t j) const
+    {
+        return _m(i, j);
+    }
+
+    private:
+
+    const matrix<M, N, T> &_m;
+};
+
+template <class L, class R> class evaluator<sum_expr<L, R>>
+{
+    public:
+
+    using value_type = typename sum_expr<L, R>::value_type;
+
+    constexpr explicit evaluator(const sum_expr<L, R> &e)
+        : _left(e.left()), _right(e.right()) { }
+
+    constexpr value_type operator () (size_t i, size_t j) const
+    {
+        return _left(i, j) + _right(i, j);
+    }
+
+    private:
+
+    evaluator<L> _left;
+    evaluator<R> _right;
+};
+
+template <class L, class R> class evaluator<difference_expr<L, R>>
+{
+    public:
+
+    using value_type = typename difference_expr<L, R>::value_type;
+
+    constexpr explicit evaluator(const difference_expr<L, R> &e)
+        : _left(e.left()), _right(e.right()) { }
+
+    constexpr value_type operator () (size_t i, size_t j) const
+    {
+        return _left(i, j) - _right(i, j);
+    }
+
+    private:
+
+    evaluator<L> _left;
+    evaluator<R> _right;
+};
+
+template <class E> class evaluator<negate_expr<E>>
+{
+    public:
+
+    using value_type = typename E::value_type;
+
+    constexpr explicit evaluator(const negate_expr<E> &e)
+        : _expr(e.expr()) { }
+
+    constexpr value_type operator () (size_t i, size_t j) const
+    {
+        return -_expr(i, j);
+    }
+
+    private:
+
+    evaluator<E> _expr;
+};
+
+template <class E> class evaluator<scale_expr<E>>
+{
+    public:
+
+    using value_type = typename E::value_type;
+
+    constexpr explicit evaluator(const scale_expr<E> &e)
+        : _expr(e.expr()), _scalar(e.scalar()) { }
+
+    constexpr value_type operator () (size_t i, size_t j) const
+    {
+        return _expr(i, j) * _scalar;
+    }
+
+    private:
+
+    evaluator<E> _expr;
+    value_type _scalar;
+};
+
+template <class E> class evaluator<transpose_expr<E>>
+{
+    public:
+
+    using value_type = typename E::value_type;
+
+    constexpr explicit evaluator(const transpose_expr<E> &e)
+        : _expr(e.expr()) { }
+
+    constexpr value_type operator () (size_t i, size_t j) const
+    {
+        return _expr(j, i);
+    }
+
+    private:
+
+    evaluator<E> _expr;
+};
+
+/// \brief Evaluates an expression once into a matrix it owns.
+template <class E> class materialized
+{
+    public:
+
+    using value_type = typename E::value_type;
+
+    constexpr explicit materialized(const E &e) : _value(e) { }
+
+    constexpr value_type operator () (size_t i, size_t j) const
+    {
+        return _value(i, j);
+    }
+
+    private:
+
+    matrix<E::rows, E::cols, value_type> _value;
+};
+
+/// \brief How a product reads its operands.
+template <class E> using product_operand = typename std::conditional<
+    is_direct<E>::value, evaluator<E>, materialized<E>>::type;
+
+template <class L, class R> class evaluator<product_expr<L, R>>
+{
+    public:
+
+    using value_type = typename product_expr<L, R>::value_type;
+
+    constexpr explicit evaluator(const product_expr<L, R> &e)
+        : _left(e.left()), _right(e.right()) { }
+
+    constexpr value_type operator () (size_t i, size_t j) const
+    {
+        value_type sum = value_type();
+        for (size_t k = 0; k < L::cols; ++k)
+        {
+            sum += _left(i, k) * _right(k, j);
+        }
+        return sum;
+    }
+
+    private:
+
+    product_operand<L> _left;
+    product_operand<R> _right;
+};
+
+/// \brief Addition of two matrices.
+template <class L, class R>
+constexpr sum_expr<L, R> operator + (const matrix_expression<L> &left,
+                                     const matrix_expression<R> &right)
+{
+    return sum_expr<L, R>(left.self(), right.self());
+}
+
+/// \brief Subtraction of two matrices.
+template <class L, class R>
+constexpr difference_expr<L, R> operator - (
+    const matrix_expression<L> &left, const matrix_expression<R> &right)
+{
+    return difference_expr<L, R>(left.self(), right.self());
+}
+
+/// \brief Negation of a matrix.
+template <class E>
+constexpr negate_expr<E> operator - (const matrix_expression<E> &m)
+{
+    return negate_expr<E>(m.self());
+}
+
+/// \brief Multiplication of two matrices.
+template <class L, class R>
+constexpr product_expr<L, R> operator * (
+    const matrix_expression<L> &left, const matrix_expression<R> &right)
+{
+    return product_expr<L, R>(left.self(), right.self());
+}
+
+/// \brief Whether S can scale a matrix with elements of type T.
+template <class S, class T> using is_scalar_of = std::integral_constant<
+    bool, !std::is_base_of<matrix_expression<S>, S>::value &&
+          std::is_convertible<S, T>::value>;
+
+/// \brief Multiplication of a matrix by a scalar.
+template <class E, class S, typename std::enable_if<
+    is_scalar_of<S, typename E::value_type>::value, int>::type = 0>
+constexpr scale_expr<E> operator * (const matrix_expression<E> &m, S scalar)
+{
+    return scale_expr<E>(m.self(), scalar);
+}
+
+/// \brief Multiplication of a matrix by a scalar.
+template <class E, class S, typename std::enable_if<
+    is_scalar_of<S, typename E::value_type>::value, int>::type = 0>
+constexpr scale_expr<E> operator * (S scalar, const matrix_expression<E> &m)
+{
+    return scale_expr<E>(m.self(), scalar);
+}
+
+/// \brief Division of a matrix by a scalar.
+template <class E, class S, typename std::enable_if<
+    is_scalar_of<S, typename E::value_type>::value, int>::type = 0>
+constexpr scale_expr<E> operator / (const matrix_expression<E> &m, S divisor)
+{
+    using T = typename E::value_type;
+    return scale_expr<E>(m.self(), T(1)/T(divisor));
+}
+
+/// \brief Get the transpose of a matrix.
+template <class E>
+constexpr transpose_expr<E> transpose(const matrix_expression<E> &m)
+{
+    return transpose_expr<E>(m.self());
+}
+
+/// \brief Evaluate an expression into a matrix.
+template <class E>
+constexpr matrix<E::rows, E::cols, typename E::value_type>
+eval(const matrix_expression<E> &e)
+{
+    return matrix<E::rows, E::cols, typename E::value_type>(e.self());
+}
+
+} // namespace lambda
+
+#endif // LAMBDA_EXPRESSION_HPP
@@ -0,0 +1,39 @@
+#ifndef LAMBDA_GEMM_HPP
+#define LAMBDA_GEMM_HPP
+
+#include <cstddef>
+
+#include "lambda/dynamic_matrix.hpp"
+
+/*!
+    \file
+    \brief Defines lambda::gemm, the general matrix multiply
+    C = alpha*A*B + beta*C, used for products of large matrices. A and B
+    are copied a block at a time into packed panels sized for the
+    caches, and each small tile of C is accumulated in registers by a
+    micro-kernel; with AVX2 and FMA, e.g. with --config=avx2, the kernel
+    is a 6x8 tile of fused multiply-adds, otherwise a 4x4 tile in SSE2
+    or scalar code.
+*/
+
+namespace lambda
+{
+
+/// \brief Computes C = alpha*A*B + beta*C, where A is MxK, B is KxN and
+/// C is MxN, all in row-major order with leading dimensions (the
+/// distance between the starts of consecutive rows) lda, ldb and ldc.
+/// C must not overlap A or B. If beta is zero, C is not read, so it
+/// need not be initialized.
+void gemm(size_t M, size_t N, size_t K, double alpha,
+          const double *A, size_t lda, const double *B, size_t ldb,
+          double beta, double *C, size_t ldc);
+
+/// \brief Computes C = alpha*A*B + beta*C, in place in the existing
+/// matrix C, which must already have the size of the product. C may be
+/// A or B, in which case the product is computed into a temporary.
+void gemm(double alpha, const dynamic_matrix &A, const dynamic_matrix &B,
+          double beta, dynamic_matrix &C);
+
+} // namespace lambda
+
+#endif // LAMBDA_GEMM_HPP
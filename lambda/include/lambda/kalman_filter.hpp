@@ -1,6 +1,11 @@
 #ifndef LAMBDA_KALMAN_FILTER_HPP
 #define LAMBDA_KALMAN_FILTER_HPP
 
+#include "lambda/matrix.hpp"
+#include "lambda/decomposition.hpp"
+#include "lambda/exponential.hpp"
+#include "lambda/packed.hpp"
+
 /*! 
     \file
     \brief Defines lambda::kalman_filter,
@@ -13,7 +18,8 @@ namespace lambda
 /// \brief A kalman filter implementation.
 /// \param M The dimensionality of measurements.
 /// \param N The dimensionality of state.
-template <size_t M, size_t N> class kalman_filter
+/// \param T The scalar type of states and measurements.
+template <size_t M, size_t N, class T = double> class kalman_filter
 {
     public:
 
@@ -21,13 +27,14 @@ template <size_t M, size_t N> class kalman_filter
     kalman_filter() { }
 
     /// \brief Constructs a new filter given several 
-    ///        members as initialization.
-    kalman_filter(const column_vector<N> &_initial_state,
-                  const matrix<N, N> &_initial_covariance,
-                  const matrix<N, N> &_state_transition,
-                  const matrix<N, M> &_measurement_model,
-                  const matrix<M, M> &_sensor_noise,
-                  const matrix<N, N> &_process_noise) :
+    ///        members as initialization. Covariances are
+    ///        stored as their symmetric parts.
+    kalman_filter(const column_vector<N, T> &_initial_state,
+                  const matrix<N, N, T> &_initial_covariance,
+                  const matrix<N, N, T> &_state_transition,
+                  const matrix<M, N, T> &_measurement_model,
+                  const matrix<M, M, T> &_sensor_noise,
+                  const matrix<N, N, T> &_process_noise) :
 
         state(_initial_state),
         state_covariance(_initial_covariance),
@@ -36,53 +43,68 @@ template <size_t M, size_t N> class kalman_filter
         sensor_noise(_sensor_noise),
         process_noise(_process_noise) { }
 
+    /// \brief Set the state transition model to exp(A dt), which
+    ///        advances the continuous-time system dx/dt = A x by a
+    ///        timestep dt. Call before predict() when the timestep
+    ///        varies.
+    void discretize(const matrix<N, N, T> &system, T dt)
+    {
+        state_transition = expm(matrix<N, N, T>(system * dt));
+    }
+
     /// \brief Propogate the state transition model and return
     ///        the new state estimate.
-    const column_vector<N>& predict()
+    const column_vector<N, T>& predict()
     {
         state = state_transition * state;
 
-        state_covariance = state_transition *
-            state_covariance * transpose(state_transition) +
-            process_noise;
+        state_covariance = symmetric_product(state_transition,
+            state_covariance) + process_noise;
 
         return state;
     }
 
-    /// \brief Update the state estimate with a measurement.
-    const column_vector<N>& update(const column_vector<M> &meas)
+    /// \brief Update the state estimate with a measurement. Throws
+    ///        std::domain_error if the innovation covariance is not
+    ///        positive definite.
+    const column_vector<N, T>& update(const column_vector<M, T> &meas)
     {
-        auto residual = meas - measurement_model*state;
+        const column_vector<M, T> residual =
+            meas - measurement_model*state;
 
-        auto innovation_covariance = sensor_noise +
-            measurement_model * state_covariance*
-            transpose(measurement_model);
+        const symmetric_matrix<M, T> innovation_covariance =
+            symmetric_product(measurement_model, state_covariance) +
+            sensor_noise;
 
-        auto kalman_gain = state_covariance *
-            transpose(measurement_model) *
-            transpose(innovation_covariance);
+        // The gain is K = P H^T S^-1. P and S are symmetric, so its
+        // transpose is S^-1 (H P), which is solved with the Cholesky
+        // factor of S rather than by inverting S.
+        const matrix<M, N, T> hp = measurement_model *
+            matrix<N, N, T>(state_covariance);
+        const matrix<N, M, T> kalman_gain = transpose(
+            cholesky_factorization<M, T>(innovation_covariance).solve(hp));
 
         state += kalman_gain * residual;
-        
-        state_covariance = (identity<N, N>() -
-            kalman_gain * measurement_model) *
-            state_covariance;
+
+        // (I - KH)P = P - K S K^T, whose second form is symmetric.
+        state_covariance -= symmetric_product(kalman_gain,
+                                              innovation_covariance);
 
         return state;
     }
 
     /// \brief The current state estimate.
-    column_vector<N> state;
+    column_vector<N, T> state;
     /// \brief The covariance matrix for the state estimate.
-    matrix<N, N> state_covariance;
+    symmetric_matrix<N, T> state_covariance;
     /// \brief The model for transition from current to future state.
-    matrix<N, N> state_transition;
+    matrix<N, N, T> state_transition;
     /// \brief The model for mapping state to measurements.
-    matrix<M, N> measurement_model;
+    matrix<M, N, T> measurement_model;
     /// \brief Covariance of sensor noise.
-    matrix<M, M> sensor_noise;
+    symmetric_matrix<M, T> sensor_noise;
     /// \brief Covariance of process noise.
-    matrix<N, N> process_noise;
+    symmetric_matrix<N, T> process_noise;
     
 };
 
@@ -93,8 +115,8 @@ template <size_t M, size_t N> class extended_kalman_filter { };
 template <size_t M, size_t N> class unscented_kalman_filter { };
 
 /// \brief Convenience typedef for kalman filter.
-template <size_t M, size_t N>
-using kf = kalman_filter<M, N>;
+template <size_t M, size_t N, class T = double>
+using kf = kalman_filter<M, N, T>;
 /// \brief Convenience typedef for extended kalman filter.
 template <size_t M, size_t N>
 using ekf = extended_kalman_filter<M, N>;
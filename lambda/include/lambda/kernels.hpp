@@ -0,0 +1,255 @@
+#ifndef LAMBDA_KERNELS_HPP
+#define LAMBDA_KERNELS_HPP
+
+#include <cstddef>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*!
+    \file
+    \brief Defines the kernels used to multiply small, statically sized
+    matrices stored in row-major order. For double elements, the sizes
+    which dominate rigid-body and filtering work are specialized to use
+    AVX2 or SSE2 when the compiler targets them, e.g. with
+    --config=avx2; every other size and element type, or a build without
+    SIMD, uses a scalar kernel.
+*/
+
+namespace lambda
+{
+
+namespace kernels
+{
+
+/// \brief Computes C = A*B, where A is MxN, B is NxP and C is MxP, all
+/// in row-major order, with elements of type T. C must not overlap A or
+/// B. Each row of C is accumulated from rows of B, so B is read
+/// contiguously.
+template <class T, size_t M, size_t N, size_t P> struct multiply
+{
+    static void apply(const T *a, const T *b, T *c)
+    {
+        for (size_t i = 0; i < M; ++i)
+        {
+            for (size_t j = 0; j < P; ++j)
+            {
+                c[P*i + j] = T();
+            }
+            for (size_t k = 0; k < N; ++k)
+            {
+                const T aik = a[N*i + k];
+                for (size_t j = 0; j < P; ++j)
+                {
+                    c[P*i + j] += aik * b[P*k + j];
+                }
+            }
+        }
+    }
+};
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
+namespace detail
+{
+
+#if defined(__AVX2__)
+/// \brief Lanes per vector register.
+constexpr size_t lanes = 4;
+#else
+constexpr size_t lanes = 2;
+#endif
+
+/// \brief Computes c += a*b over one vector of lanes.
+#if defined(__AVX2__)
+inline __m256d fmadd(__m256d a, __m256d b, __m256d c)
+{
+#if defined(__FMA__)
+    return _mm256_fmadd_pd(a, b, c);
+#else
+    return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+#endif
+}
+#endif
+
+inline __m128d fmadd(__m128d a, __m128d b, __m128d c)
+{
+#if defined(__FMA__)
+    return _mm_fmadd_pd(a, b, c);
+#else
+    return _mm_add_pd(_mm_mul_pd(a, b), c);
+#endif
+}
+
+/// \brief Computes one row of C = A*B, P columns wide. The row is split
+/// into full vectors, then a two-lane and a one-lane remainder; every
+/// loop has a compile-time trip count and is unrolled.
+template <size_t N, size_t P>
+inline void multiply_row(const double *a, const double *b, double *c)
+{
+    constexpr size_t full = P / lanes;
+    constexpr size_t rest = P % lanes;
+    constexpr size_t half = rest / 2;
+    constexpr size_t single = rest % 2;
+    constexpr size_t tail = full*lanes;
+
+#if defined(__AVX2__)
+    __m256d acc[full > 0 ? full : 1];
+#pragma GCC unroll 4
+    for (size_t v = 0; v < full; ++v) acc[v] = _mm256_setzero_pd();
+#else
+    __m128d acc[full > 0 ? full : 1];
+#pragma GCC unroll 8
+    for (size_t v = 0; v < full; ++v) acc[v] = _mm_setzero_pd();
+#endif
+    __m128d acc_half = _mm_setzero_pd();
+    double acc_single = 0;
+
+#pragma GCC unroll 16
+    for (size_t k = 0; k < N; ++k)
+    {
+        const double *row = b + P*k;
+#if defined(__AVX2__)
+        const __m256d aik = _mm256_broadcast_sd(a + k);
+#pragma GCC unroll 4
+        for (size_t v = 0; v < full; ++v)
+        {
+            acc[v] = fmadd(aik, _mm256_loadu_pd(row + 4*v), acc[v]);
+        }
+#else
+        const __m128d aik = _mm_set1_pd(a[k]);
+#pragma GCC unroll 8
+        for (size_t v = 0; v < full; ++v)
+        {
+            acc[v] = fmadd(aik, _mm_loadu_pd(row + 2*v), acc[v]);
+        }
+#endif
+        if (half)
+        {
+            acc_half = fmadd(_mm_set1_pd(a[k]),
+                _mm_loadu_pd(row + tail), acc_half);
+        }
+        if (single)
+        {
+            acc_single += a[k] * row[tail + 2*half];
+        }
+    }
+
+#pragma GCC unroll 8
+    for (size_t v = 0; v < full; ++v)
+    {
+#if defined(__AVX2__)
+        _mm256_storeu_pd(c + 4*v, acc[v]);
+#else
+        _mm_storeu_pd(c + 2*v, acc[v]);
+#endif
+    }
+    if (half) _mm_storeu_pd(c + tail, acc_half);
+    if (single) c[tail + 2*half] = acc_single;
+}
+
+/// \brief Sums the lanes of a vector.
+inline double horizontal_sum(__m128d v)
+{
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+#if defined(__AVX2__)
+inline double horizontal_sum(__m256d v)
+{
+    return horizontal_sum(_mm_add_pd(_mm256_castpd256_pd128(v),
+                                     _mm256_extractf128_pd(v, 1)));
+}
+#endif
+
+/// \brief Computes the dot product of two vectors of length N.
+template <size_t N>
+inline double dot(const double *a, const double *x)
+{
+    constexpr size_t full = N / lanes;
+    constexpr size_t tail = full*lanes;
+
+#if defined(__AVX2__)
+    __m256d acc = _mm256_setzero_pd();
+#pragma GCC unroll 4
+    for (size_t v = 0; v < full; ++v)
+    {
+        acc = fmadd(_mm256_loadu_pd(a + 4*v), _mm256_loadu_pd(x + 4*v), acc);
+    }
+    double sum = full > 0 ? horizontal_sum(acc) : 0;
+#else
+    __m128d acc = _mm_setzero_pd();
+#pragma GCC unroll 8
+    for (size_t v = 0; v < full; ++v)
+    {
+        acc = fmadd(_mm_loadu_pd(a + 2*v), _mm_loadu_pd(x + 2*v), acc);
+    }
+    double sum = full > 0 ? horizontal_sum(acc) : 0;
+#endif
+    if (N - tail >= 2)
+    {
+        sum += horizontal_sum(_mm_mul_pd(_mm_loadu_pd(a + tail),
+                                         _mm_loadu_pd(x + tail)));
+    }
+    if ((N - tail) % 2)
+    {
+        sum += a[N - 1] * x[N - 1];
+    }
+    return sum;
+}
+
+/// \brief SIMD kernel for C = A*B.
+template <size_t M, size_t N, size_t P> struct simd_multiply
+{
+    static void apply(const double *a, const double *b, double *c)
+    {
+#pragma GCC unroll 16
+        for (size_t i = 0; i < M; ++i)
+        {
+            multiply_row<N, P>(a + N*i, b, c + P*i);
+        }
+    }
+};
+
+/// \brief SIMD kernel for y = A*x; each element of y is the dot
+/// product of a contiguous row of A with x.
+template <size_t M, size_t N> struct simd_multiply<M, N, 1>
+{
+    static void apply(const double *a, const double *x, double *y)
+    {
+#pragma GCC unroll 16
+        for (size_t i = 0; i < M; ++i)
+        {
+            y[i] = dot<N>(a + N*i, x);
+        }
+    }
+};
+
+} // namespace detail
+
+template <> struct multiply<double, 3, 3, 3>
+    : detail::simd_multiply<3, 3, 3> { };
+template <> struct multiply<double, 4, 4, 4>
+    : detail::simd_multiply<4, 4, 4> { };
+template <> struct multiply<double, 6, 6, 6>
+    : detail::simd_multiply<6, 6, 6> { };
+template <> struct multiply<double, 9, 9, 9>
+    : detail::simd_multiply<9, 9, 9> { };
+
+template <> struct multiply<double, 3, 3, 1>
+    : detail::simd_multiply<3, 3, 1> { };
+template <> struct multiply<double, 4, 4, 1>
+    : detail::simd_multiply<4, 4, 1> { };
+template <> struct multiply<double, 6, 6, 1>
+    : detail::simd_multiply<6, 6, 1> { };
+template <> struct multiply<double, 9, 9, 1>
+    : detail::simd_multiply<9, 9, 1> { };
+
+#endif // defined(__AVX2__) || defined(__SSE2__)
+
+} // namespace kernels
+
+} // namespace lambda
+
+#endif // LAMBDA_KERNELS_HPP
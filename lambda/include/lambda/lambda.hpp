@@ -1,10 +1,22 @@
 #include "lambda/matrix.hpp"
+#include "lambda/view.hpp"
+#include "lambda/packed.hpp"          // symmetric, triangular
+#include "lambda/memory.hpp"          // arena, scoped_resource
 #include "lambda/dynamic_matrix.hpp"
+#include "lambda/gemm.hpp"            // C = alpha*A*B + beta*C
+#include "lambda/sparse_matrix.hpp"   // CSR
+#include "lambda/dynamic_factorization.hpp"   // LU, Cholesky, QR
+#include "lambda/parallel.hpp"        // thread count
+#include "lambda/matrix_batch.hpp"
+#include "lambda/serialization.hpp"   // binary encoding
+#include "lambda/mapped_matrix.hpp"   // file-backed, out of core
 #include "lambda/quaternion.hpp"
 #include "lambda/axis_angle.hpp"
+#include "lambda/rigid_transform.hpp"   // se3
 #include "lambda/norm.hpp"            // euclidian, frobenian
 #include "lambda/echelon.hpp"         // REF, RREF
-#include "lambda/decomposition.hpp"   // LU, LDU decomposition
+#include "lambda/exponential.hpp"     // matrix exponential
+#include "lambda/decomposition.hpp"   // LU, Cholesky, QR, SVD, eigen
 #include "lambda/complex.hpp"
 #include "lambda/levenshtein.hpp"
 #include "lambda/solve.hpp"
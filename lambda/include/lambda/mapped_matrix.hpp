@@ -0,0 +1,182 @@
+#ifndef LAMBDA_MAPPED_MATRIX_HPP
+#define LAMBDA_MAPPED_MATRIX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+
+#include "lambda/dynamic_matrix.hpp"
+#include "lambda/memory.hpp"
+
+/*!
+    \file
+    \brief Defines lambda::mapped_matrix, a matrix whose elements are a
+    file in the binary encoding of serialization.hpp, mapped into
+    memory rather than read. Opening one takes constant time whatever
+    its size; the operating system pages elements in as they are used,
+    and may drop unmodified pages again under memory pressure, so
+    matrices larger than memory can be used, by operations which work
+    through them a block at a time. Requires a POSIX system.
+*/
+
+namespace lambda
+{
+
+/// \brief How a mapped_matrix may change its file.
+enum class map_mode
+{
+    /// \brief The elements may only be read.
+    read_only,
+    /// \brief The elements may be changed, but changes are private to
+    /// the mapping and are never written to the file.
+    copy_on_write,
+    /// \brief Changes to the elements are written to the file.
+    read_write
+};
+
+/// \brief A matrix stored in a file mapped into memory, with the
+/// element access of dynamic_matrix. It is movable, but not copyable;
+/// use block() to copy elements into memory.
+class mapped_matrix
+{
+    public:
+
+    /// \brief Map a file holding an encoded matrix, as written by
+    /// lambda::write. Throws std::runtime_error if the file cannot be
+    /// opened or mapped, or is shorter than its header says, and
+    /// std::invalid_argument if it does not hold an encoded matrix.
+    explicit mapped_matrix(const std::string &path,
+                           map_mode mode = map_mode::read_only);
+
+    /// \brief Create, or truncate, a file holding a rows x columns
+    /// matrix of zeros, and map it read_write.
+    static mapped_matrix create(const std::string &path,
+                                size_t rows, size_t columns);
+
+    /// \brief Move constructor; other is left unmapped and 0x0.
+    mapped_matrix(mapped_matrix &&other) noexcept;
+
+    /// \brief Move assignment operator; other is left unmapped and 0x0.
+    mapped_matrix& operator = (mapped_matrix &&other) noexcept;
+
+    mapped_matrix(const mapped_matrix&) = delete;
+
+    mapped_matrix& operator = (const mapped_matrix&) = delete;
+
+    /// \brief Unmaps the file. Changes to a read_write map are written
+    /// back by the operating system.
+    ~mapped_matrix();
+
+    /// \brief Get the number of rows in this matrix.
+    size_t rows() const;
+
+    /// \brief Get the number of columns in this matrix.
+    size_t columns() const;
+
+    /// \brief Get how this matrix may change its file.
+    map_mode mode() const;
+
+    /// \brief Access an element in row i, column j.
+    double operator () (size_t i, size_t j) const;
+
+    /// \brief Get a reference to the element (i, j). Writing through
+    /// it is undefined for a read_only map.
+    double& operator () (size_t i, size_t j);
+
+    /// \brief Get the element at index i, interpreting the matrix
+    /// as a 1-dimensional array in a row-major fashion.
+    double operator [] (size_t i) const;
+
+    /// \brief Get a reference to the element at i, in the equivalent
+    /// 1-dimensional row-major array. Writing through it is undefined
+    /// for a read_only map.
+    double& operator [] (size_t i);
+
+    /// \brief Same as operator [], but throws an exception if
+    /// the index provided is out of bounds.
+    double at(size_t i) const;
+
+    /// \brief Same as operator [], but throws an exception if the index
+    /// provided is out of bounds, or the map is read_only.
+    double& at(size_t i);
+
+    /// \brief Same as operator (), but throws an exception if
+    /// the index provided is out of bounds.
+    double at(size_t i, size_t j) const;
+
+    /// \brief Same as operator (), but throws an exception if the index
+    /// provided is out of bounds, or the map is read_only.
+    double& at(size_t i, size_t j);
+
+    /// \brief Get a pointer to the elements, in row-major order.
+    const double* data() const;
+
+    /// \brief Get a pointer to the elements, in row-major order.
+    /// Writing through it is undefined for a read_only map.
+    double* data();
+
+    /// \brief Copy the rows x columns block whose top left element is
+    /// (row, column) into memory.
+    dynamic_matrix block(size_t row, size_t column,
+                         size_t rows, size_t columns,
+                         std::pmr::memory_resource *resource =
+                             matrix_resource()) const;
+
+    /// \brief Write changes to a read_write map to the file now, rather
+    /// than when the operating system chooses to.
+    void flush();
+
+    /// \brief Whether this matrix and other are mapped from the same
+    /// file, so that a write to one may change the other.
+    bool shares_file(const mapped_matrix &other) const;
+
+    private:
+
+    /// \brief Takes ownership of a mapping of the file identified by
+    /// device and inode.
+    mapped_matrix(void *map, size_t map_size, size_t rows, size_t columns,
+                  map_mode mode, uint64_t device, uint64_t inode);
+
+    /// \brief Throws an exception if an index is out of bounds.
+    void range_check(size_t i) const;
+
+    /// \brief Throws an exception if an index is out of bounds.
+    void range_check(size_t i, size_t j) const;
+
+    /// \brief Throws an exception if the map is read_only.
+    void write_check() const;
+
+    /// \brief The mapping, including the header, or null.
+    void *_map;
+    /// \brief The size of the mapping in bytes.
+    size_t _map_size;
+    size_t _rows, _columns;
+    map_mode _mode;
+    /// \brief The device and inode of the mapped file.
+    uint64_t _device, _inode;
+};
+
+/// \brief Computes C = A*B, where C must already have the size of the
+/// product, must not be read_only, and must not be mapped from the file
+/// of A or B, since C is written as they are read; an exception is
+/// thrown otherwise. The product is computed by gemm, which reads A and
+/// B a cache-sized block at a time, so only the blocks in use need be
+/// resident.
+void multiply(const mapped_matrix &A, const mapped_matrix &B,
+              mapped_matrix &C);
+
+/// \brief Computes the product of two mapped matrices into memory.
+dynamic_matrix operator * (const mapped_matrix &left,
+                           const mapped_matrix &right);
+
+/// \brief Writes the transpose of A to T, which must already have the
+/// transposed size, must not be read_only, and must not be mapped from
+/// the file of A; an exception is thrown otherwise. The transpose is
+/// copied in square tiles, so both the reads and the writes of each
+/// tile stay within a few pages.
+void transpose(const mapped_matrix &A, mapped_matrix &T);
+
+} // namespace lambda
+
+#endif // LAMBDA_MAPPED_MATRIX_HPP
@@ -3,10 +3,18 @@
 
 #include <array>
 #include <vector>
+#include <charconv>
 #include <cstdint>
 #include <iostream>
+#include <limits>
+#include <string>
 #include <iomanip>
 #include <sstream>
+#include <type_traits>
+
+#include "lambda/expression.hpp"
+#include "lambda/kernels.hpp"
+#include "lambda/scalar.hpp"
 
 /*!
     \file
@@ -18,6 +26,18 @@
 namespace lambda
 {
 
+/// \brief Whether the enclosing function is being evaluated at compile
+/// time. Without compiler support, this is conservatively true, so
+/// that constexpr evaluation never reaches the SIMD kernels.
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define LAMBDA_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#endif
+#ifndef LAMBDA_IS_CONSTANT_EVALUATED
+#define LAMBDA_IS_CONSTANT_EVALUATED() true
+#endif
+
 /// \brief Forward declaration of lambda::quaternion.
 class quaternion;
 /// \brief Forward declaratuin of lambda::axis_angle.
@@ -25,25 +45,47 @@ class axis_angle;
 
 /// \brief A statically sized matrix class. Supports basic operations like
 /// addition, multiplication. Is default-constructable, copy-constructable,
-/// and is constructable from quaternions and axis-angles.
-template <size_t M, size_t N> class matrix
+/// and is constructable from quaternions and axis-angles. Arithmetic on
+/// matrices produces expressions (see lambda/expression.hpp) which are
+/// evaluated when assigned to, or used to construct, a matrix. Elements
+/// are of type T, which is double unless specified otherwise.
+template <size_t M, size_t N, class T> class matrix
+    : public matrix_expression<matrix<M, N, T>>
 {
     static_assert(M > 0 && N > 0,
         "Cannot create matrix of dimension 0");
 
     public:
 
+    /// \brief The type of the elements of this matrix.
+    using value_type = T;
+
+    /// \brief The number of rows.
+    static constexpr size_t rows = M;
+    /// \brief The number of columns.
+    static constexpr size_t cols = N;
+
     /// \brief Default constructor.
-    matrix() : _data() { }
+    constexpr matrix() : _data() { }
 
     /// \brief Copy constructor.
-    matrix(const matrix<M, N> &other) : _data(other.data()) { }
+    constexpr matrix(const matrix<M, N, T> &other) : _data(other.data()) { }
 
     /// \brief Construct a MxN matrix with a list of M*N elements.
     /// Elements are listed in row-major order.
-    template <typename ...T, typename std::enable_if<
-        sizeof...(T) == M*N, int>::type = 0>
-    matrix(T... args) : _data({static_cast<double>(args)...}) { }
+    template <typename ...A, typename std::enable_if<
+        sizeof...(A) == M*N &&
+        std::conjunction<std::is_convertible<A, T>...>::value,
+        int>::type = 0>
+    constexpr matrix(A... args) : _data({static_cast<T>(args)...}) { }
+
+    /// \brief Construct a matrix by evaluating an expression.
+    template <class E, typename std::enable_if<
+        E::rows == M && E::cols == N, int>::type = 0>
+    constexpr matrix(const matrix_expression<E> &e) : _data()
+    {
+        assign(e.self());
+    }
 
     /// \brief Construct a matrix from a quaternion. Only unit quaternions
     /// are guaranteed to produce valid rotation matrices.
@@ -53,7 +95,7 @@ template <size_t M, size_t N> class matrix
     matrix(const axis_angle &aa);
 
     /// \brief Assignment operator.
-    matrix<M, N>& operator = (const matrix<M, N> &m)
+    constexpr matrix<M, N, T>& operator = (const matrix<M, N, T> &m)
     {
         for (size_t i = 0; i < M*N; ++i)
         {
@@ -62,35 +104,113 @@ template <size_t M, size_t N> class matrix
         return *this;
     }
 
+    /// \brief Assign the result of an expression to this matrix. If the
+    /// expression reads this matrix in a way that would be corrupted by
+    /// writing to it in place, it is evaluated into a temporary first.
+    template <class E>
+    constexpr matrix<M, N, T>& operator = (const matrix_expression<E> &e)
+    {
+        static_assert(E::rows == M && E::cols == N,
+            "Cannot assign expression of different dimensions");
+        if (e.self().aliases(this))
+        {
+            return *this = matrix<M, N, T>(e);
+        }
+        assign(e.self());
+        return *this;
+    }
+
+    /// \brief Add an expression to this matrix in place.
+    template <class E>
+    constexpr matrix<M, N, T>& operator += (const matrix_expression<E> &e)
+    {
+        static_assert(E::rows == M && E::cols == N,
+            "Cannot add matrices of different dimensions");
+        if (e.self().aliases(this))
+        {
+            return *this += matrix<M, N, T>(e);
+        }
+        evaluator<E> ev(e.self());
+        for (size_t i = 0; i < M; ++i)
+        {
+            for (size_t j = 0; j < N; ++j)
+            {
+                _data[N*i + j] += ev(i, j);
+            }
+        }
+        return *this;
+    }
+
+    /// \brief Subtract an expression from this matrix in place.
+    template <class E>
+    constexpr matrix<M, N, T>& operator -= (const matrix_expression<E> &e)
+    {
+        static_assert(E::rows == M && E::cols == N,
+            "Cannot subtract matrices of different dimensions");
+        if (e.self().aliases(this))
+        {
+            return *this -= matrix<M, N, T>(e);
+        }
+        evaluator<E> ev(e.self());
+        for (size_t i = 0; i < M; ++i)
+        {
+            for (size_t j = 0; j < N; ++j)
+            {
+                _data[N*i + j] -= ev(i, j);
+            }
+        }
+        return *this;
+    }
+
+    /// \brief Multiply this matrix by a scalar in place.
+    template <class S, typename std::enable_if<
+        is_scalar_of<S, T>::value, int>::type = 0>
+    constexpr matrix<M, N, T>& operator *= (S scalar)
+    {
+        for (size_t i = 0; i < M*N; ++i)
+        {
+            _data[i] *= scalar;
+        }
+        return *this;
+    }
+
+    /// \brief Divide this matrix by a scalar in place.
+    template <class S, typename std::enable_if<
+        is_scalar_of<S, T>::value, int>::type = 0>
+    constexpr matrix<M, N, T>& operator /= (S divisor)
+    {
+        return *this *= T(1)/T(divisor);
+    }
+
     /// \brief Access an element in row i, column j.
-    double operator () (size_t i, size_t j) const
+    constexpr T operator () (size_t i, size_t j) const
     {
         return _data[N*i + j];
     }
 
     /// \brief Get a reference to the element (i, j).
-    double& operator () (size_t i, size_t j)
+    constexpr T& operator () (size_t i, size_t j)
     {
         return _data[N*i + j];
     }
 
     /// \brief Get the element at index i, interpreting the matrix
     /// as a 1-dimensional array in a row-major fashion.
-    double operator [] (size_t i) const
+    constexpr T operator [] (size_t i) const
     {
         return _data[i];
     }
 
     /// \brief Get a reference to the element at i, in the
     /// equivalent 1-dimensional row-major array.
-    double& operator [] (size_t i)
+    constexpr T& operator [] (size_t i)
     {
         return _data[i];
     }
 
     /// \brief Same as operator [], but throws an exception if
     /// the index provided is out of bounds.
-    double at(size_t i) const
+    constexpr T at(size_t i) const
     {
         range_check(i);
         return _data[i];
@@ -98,7 +218,7 @@ template <size_t M, size_t N> class matrix
 
     /// \brief Same as operator [], but throws an exception if
     /// the index provided is out of bounds.
-    double& at(size_t i)
+    constexpr T& at(size_t i)
     {
         range_check(i);
         return _data[i];
@@ -106,7 +226,7 @@ template <size_t M, size_t N> class matrix
 
     /// \brief Same as operator (), but throws an exception if
     /// the index provided is out of bounds.
-    double at(size_t i, size_t j) const
+    constexpr T at(size_t i, size_t j) const
     {
         range_check(i, j);
         return _data[N*i + j];
@@ -114,220 +234,344 @@ template <size_t M, size_t N> class matrix
 
     /// \brief Same as operator (), but throws an exception if
     /// the index provided is out of bounds.
-    double& at(size_t i, size_t j)
+    constexpr T& at(size_t i, size_t j)
     {
         range_check(i, j);
         return _data[N*i + j];
     }
 
     /// \brief Get a const ref to the underlying data of this matrix.
-    const std::array<double, M*N>& data() const
+    constexpr const std::array<T, M*N>& data() const
     {
         return _data;
     }
 
+    /// \brief Whether this matrix is the matrix at p.
+    constexpr bool reads(const void *p) const
+    {
+        return p == static_cast<const void*>(this);
+    }
+
+    /// \brief A matrix is read element by element in the order it is
+    /// written, so it never aliases its destination.
+    constexpr bool aliases(const void*) const
+    {
+        return false;
+    }
+
     private:
 
     /// \brief Matrix elements stored here.
-    std::array<double, M*N> _data;
+    std::array<T, M*N> _data;
 
-    /// \brief Throws an exception if an index is out of bounds.
-    static void range_check(size_t i)
+    /// \brief Evaluate an expression directly into this matrix.
+    template <class E> constexpr void assign(const E &e)
+    {
+        assign_elements(e);
+    }
+
+    /// \brief Evaluate a product directly into this matrix. Unless an
+    /// operand is a transpose, which is read through its index mapping,
+    /// both operands are brought into row-major storage and multiplied
+    /// by the kernel for their dimensions.
+    template <class L, class R>
+    constexpr void assign(const product_expr<L, R> &e)
     {
-        if (i >= N*M)
+        constexpr bool left_stored = std::is_same<L,
+            matrix<L::rows, L::cols, T>>::value || !is_direct<L>::value;
+        constexpr bool right_stored = std::is_same<R,
+            matrix<R::rows, R::cols, T>>::value || !is_direct<R>::value;
+
+        if constexpr (left_stored && right_stored)
         {
-            std::stringstream ss;
-            ss << "Cannot access element (" << i
-                << ") of " << M << "x" << N << "matrix";
-            throw std::out_of_range(ss.str());
+            if (LAMBDA_IS_CONSTANT_EVALUATED())
+            {
+                assign_elements(e);
+                return;
+            }
+            const matrix<L::rows, L::cols, T> &left = e.left();
+            const matrix<R::rows, R::cols, T> &right = e.right();
+            kernels::multiply<T, M, L::cols, N>::apply(
+                left.data().data(), right.data().data(), _data.data());
+        }
+        else
+        {
+            assign_elements(e);
         }
     }
 
-    /// \brief Throws an exception if an index is out of bounds.
-    static void range_check(size_t i, size_t j)
+    /// \brief Evaluate an expression into this matrix element-wise.
+    template <class E> constexpr void assign_elements(const E &e)
     {
-        if (N*i + j >= N*M)
+        evaluator<E> ev(e);
+        for (size_t i = 0; i < M; ++i)
         {
-            std::stringstream ss;
-            ss << "Cannot access element (" << i << ", " << j
-                << ") of " << M << "x" << N << " matrix";
-            throw std::out_of_range(ss.str());
+            for (size_t j = 0; j < N; ++j)
+            {
+                _data[N*i + j] = ev(i, j);
+            }
         }
     }
+
+    /// \brief Throws an exception if an index is out of bounds.
+    static constexpr void range_check(size_t i)
+    {
+        if (i >= N*M) out_of_range(i);
+    }
+
+    /// \brief Throws an exception if an index is out of bounds.
+    static constexpr void range_check(size_t i, size_t j)
+    {
+        if (N*i + j >= N*M) out_of_range(i, j);
+    }
+
+    /// \brief Throws the exception for an out of bounds index.
+    [[noreturn]] static void out_of_range(size_t i)
+    {
+        std::stringstream ss;
+        ss << "Cannot access element (" << i
+            << ") of " << M << "x" << N << "matrix";
+        throw std::out_of_range(ss.str());
+    }
+
+    /// \brief Throws the exception for an out of bounds index.
+    [[noreturn]] static void out_of_range(size_t i, size_t j)
+    {
+        std::stringstream ss;
+        ss << "Cannot access element (" << i << ", " << j
+            << ") of " << M << "x" << N << " matrix";
+        throw std::out_of_range(ss.str());
+    }
 };
 
-template <size_t M, size_t N>
-bool operator == (const matrix<M, N> &left, const matrix<M, N> &right)
+/// \brief Exact element-wise comparison of two matrices.
+template <class L, class R>
+constexpr bool operator == (const matrix_expression<L> &left,
+                  const matrix_expression<R> &right)
 {
-    for (size_t i = 0; i < M*N; ++i)
+    static_assert(L::rows == R::rows && L::cols == R::cols,
+        "Cannot compare matrices of different dimensions");
+    evaluator<L> l(left.self());
+    evaluator<R> r(right.self());
+    for (size_t i = 0; i < L::rows; ++i)
     {
-        if (left[i] != right[i]) return false;
+        for (size_t j = 0; j < L::cols; ++j)
+        {
+            if (l(i, j) != r(i, j)) return false;
+        }
     }
     return true;
 }
 
 /// \brief Convenience typedef for column vectors.
-template <size_t N> using column_vector = matrix<N, 1>;
+template <size_t N, class T = double> using column_vector = matrix<N, 1, T>;
 /// \brief Convenience typedef for row vectors.
-template <size_t N> using row_vector = matrix<1, N>;
+template <size_t N, class T = double> using row_vector = matrix<1, N, T>;
 /// \brief Convenience typedef; default vectors are column vectors.
-template <size_t N> using vector = column_vector<N>;
+template <size_t N, class T = double> using vector = column_vector<N, T>;
 
 /// \brief X basis vector.
-const static column_vector<3> unitx(1, 0, 0);
+inline constexpr column_vector<3> unitx(1, 0, 0);
 /// \brief Y basis vector.
-const static column_vector<3> unity(0, 1, 0);
+inline constexpr column_vector<3> unity(0, 1, 0);
 /// \brief Z basis vector.
-const static column_vector<3> unitz(0, 0, 1);
+inline constexpr column_vector<3> unitz(0, 0, 1);
 
 /// \brief Gets the identity vector of a given dimension.
-template <size_t M, size_t N> matrix<M, N> identity()
+template <size_t M, size_t N, class T = double>
+constexpr matrix<M, N, T> identity()
 {
-    matrix<M, N> ret;
+    matrix<M, N, T> ret;
     for (size_t i = 0; i < M && i < N; ++i)
     {
-        ret(i, i) = 1;
+        ret(i, i) = T(1);
     }
     return ret;
 }
 
-/// \brief Print a matrix to a std::ostream.
-template <size_t M, size_t N>
-std::ostream& operator << (std::ostream &os, const matrix<M, N> &m)
+namespace detail
 {
-    os.precision(3);
-    os.setf(std::ios::fixed);
-    os << "[";
-    for (size_t i = 0; i < M; ++i)
+
+/// \brief The number of decimal places in the text of a matrix.
+constexpr int print_precision = 3;
+
+/// \brief An upper bound on the length of the text of one element:
+/// every digit of the largest value, a sign, a point and the decimal
+/// places. Other element types, such as lambda::complex, are written
+/// as at most two doubles and a few more characters.
+template <class T, class = void> struct element_chars
+    : std::integral_constant<size_t, 2*(std::numeric_limits<double>::
+                                        max_exponent10 + 4 + print_precision)
+                                     + 4> { };
+
+template <class T> struct element_chars<T,
+    typename std::enable_if<std::is_floating_point<T>::value>::type>
+    : std::integral_constant<size_t, std::numeric_limits<T>::max_exponent10
+                                     + 4 + print_precision> { };
+
+template <class T> struct element_chars<T,
+    typename std::enable_if<std::is_integral<T>::value>::type>
+    : std::integral_constant<size_t, std::numeric_limits<T>::digits10 + 3>
+    { };
+
+/// \brief Write the text of one element. Reals are written in fixed
+/// notation with print_precision decimal places; any other element
+/// type provides a to_chars overload, found by argument-dependent
+/// lookup.
+template <class T>
+std::to_chars_result format_element(char *first, char *last, const T &x)
+{
+    if constexpr (std::is_floating_point<T>::value)
     {
-        for (size_t j = 0; j < N; ++j)
-        {
-            os << +m(i, j);
-            if (j < N - 1) os << ", ";
-        }
-        if (i < M - 1) os << "; ";
+        return std::to_chars(first, last, x, std::chars_format::fixed,
+                             print_precision);
+    }
+    else if constexpr (std::is_integral<T>::value)
+    {
+        return std::to_chars(first, last, x);
+    }
+    else
+    {
+        return to_chars(first, last, x);
     }
-    return os << "]";
 }
 
-/// \brief Produces a multiline string representation of a matrix.
-template <size_t M, size_t N>
-std::string pretty(const matrix<M, N> &m)
+/// \brief Copy a null-terminated string.
+inline std::to_chars_result format_text(char *first, char *last,
+                                        const char *text)
 {
-    std::stringstream ss;
-    ss.precision(3);
-    ss.setf(std::ios::fixed);
-
-    size_t max_len = 0;
-    for (size_t i = 0; i < M*N; ++i)
+    for (; *text; ++text, ++first)
     {
-        std::stringstream tiny;
-        tiny.precision(3);
-        tiny.setf(std::ios::fixed);
-        tiny << m[i];
-        size_t len = tiny.tellp();
-        if (len > max_len) max_len = len;
+        if (first == last) return { last, std::errc::value_too_large };
+        *first = *text;
     }
+    return { first, std::errc() };
+}
 
-    for (size_t r = 0; r < M; ++r)
+/// \brief Write the text of an MxN matrix, whose element (i, j) is
+/// element(i, j), as [a, b; c, d].
+template <class F> std::to_chars_result format_matrix(char *first,
+    char *last, size_t M, size_t N, F element)
+{
+    std::to_chars_result r = format_text(first, last, "[");
+    for (size_t i = 0; i < M && r.ec == std::errc(); ++i)
     {
-        ss << "  [";
-        for (size_t c = 0; c < N; ++c)
+        for (size_t j = 0; j < N && r.ec == std::errc(); ++j)
+        {
+            r = format_element(r.ptr, last, element(i, j));
+            if (j < N - 1 && r.ec == std::errc())
+            {
+                r = format_text(r.ptr, last, ", ");
+            }
+        }
+        if (i < M - 1 && r.ec == std::errc())
         {
-            ss << std::setw(max_len + 1) << m(r, c);
+            r = format_text(r.ptr, last, "; ");
         }
-        ss << " ]\n";
     }
-    return ss.str();
+    return r.ec == std::errc() ? format_text(r.ptr, last, "]") : r;
 }
 
-/// \brief Multiplication of a matrix by a scalar.
-template <size_t M, size_t N, class T>
-matrix<M, N> operator * (const matrix<M, N> &m, T scalar)
+/// \brief Print the text of an MxN matrix to a stream, one element at a
+/// time through a buffer on the stack. The stream's formatting state is
+/// neither used nor changed.
+template <class F>
+std::ostream& print_matrix(std::ostream &os, size_t M, size_t N, F element)
 {
-    auto ret = m;
+    using T = typename std::decay<decltype(element(0, 0))>::type;
+    std::array<char, element_chars<T>::value> buffer;
+    char *first = buffer.data(), *last = first + buffer.size();
+    os.put('[');
     for (size_t i = 0; i < M; ++i)
     {
         for (size_t j = 0; j < N; ++j)
         {
-            ret(i, j) *= scalar;
+            os.write(first, format_element(first, last, element(i, j)).ptr
+                            - first);
+            if (j < N - 1) os.write(", ", 2);
         }
+        if (i < M - 1) os.write("; ", 2);
     }
-    return ret;
+    return os.put(']');
 }
 
-/// \brief Multiplication of a matrix by a scalar.
-template <size_t M, size_t N, class T>
-matrix<M, N> operator * (T scalar, const matrix<M, N> &m)
+/// \brief Produces the multiline text of an MxN matrix, with the
+/// elements right-aligned in columns of equal width.
+template <class F>
+std::string pretty_matrix(size_t M, size_t N, F element)
 {
-    return m*scalar;
-}
+    using T = typename std::decay<decltype(element(0, 0))>::type;
+    std::array<char, element_chars<T>::value> buffer;
+    char *first = buffer.data(), *last = first + buffer.size();
 
-/// \brief Division of a matrix by a scalar.
-template <size_t M, size_t N, class T>
-matrix<M, N> operator / (const matrix<M, N> &m, T divisor)
-{
-    return m*(1.0/divisor);
-}
-
-/// \brief Addition of two matrices.
-template <size_t M, size_t N>
-matrix<M, N> operator + (const matrix<M, N> &left,
-                         const matrix<M, N> &right)
-{
-    matrix<M, N> ret;
+    size_t max_len = 0;
     for (size_t i = 0; i < M; ++i)
     {
         for (size_t j = 0; j < N; ++j)
         {
-            ret(i, j) = left(i, j) + right(i, j);
+            const size_t len =
+                format_element(first, last, element(i, j)).ptr - first;
+            if (len > max_len) max_len = len;
         }
     }
-    return ret;
-}
 
-/// \brief Multiplication of two matrices.
-template <size_t M, size_t N, size_t P>
-matrix<M, P> operator * (const matrix<M, N> &left,
-                         const matrix<N, P> &right)
-{
-    matrix<M, P> ret;
+    std::string s;
+    s.reserve(M*(N*(max_len + 1) + 5));
     for (size_t i = 0; i < M; ++i)
     {
-        for (size_t j = 0; j < P; ++j)
+        s += "  [";
+        for (size_t j = 0; j < N; ++j)
         {
-            double sum = 0;
-            for (size_t k = 0; k < N; ++k)
-            {
-                sum += left(i, k) * right(k, j);
-            }
-            ret(i, j) = sum;
+            const size_t len =
+                format_element(first, last, element(i, j)).ptr - first;
+            s.append(max_len + 1 - len, ' ');
+            s.append(first, len);
         }
+        s += " ]\n";
     }
-    return ret;
+    return s;
+}
+
+} // namespace detail
+
+/// \brief Write the text of a matrix, as printed by operator <<, into
+/// the buffer [first, last) without allocating. Returns one past the
+/// last character written, and no error; if the text does not fit,
+/// returns last and std::errc::value_too_large, and the contents of the
+/// buffer are unspecified. The text does not depend on the locale.
+template <class E> std::to_chars_result to_chars(char *first, char *last,
+                                                 const matrix_expression<E> &e)
+{
+    evaluator<E> m(e.self());
+    return detail::format_matrix(first, last, E::rows, E::cols,
+        [&m] (size_t i, size_t j) { return m(i, j); });
 }
 
-/// \brief Get the transpose of a matrix.
-template <size_t M, size_t N>
-matrix<N, M> transpose(const matrix<M, N> &m)
+/// \brief Print a matrix to a std::ostream, with three decimal places.
+/// The stream's precision and flags are left unchanged.
+template <class E>
+std::ostream& operator << (std::ostream &os, const matrix_expression<E> &e)
 {
-    matrix<N, M> ret;
-    for (size_t i = 0; i < M; ++i)
-    {
-        for (size_t j = 0; j < N; ++j)
-        {
-            ret(j, i) = m(i, j);
-        }
-    }
-    return ret;
+    evaluator<E> m(e.self());
+    return detail::print_matrix(os, E::rows, E::cols,
+        [&m] (size_t i, size_t j) { return m(i, j); });
+}
+
+/// \brief Produces a multiline string representation of a matrix.
+template <class E>
+std::string pretty(const matrix_expression<E> &e)
+{
+    const matrix<E::rows, E::cols, typename E::value_type> m(e);
+    return detail::pretty_matrix(E::rows, E::cols,
+        [&m] (size_t i, size_t j) { return m(i, j); });
 }
 
 /// \brief Augment a matrix with another matrix.
-template <size_t M, size_t N, size_t P>
-matrix<M, N + P> augment(const matrix<M, N> &A,
-                         const matrix<M, P> &x)
+template <size_t M, size_t N, size_t P, class T>
+constexpr matrix<M, N + P, T> augment(const matrix<M, N, T> &A,
+                                      const matrix<M, P, T> &x)
 {
-    matrix<M, N + P> ret;
+    matrix<M, N + P, T> ret;
     for (size_t r = 0; r < M; ++r)
     {
         for (size_t c = 0; c < N + P; ++c)
@@ -340,41 +584,201 @@ matrix<M, N + P> augment(const matrix<M, N> &A,
 }
 
 
-/// \brief Compute the determinant of a square matrix.
-template <size_t N> double det(const matrix<N, N> &m)
+namespace detail
+{
+
+/// \brief Factors a square matrix in place into PA = LU, using partial
+/// pivoting. On return, the strictly lower triangle of a holds L (whose
+/// diagonal is all ones), and the upper triangle holds U. Row i of PA is
+/// row perm[i] of A. Returns the sign of the permutation, or 0 if a
+/// zero pivot shows A to be singular, in which case a is left partially
+/// factored.
+template <size_t N, class T>
+constexpr int lu_factor(matrix<N, N, T> &a, std::array<size_t, N> &perm)
 {
-    double sum = 0;
+    using traits = scalar_traits<T>;
+
+    int sign = 1;
     for (size_t i = 0; i < N; ++i)
     {
-        double top = m(0, i);
-        matrix<N-1, N-1> sub;
+        perm[i] = i;
+    }
 
-        for (size_t r = 1; r < N; ++r)
+    for (size_t k = 0; k < N; ++k)
+    {
+        size_t pivot = k;
+        auto largest = traits::magnitude(a(k, k));
+        for (size_t r = k + 1; r < N; ++r)
         {
-            size_t j = 0;
-            for (size_t c = 0; c < N - 1; ++c, ++j)
+            auto mag = traits::magnitude(a(r, k));
+            if (mag > largest)
             {
-                if (j == i) ++j;
-                sub(r - 1, c) = m.at(r, j);
+                largest = mag;
+                pivot = r;
             }
         }
+        if (a(pivot, k) == T(0))
+        {
+            return 0;
+        }
+        if (pivot != k)
+        {
+            for (size_t c = 0; c < N; ++c)
+            {
+                T tmp = a(k, c);
+                a(k, c) = a(pivot, c);
+                a(pivot, c) = tmp;
+            }
+            size_t tmp = perm[k];
+            perm[k] = perm[pivot];
+            perm[pivot] = tmp;
+            sign = -sign;
+        }
 
-        double d = det(sub);
-        sum += (top*d * (i % 2 == 0 ? 1 : -1));
+        const T inv_pivot = T(1)/a(k, k);
+#pragma GCC unroll 16
+        for (size_t r = k + 1; r < N; ++r)
+        {
+            const T l = a(r, k) * inv_pivot;
+            a(r, k) = l;
+#pragma GCC unroll 16
+            for (size_t c = k + 1; c < N; ++c)
+            {
+                a(r, c) -= l * a(k, c);
+            }
+        }
     }
-    return sum;
+    return sign;
+}
+
+/// \brief The determinant of a matrix factored by lu_factor.
+template <size_t N, class T>
+constexpr T lu_det(const matrix<N, N, T> &lu, int sign)
+{
+    if (sign == 0)
+    {
+        return T(0);
+    }
+    T product = lu(0, 0);
+    for (size_t i = 1; i < N; ++i)
+    {
+        product *= lu(i, i);
+    }
+    return sign > 0 ? product : -product;
+}
+
+/// \brief Solves AX = B, given the LU factorization of a nonsingular A
+/// from lu_factor. X is found a whole row at a time, so that the inner
+/// loops run along contiguous rows; every loop has a bound known at
+/// compile time, and is unrolled for small N and P.
+template <size_t N, size_t P, class T>
+constexpr matrix<N, P, T> lu_solve(const matrix<N, N, T> &lu,
+                                   const std::array<size_t, N> &perm,
+                                   const matrix<N, P, T> &b)
+{
+    matrix<N, P, T> x;
+    // Forward substitution, L Y = PB.
+#pragma GCC unroll 16
+    for (size_t r = 0; r < N; ++r)
+    {
+#pragma GCC unroll 16
+        for (size_t c = 0; c < P; ++c)
+        {
+            x(r, c) = b(perm[r], c);
+        }
+#pragma GCC unroll 16
+        for (size_t k = 0; k < r; ++k)
+        {
+            const T l = lu(r, k);
+#pragma GCC unroll 16
+            for (size_t c = 0; c < P; ++c)
+            {
+                x(r, c) -= l * x(k, c);
+            }
+        }
+    }
+    // Back substitution, U X = Y.
+#pragma GCC unroll 16
+    for (size_t i = 1; i <= N; ++i)
+    {
+        const size_t r = N - i;
+#pragma GCC unroll 16
+        for (size_t k = r + 1; k < N; ++k)
+        {
+            const T u = lu(r, k);
+#pragma GCC unroll 16
+            for (size_t c = 0; c < P; ++c)
+            {
+                x(r, c) -= u * x(k, c);
+            }
+        }
+        const T inv_pivot = T(1)/lu(r, r);
+#pragma GCC unroll 16
+        for (size_t c = 0; c < P; ++c)
+        {
+            x(r, c) *= inv_pivot;
+        }
+    }
+    return x;
+}
+
+} // namespace detail
+
+/// \brief Compute the determinant of a square matrix. Uses an LU
+/// factorization with partial pivoting, which takes O(N^3) time.
+template <size_t N, class T> constexpr T det(const matrix<N, N, T> &m)
+{
+    matrix<N, N, T> lu = m;
+    std::array<size_t, N> perm{};
+    int sign = detail::lu_factor(lu, perm);
+    return detail::lu_det(lu, sign);
+}
+
+/// \brief Compute the determinant of a 4x4 matrix, from the 2x2 minors
+/// of its top and bottom halves.
+template <class T> constexpr T det(const matrix<4, 4, T> &m)
+{
+    const T s0 = m(0,0)*m(1,1) - m(1,0)*m(0,1);
+    const T s1 = m(0,0)*m(1,2) - m(1,0)*m(0,2);
+    const T s2 = m(0,0)*m(1,3) - m(1,0)*m(0,3);
+    const T s3 = m(0,1)*m(1,2) - m(1,1)*m(0,2);
+    const T s4 = m(0,1)*m(1,3) - m(1,1)*m(0,3);
+    const T s5 = m(0,2)*m(1,3) - m(1,2)*m(0,3);
+
+    const T c5 = m(2,2)*m(3,3) - m(3,2)*m(2,3);
+    const T c4 = m(2,1)*m(3,3) - m(3,1)*m(2,3);
+    const T c3 = m(2,1)*m(3,2) - m(3,1)*m(2,2);
+    const T c2 = m(2,0)*m(3,3) - m(3,0)*m(2,3);
+    const T c1 = m(2,0)*m(3,2) - m(3,0)*m(2,2);
+    const T c0 = m(2,0)*m(3,1) - m(3,0)*m(2,1);
+
+    return s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+}
+
+/// \brief Compute the determinant of a 3x3 matrix.
+template <class T> constexpr T det(const matrix<3, 3, T> &m)
+{
+    return m(0,0)*(m(1,1)*m(2,2) - m(1,2)*m(2,1))
+         - m(0,1)*(m(1,0)*m(2,2) - m(1,2)*m(2,0))
+         + m(0,2)*(m(1,0)*m(2,1) - m(1,1)*m(2,0));
 }
 
 /// \brief Compute the determinant of a 2x2 matrix.
-double det(const matrix<2, 2> &m);
+template <class T> constexpr T det(const matrix<2, 2, T> &m)
+{
+    return m(0,0)*m(1,1) - m(0,1)*m(1,0);
+}
 
 /// \brief Compute the determinant of a 1x1 matrix.
-double det(const matrix<1, 1> &m);
+template <class T> constexpr T det(const matrix<1, 1, T> &m)
+{
+    return m(0,0);
+}
 
 /// \brief Compute the trace of a square matrix.
-template <size_t N> double trace(const matrix<N, N> &m)
+template <size_t N, class T> constexpr T trace(const matrix<N, N, T> &m)
 {
-    double sum = 0;
+    T sum = T(0);
     for (size_t i = 0; i < N; ++i)
     {
         sum += m(i, i);
@@ -382,14 +786,16 @@ template <size_t N> double trace(const matrix<N, N> &m)
     return sum;
 }
 
-template <size_t N> bool is_invertible(const matrix<N, N> &m)
+template <size_t N, class T>
+constexpr bool is_invertible(const matrix<N, N, T> &m)
 {
-    return det(m) != 0;
+    return det(m) != T(0);
 }
 
-template <size_t N> bool is_unitary(const matrix<N, N> &m)
+template <size_t N, class T>
+constexpr bool is_unitary(const matrix<N, N, T> &m)
 {
-    return m*transpose(m) == identity<N, N>();
+    return m*transpose(m) == identity<N, N, T>();
 }
 
 /// \brief Compute the inverse of a square matrix.
@@ -399,79 +805,114 @@ matrix<2, 2> inverse(const matrix<2, 2> &mat);
 matrix<1, 1> inverse(const matrix<1, 1> &mat);
 
 /// \brief Compute the inner product of two matrices.
-template <size_t M, size_t N>
-double inner_product(const matrix<M, N> &left,
-                     const matrix<M, N> &right)
+template <size_t M, size_t N, class T>
+constexpr T inner_product(const matrix<M, N, T> &left,
+                          const matrix<M, N, T> &right)
 {
-    double sum = 0;
+    T sum = T(0);
     for (size_t i = 0; i < M*N; ++i)
     {
-        sum += left[i]*right[i];
+        sum += scalar_traits<T>::conjugate(left[i])*right[i];
     }
     return sum;
 }
 
-/// \brief Compute a matrix raised to a power.
-template <size_t N>
-matrix<N, N> pow(const matrix<N, N> &mat, size_t ex)
+/// \brief Compute a matrix raised to a power, by repeated squaring,
+/// which takes O(log ex) multiplications.
+template <size_t N, class T>
+constexpr matrix<N, N, T> pow(const matrix<N, N, T> &mat, size_t ex)
 {
-    if (ex < 0) throw std::logic_error("unimplemented");
-
-    if (ex == 0) return identity<N, N>();
-    else if (ex == 1) return mat;
-
-    matrix<3, 3> ret = mat;
-    for (size_t i = 0; i < ex - 1; ++i)
+    matrix<N, N, T> ret = identity<N, N, T>();
+    matrix<N, N, T> square = mat;
+    while (ex > 0)
     {
-        ret = ret * mat;
+        if (ex & 1)
+        {
+            ret = ret * square;
+        }
+        ex >>= 1;
+        if (ex > 0)
+        {
+            square = square * square;
+        }
     }
     return ret;
 }
 
 /// \brief Convenience operator for matrix power.
-template <size_t N>
-matrix<N, N> operator ^ (const matrix<N, N> &mat, size_t ex)
+template <size_t N, class T>
+constexpr matrix<N, N, T> operator ^ (const matrix<N, N, T> &mat, size_t ex)
 {
     return pow(mat, ex);
 }
 
 /// \brief Convenience operator for skew-symmetric matrix of a vector.
-template <size_t N>
-matrix<N, N> operator ~ (const column_vector<N> &vec)
+template <size_t N, class T>
+constexpr matrix<N, N, T> operator ~ (const column_vector<N, T> &vec)
 {
     return skew_symmetric(vec);
 }
 
 /// \brief Convenience operator for skew-symmetric matrix of a vector.
-template <size_t N>
-matrix<N, N> operator ~ (const row_vector<N> &vec)
+template <size_t N, class T>
+constexpr matrix<N, N, T> operator ~ (const row_vector<N, T> &vec)
 {
     return skew_symmetric(vec);
 }
 
 /// \brief Compute the cross product of two vectors.
-column_vector<3> cross_product(const column_vector<3> &left,
-                               const column_vector<3> &right);
+template <class T>
+constexpr column_vector<3, T> cross_product(const column_vector<3, T> &left,
+                                            const column_vector<3, T> &right)
+{
+    return column_vector<3, T>(
+        left[1]*right[2] - left[2]*right[1],
+        left[2]*right[0] - left[0]*right[2],
+        left[0]*right[1] - left[1]*right[0]);
+}
 
 /// \brief Compute the cross product of two vectors.
-column_vector<3> cross_product(const column_vector<3> &left,
-                               const row_vector<3> &right);
+template <class T>
+constexpr column_vector<3, T> cross_product(const column_vector<3, T> &left,
+                                            const row_vector<3, T> &right)
+{
+    return cross_product(left, column_vector<3, T>(transpose(right)));
+}
 
 /// \brief Compute the cross product of two vectors.
-column_vector<3> cross_product(const row_vector<3> &left,
-                               const column_vector<3> &right);
+template <class T>
+constexpr column_vector<3, T> cross_product(const row_vector<3, T> &left,
+                                            const column_vector<3, T> &right)
+{
+    return cross_product(column_vector<3, T>(transpose(left)), right);
+}
 
 /// \brief Compute the cross product of two vectors.
-column_vector<3> cross_product(const row_vector<3> &left,
-                               const row_vector<3> &right);
+template <class T>
+constexpr column_vector<3, T> cross_product(const row_vector<3, T> &left,
+                                            const row_vector<3, T> &right)
+{
+    return cross_product(column_vector<3, T>(transpose(left)),
+                         column_vector<3, T>(transpose(right)));
+}
 
 /// \brief Compute the skew-symmetric equivalent matrix from
 /// a 3D vector.
-matrix<3, 3> skew_symmetric(const row_vector<3> &v);
+template <class T>
+constexpr matrix<3, 3, T> skew_symmetric(const column_vector<3, T> &v)
+{
+    return matrix<3, 3, T>(T(0), -v[2], v[1],
+                           v[2], T(0), -v[0],
+                           -v[1], v[0], T(0));
+}
 
 /// \brief Compute the skew-symmetric equivalent matrix from
 /// a 3D vector.
-matrix<3, 3> skew_symmetric(const column_vector<3> &v);
+template <class T>
+constexpr matrix<3, 3, T> skew_symmetric(const row_vector<3, T> &v)
+{
+    return skew_symmetric(column_vector<3, T>(transpose(v)));
+}
 
 } // namespace lambda
 
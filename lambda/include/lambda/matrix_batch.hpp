@@ -0,0 +1,860 @@
+#ifndef LAMBDA_MATRIX_BATCH_HPP
+#define LAMBDA_MATRIX_BATCH_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "lambda/matrix.hpp"
+
+/*!
+    \file
+    \brief Defines lambda::matrix_batch, which holds many matrices of the
+    same size in structure-of-arrays form, and the batched operations on
+    it. Element (i, j) of every matrix in a batch is stored contiguously,
+    so each operation is a loop over the batch which the compiler can
+    vectorize, rather than a loop over the elements of one small matrix.
+*/
+
+namespace lambda
+{
+
+namespace detail
+{
+
+/// \brief The alignment, in bytes, of each plane of a matrix_batch; one
+/// cache line, and the width of an AVX-512 register.
+constexpr size_t batch_alignment = 64;
+
+/// \brief The number of elements of type T in one aligned line.
+template <class T>
+constexpr size_t batch_lanes = batch_alignment/sizeof(T) > 0 ?
+    batch_alignment/sizeof(T) : 1;
+
+/// \brief An allocator which aligns its storage to batch_alignment.
+template <class T> struct aligned_allocator
+{
+    using value_type = T;
+
+    aligned_allocator() = default;
+
+    template <class U>
+    aligned_allocator(const aligned_allocator<U> &) { }
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(::operator new(n*sizeof(T),
+            std::align_val_t(batch_alignment)));
+    }
+
+    void deallocate(T *p, size_t)
+    {
+        ::operator delete(p, std::align_val_t(batch_alignment));
+    }
+
+    /// \brief Default initializes, rather than value initializes, so
+    /// that resizing a vector of scalars leaves them uninitialized.
+    template <class U> void construct(U *p)
+    {
+        ::new (static_cast<void*>(p)) U;
+    }
+
+    template <class U, class ...A> void construct(U *p, A&&... args)
+    {
+        ::new (static_cast<void*>(p)) U(std::forward<A>(args)...);
+    }
+
+    template <class U>
+    bool operator == (const aligned_allocator<U> &) const { return true; }
+
+    template <class U>
+    bool operator != (const aligned_allocator<U> &) const { return false; }
+};
+
+/// \brief Selects the constructor of matrix_batch which leaves its
+/// elements uninitialized.
+struct uninitialized_t { };
+
+/// \brief Tells the compiler that a plane of a batch is aligned.
+template <class T> T* assume_aligned(T *p)
+{
+    return static_cast<T*>(__builtin_assume_aligned(p, batch_alignment));
+}
+
+} // namespace detail
+
+/// \brief A batch of MxN matrices, stored as structure of arrays. The
+/// batch holds M*N planes, one per element, each of which is an array of
+/// that element across every matrix; plane(i, j)[k] is element (i, j) of
+/// matrix k. Each plane is aligned to 64 bytes, and padded so the next
+/// one is too.
+/// \param M The number of rows of each matrix.
+/// \param N The number of columns of each matrix.
+/// \param T The type of the elements.
+template <size_t M, size_t N, class T = double> class matrix_batch
+{
+    public:
+
+    /// \brief The type of the elements.
+    using value_type = T;
+
+    /// \brief The number of rows of each matrix.
+    static constexpr size_t rows = M;
+
+    /// \brief The number of columns of each matrix.
+    static constexpr size_t cols = N;
+
+    /// \brief Constructs an empty batch.
+    matrix_batch() : _size(0), _stride(0) { }
+
+    /// \brief Constructs a batch of size zero matrices.
+    explicit matrix_batch(size_t size) :
+        _data(M*N*padded(size), T()), _size(size), _stride(padded(size)) { }
+
+    /// \brief Constructs a batch of size matrices whose elements are
+    /// left uninitialized, for results which are about to be written.
+    /// The padding is zeroed, so it never holds a denormal or NaN which
+    /// would slow down arithmetic on its line.
+    matrix_batch(size_t size, detail::uninitialized_t) :
+        _data(M*N*padded(size)), _size(size), _stride(padded(size))
+    {
+        for (size_t p = 0; p < M*N; ++p)
+        {
+            std::fill(plane(p) + _size, plane(p) + _stride, T());
+        }
+    }
+
+    /// \brief Constructs a batch from a list of matrices.
+    explicit matrix_batch(const std::vector<matrix<M, N, T>> &mats) :
+        matrix_batch(mats.size())
+    {
+        for (size_t k = 0; k < _size; ++k)
+        {
+            scatter(k, mats[k]);
+        }
+    }
+
+    /// \brief Get the number of matrices in the batch.
+    size_t size() const
+    {
+        return _size;
+    }
+
+    /// \brief Get the distance between planes, in elements; the size of
+    /// the batch rounded up to a whole number of 64 byte lines.
+    size_t stride() const
+    {
+        return _stride;
+    }
+
+    /// \brief Resize the batch, keeping the first min(size, size())
+    /// matrices and zero initializing any new ones.
+    void resize(size_t size)
+    {
+        matrix_batch resized(size);
+        const size_t kept = size < _size ? size : _size;
+        for (size_t p = 0; p < M*N; ++p)
+        {
+            for (size_t k = 0; k < kept; ++k)
+            {
+                resized.plane(p)[k] = plane(p)[k];
+            }
+        }
+        *this = std::move(resized);
+    }
+
+    /// \brief Get the plane holding element p, in row-major order, of
+    /// every matrix in the batch.
+    T* plane(size_t p)
+    {
+        return detail::assume_aligned(_data.data() + _stride*p);
+    }
+
+    /// \brief Get the plane holding element p, in row-major order, of
+    /// every matrix in the batch.
+    const T* plane(size_t p) const
+    {
+        return detail::assume_aligned(_data.data() + _stride*p);
+    }
+
+    /// \brief Get the plane holding element (i, j) of every matrix in
+    /// the batch.
+    T* plane(size_t i, size_t j)
+    {
+        return plane(N*i + j);
+    }
+
+    /// \brief Get the plane holding element (i, j) of every matrix in
+    /// the batch.
+    const T* plane(size_t i, size_t j) const
+    {
+        return plane(N*i + j);
+    }
+
+    /// \brief Access element (i, j) of matrix k.
+    T& operator () (size_t k, size_t i, size_t j)
+    {
+        return _data[_stride*(N*i + j) + k];
+    }
+
+    /// \brief Access element (i, j) of matrix k.
+    const T& operator () (size_t k, size_t i, size_t j) const
+    {
+        return _data[_stride*(N*i + j) + k];
+    }
+
+    /// \brief Copy matrix k out of the batch.
+    matrix<M, N, T> gather(size_t k) const
+    {
+        range_check(k);
+        matrix<M, N, T> ret;
+        for (size_t p = 0; p < M*N; ++p)
+        {
+            ret[p] = plane(p)[k];
+        }
+        return ret;
+    }
+
+    /// \brief Copy a matrix into position k of the batch.
+    void scatter(size_t k, const matrix<M, N, T> &m)
+    {
+        range_check(k);
+        for (size_t p = 0; p < M*N; ++p)
+        {
+            plane(p)[k] = m[p];
+        }
+    }
+
+    private:
+
+    /// \brief Round a batch size up to a whole number of lines.
+    static size_t padded(size_t size)
+    {
+        constexpr size_t line = detail::batch_lanes<T>;
+        return (size + line - 1)/line*line;
+    }
+
+    /// \brief Throws an exception if an index is out of bounds.
+    void range_check(size_t k) const
+    {
+        if (k >= _size)
+        {
+            std::stringstream ss;
+            ss << "Cannot access matrix " << k
+                << " of batch of " << _size << " matrices";
+            throw std::out_of_range(ss.str());
+        }
+    }
+
+    /// \brief The planes, one after another.
+    std::vector<T, detail::aligned_allocator<T>> _data;
+
+    /// \brief The number of matrices in the batch.
+    size_t _size;
+
+    /// \brief The distance between planes.
+    size_t _stride;
+};
+
+/// \brief Convenience typedef for a batch of column vectors.
+template <size_t N, class T = double>
+using vector_batch = matrix_batch<N, 1, T>;
+
+namespace detail
+{
+
+/// \brief Throws an exception if two batches are not the same size.
+inline void batch_check(const char *op, size_t left, size_t right)
+{
+    if (left != right)
+    {
+        std::stringstream ss;
+        ss << "Cannot " << op << " batches of " << left
+            << " and " << right << " matrices";
+        throw std::invalid_argument(ss.str());
+    }
+}
+
+/// \brief Gets the planes of a batch.
+template <size_t M, size_t N, class T>
+std::array<const T*, M*N> planes(const matrix_batch<M, N, T> &batch)
+{
+    std::array<const T*, M*N> ret;
+    for (size_t p = 0; p < M*N; ++p)
+    {
+        ret[p] = batch.plane(p);
+    }
+    return ret;
+}
+
+// The kernels below work on planes of n elements, where n is a stride,
+// so a whole number of aligned lines. Each loop over a line has a fixed
+// trip count, so the compiler vectorizes it without a scalar remainder,
+// and each output is a __restrict parameter, so without a runtime alias
+// check. The lines cover the padding at the end of each plane, which
+// holds no matrix.
+
+/// \brief Computes c = a + b, elementwise.
+template <class T>
+void add_planes(const T *a, const T *b, T *__restrict c, size_t n)
+{
+    constexpr size_t lanes = batch_lanes<T>;
+    for (size_t line = 0; line < n; line += lanes)
+    {
+#pragma GCC unroll 16
+        for (size_t k = line; k < line + lanes; ++k)
+        {
+            c[k] = a[k] + b[k];
+        }
+    }
+}
+
+/// \brief Computes c = a - b, elementwise.
+template <class T>
+void subtract_planes(const T *a, const T *b, T *__restrict c, size_t n)
+{
+    constexpr size_t lanes = batch_lanes<T>;
+    for (size_t line = 0; line < n; line += lanes)
+    {
+#pragma GCC unroll 16
+        for (size_t k = line; k < line + lanes; ++k)
+        {
+            c[k] = a[k] - b[k];
+        }
+    }
+}
+
+/// \brief Computes c = a.
+template <class T>
+void copy_plane(const T *a, T *__restrict c, size_t n)
+{
+    constexpr size_t lanes = batch_lanes<T>;
+    for (size_t line = 0; line < n; line += lanes)
+    {
+#pragma GCC unroll 16
+        for (size_t k = line; k < line + lanes; ++k)
+        {
+            c[k] = a[k];
+        }
+    }
+}
+
+/// \brief Computes c = sum of a[l]*b[l] over L pairs of planes; with
+/// Conjugate, a[l] is conjugated.
+template <size_t L, bool Conjugate, class T>
+void sum_of_products(std::array<const T*, L> a, std::array<const T*, L> b,
+                     T *__restrict c, size_t n)
+{
+    constexpr size_t lanes = batch_lanes<T>;
+    for (size_t line = 0; line < n; line += lanes)
+    {
+#pragma GCC unroll 16
+        for (size_t k = line; k < line + lanes; ++k)
+        {
+            T sum = T();
+#pragma GCC unroll 16
+            for (size_t l = 0; l < L; ++l)
+            {
+                sum += (Conjugate ? scalar_traits<T>::conjugate(a[l][k])
+                                  : a[l][k]) * b[l][k];
+            }
+            c[k] = sum;
+        }
+    }
+}
+
+/// \brief Computes the products C = A*B of a batch of MxN matrices A and
+/// a batch of NxP matrices B, whose planes are n elements apart. Every
+/// element of C is computed for one line of the batch before the next,
+/// so the planes of A and B are each read once.
+template <size_t M, size_t N, size_t P, class T>
+void multiply_planes(const T *a, const T *b, T *__restrict c, size_t n)
+{
+    constexpr size_t lanes = batch_lanes<T>;
+    for (size_t line = 0; line < n; line += lanes)
+    {
+        for (size_t i = 0; i < M; ++i)
+        {
+            for (size_t j = 0; j < P; ++j)
+            {
+#pragma GCC unroll 16
+                for (size_t k = line; k < line + lanes; ++k)
+                {
+                    T sum = T();
+#pragma GCC unroll 16
+                    for (size_t l = 0; l < N; ++l)
+                    {
+                        sum += a[n*(N*i + l) + k] * b[n*(P*l + j) + k];
+                    }
+                    c[n*(P*i + j) + k] = sum;
+                }
+            }
+        }
+    }
+}
+
+/// \brief Computes c = sum of coef[l]*b[l] over L planes.
+template <size_t L, class T>
+void linear_combination(std::array<T, L> coef, std::array<const T*, L> b,
+                        T *__restrict c, size_t n)
+{
+    constexpr size_t lanes = batch_lanes<T>;
+    for (size_t line = 0; line < n; line += lanes)
+    {
+#pragma GCC unroll 16
+        for (size_t k = line; k < line + lanes; ++k)
+        {
+            T sum = T();
+#pragma GCC unroll 16
+            for (size_t l = 0; l < L; ++l)
+            {
+                sum += coef[l] * b[l][k];
+            }
+            c[k] = sum;
+        }
+    }
+}
+
+/// \brief Computes the cross products c = a x b of 3-vectors whose
+/// components are held in three planes each.
+template <class T>
+void cross_product_planes(std::array<const T*, 3> a,
+                          std::array<const T*, 3> b,
+                          T *__restrict c0, T *__restrict c1,
+                          T *__restrict c2, size_t n)
+{
+    constexpr size_t lanes = batch_lanes<T>;
+    for (size_t line = 0; line < n; line += lanes)
+    {
+#pragma GCC unroll 16
+        for (size_t k = line; k < line + lanes; ++k)
+        {
+            c0[k] = a[1][k]*b[2][k] - a[2][k]*b[1][k];
+            c1[k] = a[2][k]*b[0][k] - a[0][k]*b[2][k];
+            c2[k] = a[0][k]*b[1][k] - a[1][k]*b[0][k];
+        }
+    }
+}
+
+/// \brief Computes s = |a|^2, where each vector a has its L components
+/// held in L planes.
+template <size_t L, class T, class R>
+void squared_norms(std::array<const T*, L> a, R *__restrict s, size_t n)
+{
+    constexpr size_t lanes = batch_lanes<T>;
+    for (size_t line = 0; line < n; line += lanes)
+    {
+#pragma GCC unroll 16
+        for (size_t k = line; k < line + lanes; ++k)
+        {
+            R normsq(0);
+#pragma GCC unroll 16
+            for (size_t l = 0; l < L; ++l)
+            {
+                normsq += scalar_traits<T>::squared_magnitude(a[l][k]);
+            }
+            s[k] = normsq;
+        }
+    }
+}
+
+/// \brief Computes s = 1/sqrt(s), elementwise.
+template <class T, class R>
+void reciprocal_sqrt(R *__restrict s, size_t n)
+{
+    constexpr size_t lanes = batch_lanes<T>;
+    for (size_t line = 0; line < n; line += lanes)
+    {
+#pragma GCC unroll 16
+        for (size_t k = line; k < line + lanes; ++k)
+        {
+            s[k] = R(1)/std::sqrt(s[k]);
+        }
+    }
+}
+
+/// \brief Computes c = a*s, elementwise.
+template <class T, class R>
+void scale_plane(const T *a, const R *s, T *__restrict c, size_t n)
+{
+    constexpr size_t lanes = batch_lanes<T>;
+    for (size_t line = 0; line < n; line += lanes)
+    {
+#pragma GCC unroll 16
+        for (size_t k = line; k < line + lanes; ++k)
+        {
+            c[k] = a[k] * s[k];
+        }
+    }
+}
+
+/// \brief One line of a batch, L lanes of T, on which the arithmetic
+/// operators and sqrt, abs and copysign act lane by lane. A kernel
+/// written once for a scalar T also compiles for a lane_pack, and then
+/// works on a whole line of a batch at once, as loops of L which the
+/// compiler vectorizes. A branch in such a kernel is written as
+/// select_less or swap_less instead.
+template <class T, size_t L> struct lane_pack
+{
+    lane_pack() = default;
+
+    /// \brief Sets every lane to x.
+    lane_pack(T x)
+    {
+#pragma GCC unroll 16
+        for (size_t l = 0; l < L; ++l)
+        {
+            v[l] = x;
+        }
+    }
+
+    T v[L];
+};
+
+/// \brief Applies f to each lane of a and b.
+template <class T, size_t L, class F>
+lane_pack<T, L> lanewise(const lane_pack<T, L> &a, const lane_pack<T, L> &b,
+                         F f)
+{
+    lane_pack<T, L> ret;
+#pragma GCC unroll 16
+    for (size_t l = 0; l < L; ++l)
+    {
+        ret.v[l] = f(a.v[l], b.v[l]);
+    }
+    return ret;
+}
+
+template <class T, size_t L>
+lane_pack<T, L> operator + (const lane_pack<T, L> &a,
+                            const lane_pack<T, L> &b)
+{
+    return lanewise(a, b, [] (T x, T y) { return x + y; });
+}
+
+template <class T, size_t L>
+lane_pack<T, L> operator - (const lane_pack<T, L> &a,
+                            const lane_pack<T, L> &b)
+{
+    return lanewise(a, b, [] (T x, T y) { return x - y; });
+}
+
+template <class T, size_t L>
+lane_pack<T, L> operator * (const lane_pack<T, L> &a,
+                            const lane_pack<T, L> &b)
+{
+    return lanewise(a, b, [] (T x, T y) { return x * y; });
+}
+
+template <class T, size_t L>
+lane_pack<T, L> operator / (const lane_pack<T, L> &a,
+                            const lane_pack<T, L> &b)
+{
+    return lanewise(a, b, [] (T x, T y) { return x / y; });
+}
+
+/// \brief Square root of each lane. The compiler cannot vectorize
+/// std::sqrt, which may set errno, so whole registers of doubles or
+/// floats use the SIMD instruction instead.
+template <class T, size_t L>
+lane_pack<T, L> sqrt(const lane_pack<T, L> &a)
+{
+    lane_pack<T, L> ret;
+#if defined(__AVX2__)
+    if constexpr (std::is_same<T, double>::value && L % 4 == 0)
+    {
+        for (size_t l = 0; l < L; l += 4)
+        {
+            _mm256_storeu_pd(ret.v + l,
+                             _mm256_sqrt_pd(_mm256_loadu_pd(a.v + l)));
+        }
+        return ret;
+    }
+    if constexpr (std::is_same<T, float>::value && L % 8 == 0)
+    {
+        for (size_t l = 0; l < L; l += 8)
+        {
+            _mm256_storeu_ps(ret.v + l,
+                             _mm256_sqrt_ps(_mm256_loadu_ps(a.v + l)));
+        }
+        return ret;
+    }
+#elif defined(__SSE2__)
+    if constexpr (std::is_same<T, double>::value && L % 2 == 0)
+    {
+        for (size_t l = 0; l < L; l += 2)
+        {
+            _mm_storeu_pd(ret.v + l, _mm_sqrt_pd(_mm_loadu_pd(a.v + l)));
+        }
+        return ret;
+    }
+    if constexpr (std::is_same<T, float>::value && L % 4 == 0)
+    {
+        for (size_t l = 0; l < L; l += 4)
+        {
+            _mm_storeu_ps(ret.v + l, _mm_sqrt_ps(_mm_loadu_ps(a.v + l)));
+        }
+        return ret;
+    }
+#endif
+#pragma GCC unroll 16
+    for (size_t l = 0; l < L; ++l)
+    {
+        ret.v[l] = std::sqrt(a.v[l]);
+    }
+    return ret;
+}
+
+template <class T, size_t L>
+lane_pack<T, L> abs(const lane_pack<T, L> &a)
+{
+    return lanewise(a, a, [] (T x, T) { return std::abs(x); });
+}
+
+template <class T, size_t L>
+lane_pack<T, L> copysign(const lane_pack<T, L> &a,
+                         const lane_pack<T, L> &b)
+{
+    return lanewise(a, b, [] (T x, T y) { return std::copysign(x, y); });
+}
+
+/// \brief Gets x < y ? a : b.
+template <class T>
+T select_less(T x, T y, T a, T b)
+{
+    return x < y ? a : b;
+}
+
+/// \brief Gets x < y ? a : b, lane by lane, as a comparison and a blend.
+/// Both a and b are read before the comparison, and the loop is left
+/// rolled, since otherwise the compiler unrolls it into branches before
+/// it can vectorize it.
+template <class T, size_t L>
+lane_pack<T, L> select_less(const lane_pack<T, L> &x,
+                            const lane_pack<T, L> &y,
+                            const lane_pack<T, L> &a,
+                            const lane_pack<T, L> &b)
+{
+    lane_pack<T, L> ret;
+    for (size_t l = 0; l < L; ++l)
+    {
+        const T if_less = a.v[l], otherwise = b.v[l];
+        ret.v[l] = x.v[l] < y.v[l] ? if_less : otherwise;
+    }
+    return ret;
+}
+
+/// \brief Swaps a and b if x < y.
+template <class T>
+void swap_less(T x, T y, T &a, T &b)
+{
+    const T if_less = b, otherwise = a;
+    a = x < y ? if_less : otherwise;
+    b = x < y ? otherwise : if_less;
+}
+
+/// \brief Swaps a and b in each lane where x < y, with one comparison
+/// and two blends.
+template <class T, size_t L>
+void swap_less(const lane_pack<T, L> &x, const lane_pack<T, L> &y,
+               lane_pack<T, L> &a, lane_pack<T, L> &b)
+{
+    for (size_t l = 0; l < L; ++l)
+    {
+        const T al = a.v[l], bl = b.v[l];
+        const bool less = x.v[l] < y.v[l];
+        a.v[l] = less ? bl : al;
+        b.v[l] = less ? al : bl;
+    }
+}
+
+} // namespace detail
+
+/// \brief Batched addition; each matrix of the result is the sum of the
+/// corresponding matrices of left and right.
+template <size_t M, size_t N, class T>
+matrix_batch<M, N, T> operator + (const matrix_batch<M, N, T> &left,
+                                  const matrix_batch<M, N, T> &right)
+{
+    detail::batch_check("add", left.size(), right.size());
+    matrix_batch<M, N, T> ret(left.size(), detail::uninitialized_t());
+    for (size_t p = 0; p < M*N; ++p)
+    {
+        detail::add_planes(left.plane(p), right.plane(p),
+                           ret.plane(p), ret.stride());
+    }
+    return ret;
+}
+
+/// \brief Batched subtraction.
+template <size_t M, size_t N, class T>
+matrix_batch<M, N, T> operator - (const matrix_batch<M, N, T> &left,
+                                  const matrix_batch<M, N, T> &right)
+{
+    detail::batch_check("subtract", left.size(), right.size());
+    matrix_batch<M, N, T> ret(left.size(), detail::uninitialized_t());
+    for (size_t p = 0; p < M*N; ++p)
+    {
+        detail::subtract_planes(left.plane(p), right.plane(p),
+                                ret.plane(p), ret.stride());
+    }
+    return ret;
+}
+
+/// \brief Batched multiplication; each matrix of the result is the
+/// product of the corresponding matrices of left and right.
+template <size_t M, size_t N, size_t P, class T>
+matrix_batch<M, P, T> operator * (const matrix_batch<M, N, T> &left,
+                                  const matrix_batch<N, P, T> &right)
+{
+    detail::batch_check("multiply", left.size(), right.size());
+    matrix_batch<M, P, T> ret(left.size(), detail::uninitialized_t());
+    detail::multiply_planes<M, N, P>(left.plane(0), right.plane(0),
+                                     ret.plane(0), ret.stride());
+    return ret;
+}
+
+/// \brief Multiplication of every matrix in a batch by one matrix on the
+/// left, such as one rotation applied to a batch of points.
+template <size_t M, size_t N, size_t P, class T>
+matrix_batch<M, P, T> operator * (const matrix<M, N, T> &left,
+                                  const matrix_batch<N, P, T> &right)
+{
+    matrix_batch<M, P, T> ret(right.size(), detail::uninitialized_t());
+    for (size_t i = 0; i < M; ++i)
+    {
+        for (size_t j = 0; j < P; ++j)
+        {
+            std::array<T, N> row;
+            std::array<const T*, N> col;
+            for (size_t l = 0; l < N; ++l)
+            {
+                row[l] = left(i, l);
+                col[l] = right.plane(l, j);
+            }
+            detail::linear_combination(row, col,
+                ret.plane(i, j), ret.stride());
+        }
+    }
+    return ret;
+}
+
+/// \brief Multiplication of every matrix in a batch by one matrix on the
+/// right.
+template <size_t M, size_t N, size_t P, class T>
+matrix_batch<M, P, T> operator * (const matrix_batch<M, N, T> &left,
+                                  const matrix<N, P, T> &right)
+{
+    matrix_batch<M, P, T> ret(left.size(), detail::uninitialized_t());
+    for (size_t i = 0; i < M; ++i)
+    {
+        for (size_t j = 0; j < P; ++j)
+        {
+            std::array<const T*, N> row;
+            std::array<T, N> col;
+            for (size_t l = 0; l < N; ++l)
+            {
+                row[l] = left.plane(i, l);
+                col[l] = right(l, j);
+            }
+            detail::linear_combination(col, row,
+                ret.plane(i, j), ret.stride());
+        }
+    }
+    return ret;
+}
+
+/// \brief Batched transpose. Each plane is copied whole, so this is a
+/// reordering of planes rather than of elements.
+template <size_t M, size_t N, class T>
+matrix_batch<N, M, T> transpose(const matrix_batch<M, N, T> &batch)
+{
+    matrix_batch<N, M, T> ret(batch.size(), detail::uninitialized_t());
+    for (size_t i = 0; i < M; ++i)
+    {
+        for (size_t j = 0; j < N; ++j)
+        {
+            detail::copy_plane(batch.plane(i, j),
+                               ret.plane(j, i), ret.stride());
+        }
+    }
+    return ret;
+}
+
+/// \brief Batched inner product of column vectors.
+template <size_t N, class T>
+matrix_batch<1, 1, T> inner_product(const vector_batch<N, T> &left,
+                                    const vector_batch<N, T> &right)
+{
+    detail::batch_check("take inner product of",
+                        left.size(), right.size());
+    matrix_batch<1, 1, T> ret(left.size(), detail::uninitialized_t());
+    detail::sum_of_products<N, true>(detail::planes(left),
+        detail::planes(right), ret.plane(0), ret.stride());
+    return ret;
+}
+
+/// \brief Batched cross product of 3-vectors.
+template <class T>
+vector_batch<3, T> cross_product(const vector_batch<3, T> &left,
+                                 const vector_batch<3, T> &right)
+{
+    detail::batch_check("take cross product of",
+                        left.size(), right.size());
+    vector_batch<3, T> ret(left.size(), detail::uninitialized_t());
+    detail::cross_product_planes(detail::planes(left),
+        detail::planes(right), ret.plane(0), ret.plane(1), ret.plane(2),
+        ret.stride());
+    return ret;
+}
+
+/// \brief Batched normalization of column vectors. Throws if any vector
+/// is of zero norm.
+template <size_t N, class T>
+vector_batch<N, T> normalize(const vector_batch<N, T> &batch)
+{
+    using real_type = typename scalar_traits<T>::real_type;
+
+    // Padded to the stride of the batch, which is no shorter than its
+    // own since a real_type is no larger than a T.
+    vector_batch<1, real_type> scale(batch.stride(), detail::uninitialized_t());
+    real_type *s = scale.plane(0);
+    detail::squared_norms(detail::planes(batch), s, batch.stride());
+    for (size_t k = 0; k < batch.size(); ++k)
+    {
+        if (s[k] == real_type(0))
+        {
+            std::stringstream ss;
+            ss << "Cannot normalize vector " << k
+                << " of batch, which is of zero norm";
+            throw std::domain_error(ss.str());
+        }
+    }
+    // The padding is of zero norm too, so gets an infinite scale, which
+    // is zeroed to keep the padding of the result zero rather than NaN.
+    detail::reciprocal_sqrt<T>(s, batch.stride());
+    std::fill(s + batch.size(), s + batch.stride(), real_type(0));
+
+    vector_batch<N, T> ret(batch.size(), detail::uninitialized_t());
+    for (size_t i = 0; i < N; ++i)
+    {
+        detail::scale_plane(batch.plane(i), scale.plane(0),
+                            ret.plane(i), ret.stride());
+    }
+    return ret;
+}
+
+} // namespace lambda
+
+#endif // LAMBDA_MATRIX_BATCH_HPP
@@ -0,0 +1,116 @@
+#ifndef LAMBDA_MEMORY_HPP
+#define LAMBDA_MEMORY_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+/*!
+    \file
+    \brief Defines where dynamic matrices allocate their elements: a
+    std::pmr::memory_resource chosen per matrix, defaulting to one
+    chosen per thread with lambda::scoped_resource, and lambda::arena,
+    a resource for the temporaries of an iterative computation, which
+    is released all at once and keeps its memory for the next
+    iteration.
+*/
+
+namespace lambda
+{
+
+/// \brief Get the memory resource used by dynamic matrices constructed
+/// on this thread without one, including the results of operators. This
+/// is std::pmr::get_default_resource() unless a scoped_resource is
+/// active.
+std::pmr::memory_resource* matrix_resource();
+
+/// \brief Makes a memory resource the matrix_resource() of this thread
+/// for its lifetime, restoring the previous one when destroyed.
+/// Matrices allocated from the resource must not outlive it.
+class scoped_resource
+{
+    public:
+
+    /// \brief Make resource the matrix_resource() of this thread.
+    explicit scoped_resource(std::pmr::memory_resource *resource);
+
+    /// \brief Restore the previous matrix_resource().
+    ~scoped_resource();
+
+    scoped_resource(const scoped_resource&) = delete;
+
+    scoped_resource& operator = (const scoped_resource&) = delete;
+
+    private:
+
+    /// \brief The resource in use before this one.
+    std::pmr::memory_resource *_previous;
+};
+
+/// \brief A monotonic memory resource. Allocation bumps a pointer
+/// through blocks taken from an upstream resource, and deallocation
+/// does nothing; release() frees everything allocated at once, in
+/// constant time, but keeps the blocks, so a computation which
+/// allocates the same amount each time it runs only allocates upstream
+/// the first time. Not thread-safe.
+class arena : public std::pmr::memory_resource
+{
+    public:
+
+    /// \brief Construct an arena whose first block, allocated on first
+    /// use, holds initial_size bytes; later blocks double in size.
+    explicit arena(size_t initial_size = 64*1024,
+        std::pmr::memory_resource *upstream =
+            std::pmr::get_default_resource());
+
+    /// \brief Returns every block to the upstream resource.
+    ~arena();
+
+    arena(const arena&) = delete;
+
+    arena& operator = (const arena&) = delete;
+
+    /// \brief Free everything allocated from the arena, keeping its
+    /// blocks for reuse.
+    void release();
+
+    /// \brief Get the number of bytes handed out since the last release.
+    size_t used() const;
+
+    /// \brief Get the total size of the arena's blocks.
+    size_t capacity() const;
+
+    private:
+
+    /// \brief A block of memory from the upstream resource.
+    struct block
+    {
+        char *data;
+        size_t size;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other)
+        const noexcept override;
+
+    /// \brief The resource blocks are allocated from.
+    std::pmr::memory_resource *_upstream;
+    /// \brief The blocks, in order of allocation.
+    std::vector<block> _blocks;
+    /// \brief The block being allocated from.
+    size_t _current;
+    /// \brief The offset of the next free byte of the current block.
+    size_t _offset;
+    /// \brief The bytes handed out, and lost to alignment and to the
+    /// unused ends of blocks, since the last release.
+    size_t _used;
+    /// \brief The size of the next block to allocate.
+    size_t _next_size;
+};
+
+} // namespace lambda
+
+#endif // LAMBDA_MEMORY_HPP
@@ -16,25 +16,31 @@ namespace lambda
 {
 
 /// \brief Compute the euclidian norm of a vector.
-template <size_t N>
-double euclidean_norm(const column_vector<N> &v)
+template <size_t N, class T>
+typename scalar_traits<T>::real_type
+euclidean_norm(const column_vector<N, T> &v)
 {
-    double normsq = lambda::inner_product(v, v);
+    typename scalar_traits<T>::real_type normsq(0);
+    for (size_t i = 0; i < N; ++i)
+    {
+        normsq += scalar_traits<T>::squared_magnitude(v[i]);
+    }
     return std::sqrt(normsq);
 }
 
 /// \brief Compute the euclidian norm of a vector.
-template <size_t N>
-double euclidean_norm(const row_vector<N> &v)
+template <size_t N, class T>
+typename scalar_traits<T>::real_type
+euclidean_norm(const row_vector<N, T> &v)
 {
-    return euclidean_norm(transpose(v));
+    return euclidean_norm(column_vector<N, T>(transpose(v)));
 }
 
 /// \brief Get the unit vector aligned with a vector.
-template <size_t N>
-column_vector<N> normalize(const column_vector<N> &v)
+template <size_t N, class T>
+column_vector<N, T> normalize(const column_vector<N, T> &v)
 {
-    double norm = euclidean_norm(v);
+    auto norm = euclidean_norm(v);
     if (norm == 0)
     {
         std::stringstream ss;
@@ -42,14 +48,14 @@ column_vector<N> normalize(const column_vector<N> &v)
             << ", which is of zero norm";
         throw std::domain_error(ss.str());
     }
-    return v/euclidean_norm(v);
+    return v/norm;
 }
 
 /// \brief Get the unit vector aligned with a vector.
-template <size_t N>
-row_vector<N> normalize(const row_vector<N> &v)
+template <size_t N, class T>
+row_vector<N, T> normalize(const row_vector<N, T> &v)
 {
-    double norm = euclidean_norm(transpose(v));
+    auto norm = euclidean_norm(v);
     if (norm == 0)
     {
         std::stringstream ss;
@@ -57,7 +63,7 @@ row_vector<N> normalize(const row_vector<N> &v)
             << ", which is of zero norm";
         throw std::domain_error(ss.str());
     }
-    return v/euclidean_norm(v);
+    return v/norm;
 }
 
 } // namespace lambda
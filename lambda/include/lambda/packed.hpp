@@ -0,0 +1,636 @@
+#ifndef LAMBDA_PACKED_HPP
+#define LAMBDA_PACKED_HPP
+
+#include <array>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+#include "lambda/matrix.hpp"
+
+/*!
+    \file
+    \brief Defines lambda::symmetric_matrix and lambda::triangular_matrix,
+    square matrices which store only one triangle, packed row by row.
+    Both are expressions, so they can be read, printed, compared and
+    converted to lambda::matrix like any other; the operations which
+    keep their structure return packed matrices, and only touch the
+    stored triangle.
+*/
+
+namespace lambda
+{
+
+namespace detail
+{
+
+/// \brief The number of elements in one triangle of an NxN matrix.
+constexpr size_t packed_size(size_t n)
+{
+    return n*(n + 1)/2;
+}
+
+/// \brief The index of element (i, j), i <= j, of the upper triangle
+/// of an NxN matrix packed row by row.
+constexpr size_t upper_index(size_t n, size_t i, size_t j)
+{
+    return i*(2*n - i - 1)/2 + j;
+}
+
+/// \brief The index of element (i, j), i >= j, of the lower triangle
+/// of a matrix packed row by row.
+constexpr size_t lower_index(size_t i, size_t j)
+{
+    return i*(i + 1)/2 + j;
+}
+
+/// \brief Throws the exception for a reference to an element outside
+/// the stored triangle of an NxN triangular matrix.
+template <size_t N>
+[[noreturn]] void unstored_element(size_t i, size_t j)
+{
+    std::stringstream ss;
+    ss << "Cannot reference element (" << i << ", " << j
+        << ") outside the stored triangle of " << N << "x" << N
+        << " triangular matrix";
+    throw std::out_of_range(ss.str());
+}
+
+} // namespace detail
+
+/// \brief A symmetric NxN matrix, stored as its upper triangle. Writing
+/// element (i, j) also writes element (j, i), so the matrix is symmetric
+/// by construction.
+template <size_t N, class T = double> class symmetric_matrix
+    : public matrix_expression<symmetric_matrix<N, T>>
+{
+    static_assert(N > 0, "Cannot create matrix of dimension 0");
+
+    public:
+
+    using value_type = T;
+
+    static constexpr size_t rows = N;
+    static constexpr size_t cols = N;
+
+    /// \brief Default constructor; zero initializes all elements.
+    constexpr symmetric_matrix() : _data() { }
+
+    /// \brief Construct the symmetric part, (E + E^T)/2, of an
+    /// expression. A matrix which is already symmetric is copied exactly.
+    template <class E, typename std::enable_if<
+        E::rows == N && E::cols == N, int>::type = 0>
+    constexpr explicit symmetric_matrix(const matrix_expression<E> &e)
+        : _data()
+    {
+        evaluator<E> ev(e.self());
+        for (size_t i = 0; i < N; ++i)
+        {
+            for (size_t j = i; j < N; ++j)
+            {
+                (*this)(i, j) = (ev(i, j) + ev(j, i))/T(2);
+            }
+        }
+    }
+
+    /// \brief Access element (i, j).
+    constexpr T operator () (size_t i, size_t j) const
+    {
+        return _data[index(i, j)];
+    }
+
+    /// \brief Get a reference to element (i, j), which is also
+    /// element (j, i).
+    constexpr T& operator () (size_t i, size_t j)
+    {
+        return _data[index(i, j)];
+    }
+
+    /// \brief Get element i of the equivalent row-major matrix.
+    constexpr T operator [] (size_t i) const
+    {
+        return (*this)(i / N, i % N);
+    }
+
+    /// \brief Get the packed upper triangle, row by row.
+    constexpr const std::array<T, detail::packed_size(N)>& data() const
+    {
+        return _data;
+    }
+
+    /// \brief Add a symmetric matrix to this one in place.
+    constexpr symmetric_matrix& operator += (const symmetric_matrix &other)
+    {
+        for (size_t k = 0; k < _data.size(); ++k)
+        {
+            _data[k] += other._data[k];
+        }
+        return *this;
+    }
+
+    /// \brief Subtract a symmetric matrix from this one in place.
+    constexpr symmetric_matrix& operator -= (const symmetric_matrix &other)
+    {
+        for (size_t k = 0; k < _data.size(); ++k)
+        {
+            _data[k] -= other._data[k];
+        }
+        return *this;
+    }
+
+    /// \brief Multiply this matrix by a scalar in place.
+    template <class S, typename std::enable_if<
+        is_scalar_of<S, T>::value, int>::type = 0>
+    constexpr symmetric_matrix& operator *= (S scalar)
+    {
+        for (size_t k = 0; k < _data.size(); ++k)
+        {
+            _data[k] *= scalar;
+        }
+        return *this;
+    }
+
+    /// \brief Whether this matrix is the matrix at p.
+    constexpr bool reads(const void *p) const
+    {
+        return p == static_cast<const void*>(this);
+    }
+
+    /// \brief A symmetric matrix is never the destination of a dense
+    /// assignment, so it never aliases it.
+    constexpr bool aliases(const void*) const
+    {
+        return false;
+    }
+
+    private:
+
+    /// \brief Packed index of element (i, j).
+    static constexpr size_t index(size_t i, size_t j)
+    {
+        return i <= j ? detail::upper_index(N, i, j)
+                      : detail::upper_index(N, j, i);
+    }
+
+    std::array<T, detail::packed_size(N)> _data;
+};
+
+/// \brief Which triangle of a triangular matrix is stored.
+enum class triangle { lower, upper };
+
+/// \brief A lower or upper triangular NxN matrix, storing only that
+/// triangle; the elements on the other side of the diagonal are zero.
+template <size_t N, class T = double, triangle Part = triangle::lower>
+class triangular_matrix
+    : public matrix_expression<triangular_matrix<N, T, Part>>
+{
+    static_assert(N > 0, "Cannot create matrix of dimension 0");
+
+    public:
+
+    using value_type = T;
+
+    static constexpr size_t rows = N;
+    static constexpr size_t cols = N;
+
+    /// \brief Default constructor; zero initializes all elements.
+    constexpr triangular_matrix() : _data() { }
+
+    /// \brief Construct from the stored triangle of an expression; the
+    /// rest of the expression is ignored.
+    template <class E, typename std::enable_if<
+        E::rows == N && E::cols == N, int>::type = 0>
+    constexpr explicit triangular_matrix(const matrix_expression<E> &e)
+        : _data()
+    {
+        evaluator<E> ev(e.self());
+        for (size_t i = 0; i < N; ++i)
+        {
+            for (size_t j = first(i); j <= last(i); ++j)
+            {
+                (*this)(i, j) = ev(i, j);
+            }
+        }
+    }
+
+    /// \brief Whether element (i, j) is in the stored triangle.
+    static constexpr bool stored(size_t i, size_t j)
+    {
+        return Part == triangle::lower ? j <= i : i <= j;
+    }
+
+    /// \brief The first stored column of row i.
+    static constexpr size_t first(size_t i)
+    {
+        return Part == triangle::lower ? 0 : i;
+    }
+
+    /// \brief The last stored column of row i.
+    static constexpr size_t last(size_t i)
+    {
+        return Part == triangle::lower ? i : N - 1;
+    }
+
+    /// \brief Access element (i, j); zero outside the stored triangle.
+    constexpr T operator () (size_t i, size_t j) const
+    {
+        return stored(i, j) ? _data[index(i, j)] : T();
+    }
+
+    /// \brief Get a reference to element (i, j). Throws an exception if
+    /// the element is outside the stored triangle, which is always zero.
+    constexpr T& operator () (size_t i, size_t j)
+    {
+        if (!stored(i, j)) detail::unstored_element<N>(i, j);
+        return _data[index(i, j)];
+    }
+
+    /// \brief Get element i of the equivalent row-major matrix.
+    constexpr T operator [] (size_t i) const
+    {
+        return (*this)(i / N, i % N);
+    }
+
+    /// \brief Get the packed triangle, row by row.
+    constexpr const std::array<T, detail::packed_size(N)>& data() const
+    {
+        return _data;
+    }
+
+    /// \brief Add a triangular matrix to this one in place.
+    constexpr triangular_matrix& operator += (const triangular_matrix &other)
+    {
+        for (size_t k = 0; k < _data.size(); ++k)
+        {
+            _data[k] += other._data[k];
+        }
+        return *this;
+    }
+
+    /// \brief Subtract a triangular matrix from this one in place.
+    constexpr triangular_matrix& operator -= (const triangular_matrix &other)
+    {
+        for (size_t k = 0; k < _data.size(); ++k)
+        {
+            _data[k] -= other._data[k];
+        }
+        return *this;
+    }
+
+    /// \brief Multiply this matrix by a scalar in place.
+    template <class S, typename std::enable_if<
+        is_scalar_of<S, T>::value, int>::type = 0>
+    constexpr triangular_matrix& operator *= (S scalar)
+    {
+        for (size_t k = 0; k < _data.size(); ++k)
+        {
+            _data[k] *= scalar;
+        }
+        return *this;
+    }
+
+    constexpr bool reads(const void *p) const
+    {
+        return p == static_cast<const void*>(this);
+    }
+
+    constexpr bool aliases(const void*) const
+    {
+        return false;
+    }
+
+    private:
+
+    /// \brief Packed index of element (i, j) of the stored triangle.
+    static constexpr size_t index(size_t i, size_t j)
+    {
+        return Part == triangle::lower ? detail::lower_index(i, j)
+                                       : detail::upper_index(N, i, j);
+    }
+
+    std::array<T, detail::packed_size(N)> _data;
+};
+
+/// \brief Convenience typedef for a lower triangular matrix.
+template <size_t N, class T = double>
+using lower_triangular = triangular_matrix<N, T, triangle::lower>;
+/// \brief Convenience typedef for an upper triangular matrix.
+template <size_t N, class T = double>
+using upper_triangular = triangular_matrix<N, T, triangle::upper>;
+
+// Packed matrices are not direct: a product reads each element many
+// times, so it unpacks them once and uses the dense kernels.
+
+template <size_t N, class T> class evaluator<symmetric_matrix<N, T>>
+{
+    public:
+
+    constexpr explicit evaluator(const symmetric_matrix<N, T> &s) : _s(s) { }
+
+    constexpr T operator () (size_t i, size_t j) const
+    {
+        return _s(i, j);
+    }
+
+    private:
+
+    const symmetric_matrix<N, T> &_s;
+};
+
+template <size_t N, class T, triangle Part>
+class evaluator<triangular_matrix<N, T, Part>>
+{
+    public:
+
+    constexpr explicit evaluator(const triangular_matrix<N, T, Part> &t)
+        : _t(t) { }
+
+    constexpr T operator () (size_t i, size_t j) const
+    {
+        return _t(i, j);
+    }
+
+    private:
+
+    const triangular_matrix<N, T, Part> &_t;
+};
+
+template <size_t N, class T>
+struct expression_storage<symmetric_matrix<N, T>>
+{
+    using type = const symmetric_matrix<N, T>&;
+};
+
+template <size_t N, class T, triangle Part>
+struct expression_storage<triangular_matrix<N, T, Part>>
+{
+    using type = const triangular_matrix<N, T, Part>&;
+};
+
+/// \brief Addition of two symmetric matrices.
+template <size_t N, class T>
+constexpr symmetric_matrix<N, T> operator + (symmetric_matrix<N, T> left,
+    const symmetric_matrix<N, T> &right)
+{
+    return left += right;
+}
+
+/// \brief Subtraction of two symmetric matrices.
+template <size_t N, class T>
+constexpr symmetric_matrix<N, T> operator - (symmetric_matrix<N, T> left,
+    const symmetric_matrix<N, T> &right)
+{
+    return left -= right;
+}
+
+/// \brief Multiplication of a symmetric matrix by a scalar.
+template <size_t N, class T, class S, typename std::enable_if<
+    is_scalar_of<S, T>::value, int>::type = 0>
+constexpr symmetric_matrix<N, T> operator * (symmetric_matrix<N, T> m,
+                                             S scalar)
+{
+    return m *= scalar;
+}
+
+/// \brief Multiplication of a symmetric matrix by a scalar.
+template <size_t N, class T, class S, typename std::enable_if<
+    is_scalar_of<S, T>::value, int>::type = 0>
+constexpr symmetric_matrix<N, T> operator * (S scalar,
+                                             symmetric_matrix<N, T> m)
+{
+    return m *= scalar;
+}
+
+/// \brief A symmetric matrix is its own transpose.
+template <size_t N, class T>
+constexpr const symmetric_matrix<N, T>& transpose(
+    const symmetric_matrix<N, T> &m)
+{
+    return m;
+}
+
+/// \brief Addition of two triangular matrices.
+template <size_t N, class T, triangle Part>
+constexpr triangular_matrix<N, T, Part> operator + (
+    triangular_matrix<N, T, Part> left,
+    const triangular_matrix<N, T, Part> &right)
+{
+    return left += right;
+}
+
+/// \brief Subtraction of two triangular matrices.
+template <size_t N, class T, triangle Part>
+constexpr triangular_matrix<N, T, Part> operator - (
+    triangular_matrix<N, T, Part> left,
+    const triangular_matrix<N, T, Part> &right)
+{
+    return left -= right;
+}
+
+/// \brief Multiplication of a triangular matrix by a scalar.
+template <size_t N, class T, triangle Part, class S, typename
+    std::enable_if<is_scalar_of<S, T>::value, int>::type = 0>
+constexpr triangular_matrix<N, T, Part> operator * (
+    triangular_matrix<N, T, Part> m, S scalar)
+{
+    return m *= scalar;
+}
+
+/// \brief Multiplication of a triangular matrix by a scalar.
+template <size_t N, class T, triangle Part, class S, typename
+    std::enable_if<is_scalar_of<S, T>::value, int>::type = 0>
+constexpr triangular_matrix<N, T, Part> operator * (
+    S scalar, triangular_matrix<N, T, Part> m)
+{
+    return m *= scalar;
+}
+
+/// \brief The transpose of a lower triangular matrix is upper
+/// triangular, and vice versa.
+template <size_t N, class T, triangle Part>
+constexpr triangular_matrix<N, T, Part == triangle::lower ?
+    triangle::upper : triangle::lower>
+transpose(const triangular_matrix<N, T, Part> &m)
+{
+    triangular_matrix<N, T, Part == triangle::lower ?
+        triangle::upper : triangle::lower> result;
+    for (size_t i = 0; i < N; ++i)
+    {
+        for (size_t j = m.first(i); j <= m.last(i); ++j)
+        {
+            result(j, i) = m(i, j);
+        }
+    }
+    return result;
+}
+
+/// \brief Multiplication of a triangular matrix by a matrix, skipping
+/// the zero triangle.
+template <size_t N, size_t P, class T, triangle Part>
+constexpr matrix<N, P, T> operator * (const triangular_matrix<N, T, Part> &t,
+                                      const matrix<N, P, T> &m)
+{
+    matrix<N, P, T> result;
+    for (size_t i = 0; i < N; ++i)
+    {
+        for (size_t k = t.first(i); k <= t.last(i); ++k)
+        {
+            const T tik = t(i, k);
+            for (size_t j = 0; j < P; ++j)
+            {
+                result(i, j) += tik * m(k, j);
+            }
+        }
+    }
+    return result;
+}
+
+/// \brief Computes A*S*A^T, which is symmetric, for an MxN matrix A and
+/// a symmetric NxN matrix S. A*S is formed by the dense kernel, then only
+/// the upper triangle of (A*S)*A^T is computed, from dot products of rows
+/// of A*S and of A.
+template <size_t M, size_t N, class T>
+constexpr symmetric_matrix<M, T> symmetric_product(const matrix<M, N, T> &a,
+    const symmetric_matrix<N, T> &s)
+{
+    const matrix<M, N, T> as = a * matrix<N, N, T>(s);
+    symmetric_matrix<M, T> result;
+    for (size_t i = 0; i < M; ++i)
+    {
+        for (size_t j = i; j < M; ++j)
+        {
+            T sum = T();
+            for (size_t k = 0; k < N; ++k)
+            {
+                sum += as(i, k) * a(j, k);
+            }
+            result(i, j) = sum;
+        }
+    }
+    return result;
+}
+
+/// \brief Computes L*L^T, which is symmetric, for a lower triangular
+/// matrix L, reading only the stored triangle.
+template <size_t N, class T>
+constexpr symmetric_matrix<N, T> symmetric_product(
+    const lower_triangular<N, T> &l)
+{
+    symmetric_matrix<N, T> result;
+    for (size_t i = 0; i < N; ++i)
+    {
+        for (size_t j = i; j < N; ++j)
+        {
+            T sum = T();
+            for (size_t k = 0; k <= i; ++k)
+            {
+                sum += l(i, k) * l(j, k);
+            }
+            result(i, j) = sum;
+        }
+    }
+    return result;
+}
+
+namespace detail
+{
+
+/// \brief Solves TX = B in place of B, for a triangular matrix T, by
+/// substitution; with unit set, the diagonal of T is taken to be ones,
+/// and not read.
+template <size_t N, size_t P, class T, triangle Part>
+constexpr void triangular_solve(const triangular_matrix<N, T, Part> &t,
+                                matrix<N, P, T> &x, bool unit)
+{
+#pragma GCC unroll 16
+    for (size_t n = 0; n < N; ++n)
+    {
+        const size_t i = Part == triangle::lower ? n : N - 1 - n;
+        // The columns of row i off the diagonal.
+        const size_t begin = Part == triangle::lower ? 0 : i + 1;
+        const size_t end = Part == triangle::lower ? i : N;
+#pragma GCC unroll 16
+        for (size_t k = begin; k < end; ++k)
+        {
+            const T tik = t(i, k);
+#pragma GCC unroll 16
+            for (size_t c = 0; c < P; ++c)
+            {
+                x(i, c) -= tik * x(k, c);
+            }
+        }
+        if (!unit)
+        {
+            const T inv_diagonal = T(1)/t(i, i);
+#pragma GCC unroll 16
+            for (size_t c = 0; c < P; ++c)
+            {
+                x(i, c) *= inv_diagonal;
+            }
+        }
+    }
+}
+
+/// \brief Solves T^T X = B in place of B, without forming T^T. Each row
+/// of X is finished in turn, then eliminated from the rows still to
+/// come, so T is read a row at a time.
+template <size_t N, size_t P, class T, triangle Part>
+constexpr void transpose_solve(const triangular_matrix<N, T, Part> &t,
+                               matrix<N, P, T> &x, bool unit)
+{
+#pragma GCC unroll 16
+    for (size_t n = 0; n < N; ++n)
+    {
+        const size_t i = Part == triangle::lower ? N - 1 - n : n;
+        if (!unit)
+        {
+            const T inv_diagonal = T(1)/t(i, i);
+#pragma GCC unroll 16
+            for (size_t c = 0; c < P; ++c)
+            {
+                x(i, c) *= inv_diagonal;
+            }
+        }
+        // The columns of row i off the diagonal.
+        const size_t begin = Part == triangle::lower ? 0 : i + 1;
+        const size_t end = Part == triangle::lower ? i : N;
+#pragma GCC unroll 16
+        for (size_t k = begin; k < end; ++k)
+        {
+            const T tik = t(i, k);
+#pragma GCC unroll 16
+            for (size_t c = 0; c < P; ++c)
+            {
+                x(k, c) -= tik * x(i, c);
+            }
+        }
+    }
+}
+
+} // namespace detail
+
+/// \brief Solve TX = B for a triangular matrix T, by forward or back
+/// substitution, where B may have several columns. Throws
+/// std::domain_error if T is singular.
+template <size_t N, size_t P, class T, triangle Part>
+matrix<N, P, T> solve(const triangular_matrix<N, T, Part> &t,
+                      const matrix<N, P, T> &b)
+{
+    for (size_t i = 0; i < N; ++i)
+    {
+        if (t(i, i) == T(0))
+        {
+            std::stringstream ss;
+            ss << "Cannot solve system with " << N << "x" << N
+                << " triangular matrix, which is singular";
+            throw std::domain_error(ss.str());
+        }
+    }
+    matrix<N, P, T> x = b;
+    detail::triangular_solve(t, x, false);
+    return x;
+}
+
+} // namespace lambda
+
+#endif // LAMBDA_PACKED_HPP
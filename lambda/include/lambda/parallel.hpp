@@ -0,0 +1,110 @@
+#ifndef LAMBDA_PARALLEL_HPP
+#define LAMBDA_PARALLEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "lambda/memory.hpp"
+
+/*!
+    \file
+    \brief Defines the thread count used by operations on large dynamic
+    matrices, and the loops which split work between threads. Work is
+    only ever split where each result is computed the same way
+    whichever thread computes it, and reductions combine fixed-size
+    chunks in a fixed order, so results do not depend on the thread
+    count.
+*/
+
+namespace lambda
+{
+
+/// \brief Get the number of threads used by operations on large
+/// dynamic matrices. Defaults to std::thread::hardware_concurrency().
+size_t thread_count();
+
+/// \brief Set the number of threads used by operations on large
+/// dynamic matrices. Zero restores the default.
+void set_thread_count(size_t threads);
+
+namespace detail
+{
+
+/// \brief Calls f(begin, end) over [0, count), split into at most
+/// thread_count() contiguous ranges, each run on its own thread, with
+/// the first run on the calling thread. Every range except the last
+/// is a nonzero multiple of grain elements long, and the last may be
+/// shorter; f must not throw. If a thread cannot be started, the ranges
+/// left over are run on the calling thread instead.
+template <class F> void parallel_for(size_t count, size_t grain, F f)
+{
+    grain = std::max<size_t>(grain, 1);
+    const size_t grains = (count + grain - 1)/grain;
+    const size_t threads = std::min(thread_count(), grains);
+    if (threads <= 1)
+    {
+        if (count > 0) f(size_t(0), count);
+        return;
+    }
+
+    auto range = [=] (size_t t)
+    {
+        return std::min(count, t*grains/threads*grain);
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    size_t started = 1;
+    try
+    {
+        for (; started < threads; ++started)
+        {
+            workers.emplace_back(f, range(started), range(started + 1));
+        }
+    }
+    catch (const std::system_error&)
+    {
+        // Out of threads; the workers already started are still joined.
+    }
+    f(range(0), range(1));
+    if (started < threads) f(range(started), range(threads));
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+/// \brief Reduces [0, count) in consecutive chunks of chunk elements,
+/// each reduced by map(begin, end), in parallel, then combines the
+/// results of the chunks in order with combine, starting from init.
+/// Each thread is given at least grain elements, as with parallel_for.
+/// The chunks are the same for any thread count, so the result is too.
+template <class T, class Map, class Combine>
+T parallel_reduce(size_t count, size_t chunk, size_t grain, T init,
+                  Map map, Combine combine)
+{
+    chunk = std::max<size_t>(chunk, 1);
+    std::pmr::vector<T> partial((count + chunk - 1)/chunk, init,
+                                matrix_resource());
+    parallel_for(partial.size(), (grain + chunk - 1)/chunk,
+                 [&] (size_t begin, size_t end)
+    {
+        for (size_t c = begin; c < end; ++c)
+        {
+            partial[c] = map(c*chunk, std::min(count, (c + 1)*chunk));
+        }
+    });
+    for (const T &p : partial)
+    {
+        init = combine(init, p);
+    }
+    return init;
+}
+
+} // namespace detail
+
+} // namespace lambda
+
+#endif // LAMBDA_PARALLEL_HPP
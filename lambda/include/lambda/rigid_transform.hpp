@@ -0,0 +1,103 @@
+#ifndef LAMBDA_RIGID_TRANSFORM_HPP
+#define LAMBDA_RIGID_TRANSFORM_HPP
+
+#include <ostream>
+#include <vector>
+
+#include "lambda/matrix.hpp"
+#include "lambda/matrix_batch.hpp"
+#include "lambda/quaternion.hpp"
+#include "lambda/axis_angle.hpp"
+
+/*!
+    \file
+    \brief Defines lambda::rigid_transform, a rotation followed by a
+           translation, i.e. an element of SE(3), and the batched
+           transformation of point clouds.
+*/
+
+namespace lambda
+{
+
+/// \brief A rigid-body transform, which maps a point p to R*p + t for
+/// a rotation matrix R and a translation t. Transforms compose with
+/// operator *, where (a*b)*p == a*(b*p).
+class rigid_transform
+{
+    public:
+
+    /// \brief Default constructor; the identity transform.
+    rigid_transform();
+
+    /// \brief Construct a transform from a rotation quaternion, which is
+    /// normalized, and a translation.
+    rigid_transform(const quaternion &q, const column_vector<3> &t);
+
+    /// \brief Construct a transform from a rotation about an axis, and
+    /// a translation.
+    rigid_transform(const axis_angle &aa, const column_vector<3> &t);
+
+    /// \brief Construct a transform from a rotation matrix, which must
+    /// be orthonormal, and a translation.
+    rigid_transform(const matrix<3, 3> &rotation, const column_vector<3> &t);
+
+    /// \brief Get a const ref to the rotation matrix.
+    const matrix<3, 3>& rotation() const;
+
+    /// \brief Get a const ref to the translation.
+    const column_vector<3>& translation() const;
+
+    /// \brief Get the equivalent 4x4 homogeneous transformation matrix.
+    matrix<4, 4> homogeneous() const;
+
+    /// \brief Transform count points, stored contiguously as x, y, z
+    /// triples, from in to out. in and out may be the same array, but
+    /// must not otherwise overlap. The points are split into threads
+    /// equal chunks, each transformed on its own thread.
+    void apply(const double *in, double *out, size_t count,
+               size_t threads = 1) const;
+
+    /// \brief Transform every point in a vector.
+    std::vector<column_vector<3>> apply(
+        const std::vector<column_vector<3>> &points,
+        size_t threads = 1) const;
+
+    /// \brief Transform a batch of points into out, which is resized to
+    /// match if needed, so that transforming a stream of equally sized
+    /// batches does not allocate. out must not be points.
+    void apply(const vector_batch<3> &points, vector_batch<3> &out) const;
+
+    private:
+
+    /// \brief The rotation.
+    matrix<3, 3> _rotation;
+    /// \brief The translation.
+    column_vector<3> _translation;
+};
+
+/// \brief Convenience typedef for a rigid transform.
+using se3 = rigid_transform;
+
+/// \brief Composition of two transforms; the right transform is
+/// applied first.
+rigid_transform operator * (const rigid_transform &left,
+                            const rigid_transform &right);
+
+/// \brief Transform a point.
+column_vector<3> operator * (const rigid_transform &tf,
+                             const column_vector<3> &p);
+
+/// \brief Transform a batch of points.
+vector_batch<3> operator * (const rigid_transform &tf,
+                            const vector_batch<3> &points);
+
+/// \brief Get the inverse of a transform, which maps p to
+/// R^T*p - R^T*t.
+rigid_transform inverse(const rigid_transform &tf);
+
+/// \brief Print a rigid transform to a std::ostream.
+std::ostream& operator << (std::ostream &os, const rigid_transform &tf);
+
+} // namespace lambda
+
+#endif // LAMBDA_RIGID_TRANSFORM_HPP
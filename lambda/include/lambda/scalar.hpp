@@ -0,0 +1,42 @@
+#ifndef LAMBDA_SCALAR_HPP
+#define LAMBDA_SCALAR_HPP
+
+/*!
+    \file
+    \brief Defines lambda::scalar_traits, which describe the element
+    types a lambda::matrix can hold.
+*/
+
+namespace lambda
+{
+
+/// \brief Properties of a matrix element type. The primary template
+/// covers real types such as float, double and long double; other
+/// element types, like lambda::complex, specialize it.
+template <class T> struct scalar_traits
+{
+    /// \brief The type of the magnitude of a T.
+    using real_type = T;
+
+    /// \brief The absolute value of x.
+    static constexpr real_type magnitude(const T &x)
+    {
+        return x < T(0) ? -x : x;
+    }
+
+    /// \brief The square of the absolute value of x.
+    static constexpr real_type squared_magnitude(const T &x)
+    {
+        return x*x;
+    }
+
+    /// \brief The complex conjugate of x.
+    static constexpr T conjugate(const T &x)
+    {
+        return x;
+    }
+};
+
+} // namespace lambda
+
+#endif // LAMBDA_SCALAR_HPP
@@ -0,0 +1,118 @@
+#ifndef LAMBDA_SERIALIZATION_HPP
+#define LAMBDA_SERIALIZATION_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "lambda/matrix.hpp"
+#include "lambda/dynamic_matrix.hpp"
+
+/*!
+    \file
+    \brief Defines a compact binary encoding of matrices, for logging
+    and replaying them without parsing text. An encoded matrix is a
+    24 byte header followed by its elements:
+
+        bytes  0-3   magic number "LMAT"
+        bytes  4-7   version, a little-endian uint32, currently 1
+        bytes  8-15  rows, a little-endian uint64
+        bytes 16-23  columns, a little-endian uint64
+        bytes 24-    rows*columns little-endian IEEE 754 doubles,
+                     in row-major order
+
+    Encoded matrices may be written back to back on one stream, and
+    read back in the same order.
+*/
+
+namespace lambda
+{
+
+/// \brief The header of an encoded matrix.
+struct encoding_header
+{
+    /// \brief The number of rows.
+    uint64_t rows;
+    /// \brief The number of columns.
+    uint64_t columns;
+};
+
+namespace detail
+{
+
+/// \brief The size, in bytes, of the header of an encoded matrix.
+constexpr size_t encoding_header_size = 24;
+
+/// \brief The version of the encoding written by lambda::write.
+constexpr uint32_t encoding_version = 1;
+
+/// \brief Write the encoding of a header into encoding_header_size
+/// bytes.
+void encode_header(char *bytes, const encoding_header &header);
+
+/// \brief Decode a header from encoding_header_size bytes. Throws
+/// std::invalid_argument if they are not the header of an encoded
+/// matrix of a supported version.
+encoding_header decode_header(const char *bytes);
+
+/// \brief Write count doubles to a stream in little-endian order.
+void write_elements(std::ostream &os, const double *data, size_t count);
+
+/// \brief Read count little-endian doubles from a stream. Throws
+/// std::runtime_error if the stream ends first.
+void read_elements(std::istream &is, double *data, size_t count);
+
+} // namespace detail
+
+/// \brief Write the header of an encoded rows x columns matrix.
+void write_header(std::ostream &os, const encoding_header &header);
+
+/// \brief Read the header of an encoded matrix. Throws
+/// std::invalid_argument if the stream does not hold an encoded matrix
+/// of a supported version, and std::runtime_error if it ends before
+/// the end of the header.
+encoding_header read_header(std::istream &is);
+
+/// \brief Write the binary encoding of a matrix to a stream. As with
+/// operator <<, errors are reported through the state of the stream.
+template <size_t M, size_t N>
+void write(std::ostream &os, const matrix<M, N> &m)
+{
+    write_header(os, { M, N });
+    detail::write_elements(os, m.data().data(), M*N);
+}
+
+/// \brief Read the binary encoding of an MxN matrix from a stream.
+/// Throws std::invalid_argument if the stream holds a matrix of any
+/// other size, and std::runtime_error if it ends before the end of the
+/// matrix. m is unchanged if the header cannot be read.
+template <size_t M, size_t N>
+void read(std::istream &is, matrix<M, N> &m)
+{
+    const encoding_header header = read_header(is);
+    if (header.rows != M || header.columns != N)
+    {
+        std::stringstream ss;
+        ss << "Cannot read " << M << "x" << N << " matrix from encoding of "
+            << header.rows << "x" << header.columns << " matrix";
+        throw std::invalid_argument(ss.str());
+    }
+    detail::read_elements(is, &m[0], M*N);
+}
+
+/// \brief Write the binary encoding of a matrix to a stream. As with
+/// operator <<, errors are reported through the state of the stream.
+void write(std::ostream &os, const dynamic_matrix &m);
+
+/// \brief Read the binary encoding of a matrix of any size from a
+/// stream, resizing m to match. If m already has the size of the
+/// encoded matrix, its elements are read in place, without allocating.
+/// Throws std::runtime_error if the stream ends before the end of the
+/// matrix.
+void read(std::istream &is, dynamic_matrix &m);
+
+} // namespace lambda
+
+#endif // LAMBDA_SERIALIZATION_HPP
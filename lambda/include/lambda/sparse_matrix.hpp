@@ -0,0 +1,176 @@
+#ifndef LAMBDA_SPARSE_MATRIX_HPP
+#define LAMBDA_SPARSE_MATRIX_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+#include "lambda/dynamic_matrix.hpp"
+#include "lambda/memory.hpp"
+
+/*!
+    \file
+    \brief Defines lambda::sparse_matrix, a matrix stored in compressed
+    sparse row (CSR) form, and lambda::sparse_builder, which assembles
+    one from (row, column, value) triplets in any order. Products with
+    dense matrices take and return dynamic_matrix.
+*/
+
+namespace lambda
+{
+
+/// \brief A matrix which stores only its nonzero elements, row by row.
+/// Row i's elements are values()[row_offsets()[i]] up to
+/// values()[row_offsets()[i + 1]], in columns column_indices()[...],
+/// sorted by column, with no column repeated.
+class sparse_matrix
+{
+    public:
+
+    // As with dynamic_matrix, each constructor allocates from the given
+    // memory resource, and a matrix keeps its resource when assigned to.
+
+    /// \brief Copy constructor.
+    sparse_matrix(const sparse_matrix &other,
+                  std::pmr::memory_resource *resource = matrix_resource());
+
+    /// \brief Move constructor.
+    sparse_matrix(sparse_matrix &&other) noexcept = default;
+
+    /// \brief Construct a rows x columns matrix of zeros.
+    sparse_matrix(size_t rows, size_t columns,
+                  std::pmr::memory_resource *resource = matrix_resource());
+
+    /// \brief Construct from the nonzero elements of a dense matrix.
+    explicit sparse_matrix(const dynamic_matrix &dense,
+                           std::pmr::memory_resource *resource =
+                               matrix_resource());
+
+    /// \brief Construct from CSR arrays, as returned by row_offsets(),
+    /// column_indices() and values(). Throws std::invalid_argument if
+    /// they do not describe a rows x columns matrix.
+    sparse_matrix(size_t rows, size_t columns,
+                  std::pmr::vector<size_t> row_offsets,
+                  std::pmr::vector<size_t> column_indices,
+                  std::pmr::vector<double> values);
+
+    sparse_matrix& operator = (const sparse_matrix &m) = default;
+
+    sparse_matrix& operator = (sparse_matrix &&m) = default;
+
+    /// \brief Multiply this matrix by a scalar, in place.
+    sparse_matrix& operator *= (double scalar);
+
+    /// \brief Get the number of rows in this matrix.
+    size_t rows() const;
+
+    /// \brief Get the number of columns in this matrix.
+    size_t columns() const;
+
+    /// \brief Get the number of elements stored.
+    size_t nonzeros() const;
+
+    /// \brief Get the element in row i, column j, which is zero unless
+    /// it is stored. Takes time logarithmic in the length of the row.
+    double operator () (size_t i, size_t j) const;
+
+    /// \brief Same as operator (), but throws an exception if
+    /// the index provided is out of bounds.
+    double at(size_t i, size_t j) const;
+
+    /// \brief Get the offset of the first element of each row, followed
+    /// by nonzeros().
+    const std::pmr::vector<size_t>& row_offsets() const;
+
+    /// \brief Get the column of each element stored.
+    const std::pmr::vector<size_t>& column_indices() const;
+
+    /// \brief Get each element stored.
+    const std::pmr::vector<double>& values() const;
+
+    /// \brief Get the memory resource this matrix allocates from.
+    std::pmr::memory_resource* resource() const;
+
+    private:
+
+    std::pmr::vector<size_t> _offsets;
+    std::pmr::vector<size_t> _indices;
+    std::pmr::vector<double> _values;
+    size_t _rows, _columns;
+};
+
+/// \brief Collects the elements of a sparse matrix as (row, column,
+/// value) triplets, in coordinate (COO) form, then compresses them.
+class sparse_builder
+{
+    public:
+
+    /// \brief Begin a rows x columns matrix with no elements.
+    sparse_builder(size_t rows, size_t columns);
+
+    /// \brief Add value to element (i, j). Elements added more than once
+    /// are summed. Throws an exception if the index is out of bounds.
+    void add(size_t i, size_t j, double value);
+
+    /// \brief Reserve space for count elements.
+    void reserve(size_t count);
+
+    /// \brief Get the number of elements added.
+    size_t size() const;
+
+    /// \brief Build the CSR matrix of the elements added so far. Takes
+    /// time linear in their number, plus sorting within each row.
+    sparse_matrix build(std::pmr::memory_resource *resource =
+                            matrix_resource()) const;
+
+    private:
+
+    struct triplet
+    {
+        size_t row, column;
+        double value;
+    };
+
+    std::vector<triplet> _triplets;
+    size_t _rows, _columns;
+};
+
+/// \brief Compares the elements of two sparse matrices, treating
+/// elements which are not stored as zero.
+bool operator == (const sparse_matrix &left, const sparse_matrix &right);
+
+/// \brief Get the dense equivalent of a sparse matrix.
+dynamic_matrix to_dense(const sparse_matrix &m,
+                        std::pmr::memory_resource *resource =
+                            matrix_resource());
+
+/// \brief Get the transpose of a sparse matrix.
+sparse_matrix transpose(const sparse_matrix &m);
+
+// Products of large sparse matrices are split between
+// lambda::thread_count() threads by bands of the result, each computed
+// the same way on any thread; see parallel.hpp.
+
+/// \brief Multiplication of a sparse matrix by a dense matrix; with a
+/// single column, the sparse matrix-vector product.
+dynamic_matrix operator * (const sparse_matrix &left,
+                           const dynamic_matrix &right);
+
+/// \brief Computes the product of the transpose of left and right,
+/// without forming the transpose.
+dynamic_matrix transpose_multiply(const sparse_matrix &left,
+                                  const dynamic_matrix &right);
+
+/// \brief Addition of two sparse matrices.
+sparse_matrix operator + (const sparse_matrix &left,
+                          const sparse_matrix &right);
+
+/// \brief Multiplication of a sparse matrix by a scalar.
+sparse_matrix operator * (const sparse_matrix &m, double scalar);
+
+/// \brief Multiplication of a sparse matrix by a scalar.
+sparse_matrix operator * (double scalar, const sparse_matrix &m);
+
+} // namespace lambda
+
+#endif // LAMBDA_SPARSE_MATRIX_HPP
@@ -0,0 +1,309 @@
+#ifndef LAMBDA_VIEW_HPP
+#define LAMBDA_VIEW_HPP
+
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+#include "lambda/matrix.hpp"
+
+/*!
+    \file
+    \brief Defines lambda::matrix_view, which refers to part of a matrix
+    without copying it, and the functions block, row, col and diagonal
+    which make views. A view is an expression like any other, so it can
+    be an operand of any arithmetic, and a view of a non-const matrix
+    can be assigned to, writing through to the matrix.
+*/
+
+namespace lambda
+{
+
+/// \brief An RxC view of the elements of a matrix. Element (i, j) of
+/// the view is element Stride*i + j of the matrix's storage, counted
+/// from the first element of the view; a block of a matrix with N
+/// columns has a stride of N, and its diagonal a stride of N + 1.
+/// \param R The number of rows of the view.
+/// \param C The number of columns of the view.
+/// \param Stride The distance between rows of the view, in elements.
+/// \param T The element type; const for a read-only view.
+template <size_t R, size_t C, size_t Stride, class T>
+class matrix_view : public matrix_expression<matrix_view<R, C, Stride, T>>
+{
+    public:
+
+    using value_type = typename std::remove_const<T>::type;
+
+    static constexpr size_t rows = R;
+    static constexpr size_t cols = C;
+
+    /// \brief Constructs a view whose first element is at data, in the
+    /// storage of the matrix at parent.
+    constexpr matrix_view(T *data, const void *parent) :
+        _data(data), _parent(parent) { }
+
+    /// \brief Views are copied by reference; the copy refers to the
+    /// same elements.
+    constexpr matrix_view(const matrix_view &other) = default;
+
+    /// \brief Assign the elements of another view to the elements of
+    /// this one.
+    constexpr matrix_view& operator = (const matrix_view &other)
+    {
+        return *this = static_cast<
+            const matrix_expression<matrix_view>&>(other);
+    }
+
+    /// \brief Assign the result of an expression to the viewed elements.
+    /// If the expression reads the viewed matrix, it is evaluated into a
+    /// temporary first.
+    template <class E>
+    constexpr matrix_view& operator = (const matrix_expression<E> &e)
+    {
+        static_assert(E::rows == R && E::cols == C,
+            "Cannot assign expression of different dimensions");
+        static_assert(!std::is_const<T>::value,
+            "Cannot assign to a view of a const matrix");
+        if (e.self().reads(_parent))
+        {
+            return *this = matrix<R, C, value_type>(e);
+        }
+        evaluator<E> ev(e.self());
+        for (size_t i = 0; i < R; ++i)
+        {
+            for (size_t j = 0; j < C; ++j)
+            {
+                (*this)(i, j) = ev(i, j);
+            }
+        }
+        return *this;
+    }
+
+    /// \brief Add an expression to the viewed elements in place.
+    template <class E>
+    constexpr matrix_view& operator += (const matrix_expression<E> &e)
+    {
+        static_assert(E::rows == R && E::cols == C,
+            "Cannot add matrices of different dimensions");
+        if (e.self().reads(_parent))
+        {
+            return *this += matrix<R, C, value_type>(e);
+        }
+        evaluator<E> ev(e.self());
+        for (size_t i = 0; i < R; ++i)
+        {
+            for (size_t j = 0; j < C; ++j)
+            {
+                (*this)(i, j) += ev(i, j);
+            }
+        }
+        return *this;
+    }
+
+    /// \brief Subtract an expression from the viewed elements in place.
+    template <class E>
+    constexpr matrix_view& operator -= (const matrix_expression<E> &e)
+    {
+        static_assert(E::rows == R && E::cols == C,
+            "Cannot subtract matrices of different dimensions");
+        if (e.self().reads(_parent))
+        {
+            return *this -= matrix<R, C, value_type>(e);
+        }
+        evaluator<E> ev(e.self());
+        for (size_t i = 0; i < R; ++i)
+        {
+            for (size_t j = 0; j < C; ++j)
+            {
+                (*this)(i, j) -= ev(i, j);
+            }
+        }
+        return *this;
+    }
+
+    /// \brief Multiply the viewed elements by a scalar in place.
+    template <class S, typename std::enable_if<
+        is_scalar_of<S, value_type>::value, int>::type = 0>
+    constexpr matrix_view& operator *= (S scalar)
+    {
+        for (size_t i = 0; i < R; ++i)
+        {
+            for (size_t j = 0; j < C; ++j)
+            {
+                (*this)(i, j) *= scalar;
+            }
+        }
+        return *this;
+    }
+
+    /// \brief Divide the viewed elements by a scalar in place.
+    template <class S, typename std::enable_if<
+        is_scalar_of<S, value_type>::value, int>::type = 0>
+    constexpr matrix_view& operator /= (S divisor)
+    {
+        return *this *= value_type(1)/value_type(divisor);
+    }
+
+    /// \brief Get a reference to element (i, j) of the view.
+    constexpr T& operator () (size_t i, size_t j) const
+    {
+        return _data[Stride*i + j];
+    }
+
+    /// \brief Get a reference to element i of the view, counted in
+    /// row-major order.
+    constexpr T& operator [] (size_t i) const
+    {
+        return (*this)(i / C, i % C);
+    }
+
+    /// \brief Whether this view reads from the matrix at p.
+    constexpr bool reads(const void *p) const
+    {
+        return p == _parent;
+    }
+
+    /// \brief Element (i, j) of a view is generally not element (i, j)
+    /// of the matrix, so reading it while writing the matrix in place
+    /// is never safe.
+    constexpr bool aliases(const void *p) const
+    {
+        return reads(p);
+    }
+
+    private:
+
+    T *_data;
+    const void *_parent;
+};
+
+template <size_t R, size_t C, size_t Stride, class T>
+struct is_direct<matrix_view<R, C, Stride, T>> : std::true_type { };
+
+template <size_t R, size_t C, size_t Stride, class T>
+class evaluator<matrix_view<R, C, Stride, T>>
+{
+    public:
+
+    using value_type = typename matrix_view<R, C, Stride, T>::value_type;
+
+    constexpr explicit evaluator(const matrix_view<R, C, Stride, T> &v)
+        : _v(v) { }
+
+    constexpr value_type operator () (size_t i, size_t j) const
+    {
+        return _v(i, j);
+    }
+
+    private:
+
+    matrix_view<R, C, Stride, T> _v;
+};
+
+namespace detail
+{
+
+/// \brief Throws the exception for a block which does not fit.
+template <size_t R, size_t C, size_t M, size_t N>
+[[noreturn]] void block_out_of_range(size_t r0, size_t c0)
+{
+    std::stringstream ss;
+    ss << "Cannot take " << R << "x" << C << " block at ("
+        << r0 << ", " << c0 << ") of " << M << "x" << N << " matrix";
+    throw std::out_of_range(ss.str());
+}
+
+/// \brief Throws an exception if an RxC block at (r0, c0) does not fit
+/// in an MxN matrix.
+template <size_t R, size_t C, size_t M, size_t N>
+constexpr void block_check(size_t r0, size_t c0)
+{
+    if (r0 > M - R || c0 > N - C) block_out_of_range<R, C, M, N>(r0, c0);
+}
+
+} // namespace detail
+
+/// \brief Get a view of the RxC block of a matrix whose top left element
+/// is (r0, c0).
+template <size_t R, size_t C, size_t M, size_t N, class T>
+constexpr matrix_view<R, C, N, T>
+block(matrix<M, N, T> &m, size_t r0, size_t c0)
+{
+    static_assert(R <= M && C <= N, "Block is larger than the matrix");
+    detail::block_check<R, C, M, N>(r0, c0);
+    return matrix_view<R, C, N, T>(&m(r0, c0), &m);
+}
+
+/// \brief Get a read-only view of the RxC block of a matrix whose top
+/// left element is (r0, c0).
+template <size_t R, size_t C, size_t M, size_t N, class T>
+constexpr matrix_view<R, C, N, const T>
+block(const matrix<M, N, T> &m, size_t r0, size_t c0)
+{
+    static_assert(R <= M && C <= N, "Block is larger than the matrix");
+    detail::block_check<R, C, M, N>(r0, c0);
+    return matrix_view<R, C, N, const T>(
+        m.data().data() + N*r0 + c0, &m);
+}
+
+/// \brief Get a view of row i of a matrix.
+template <size_t M, size_t N, class T>
+constexpr matrix_view<1, N, N, T> row(matrix<M, N, T> &m, size_t i)
+{
+    return block<1, N>(m, i, 0);
+}
+
+/// \brief Get a read-only view of row i of a matrix.
+template <size_t M, size_t N, class T>
+constexpr matrix_view<1, N, N, const T>
+row(const matrix<M, N, T> &m, size_t i)
+{
+    return block<1, N>(m, i, 0);
+}
+
+/// \brief Get a view of column j of a matrix.
+template <size_t M, size_t N, class T>
+constexpr matrix_view<M, 1, N, T> col(matrix<M, N, T> &m, size_t j)
+{
+    return block<M, 1>(m, 0, j);
+}
+
+/// \brief Get a read-only view of column j of a matrix.
+template <size_t M, size_t N, class T>
+constexpr matrix_view<M, 1, N, const T>
+col(const matrix<M, N, T> &m, size_t j)
+{
+    return block<M, 1>(m, 0, j);
+}
+
+/// \brief Get a view of the main diagonal of a matrix, as a column.
+template <size_t M, size_t N, class T>
+constexpr matrix_view<(M < N ? M : N), 1, N + 1, T>
+diagonal(matrix<M, N, T> &m)
+{
+    return matrix_view<(M < N ? M : N), 1, N + 1, T>(&m(0, 0), &m);
+}
+
+/// \brief Get a read-only view of the main diagonal of a matrix, as a
+/// column.
+template <size_t M, size_t N, class T>
+constexpr matrix_view<(M < N ? M : N), 1, N + 1, const T>
+diagonal(const matrix<M, N, T> &m)
+{
+    return matrix_view<(M < N ? M : N), 1, N + 1, const T>(
+        m.data().data(), &m);
+}
+
+// Views of temporaries would dangle.
+template <size_t R, size_t C, size_t M, size_t N, class T>
+void block(matrix<M, N, T> &&, size_t, size_t) = delete;
+template <size_t M, size_t N, class T>
+void row(matrix<M, N, T> &&, size_t) = delete;
+template <size_t M, size_t N, class T>
+void col(matrix<M, N, T> &&, size_t) = delete;
+template <size_t M, size_t N, class T>
+void diagonal(matrix<M, N, T> &&) = delete;
+
+} // namespace lambda
+
+#endif // LAMBDA_VIEW_HPP
@@ -6,6 +6,8 @@ namespace lambda
 
 complex::complex() : _real(0), _imag(0) { }
 
+complex::complex(double real) : _real(real), _imag(0) { }
+
 complex::complex(double real, double imag) :
     _real(real), _imag(imag) { }
 
@@ -105,6 +107,40 @@ complex operator - (complex c)
     return complex(-c.real(), -c.imag());
 }
 
+bool operator == (complex c1, complex c2)
+{
+    return c1.real() == c2.real() && c1.imag() == c2.imag();
+}
+
+bool operator != (complex c1, complex c2)
+{
+    return !(c1 == c2);
+}
+
+std::ostream& operator << (std::ostream &os, complex c)
+{
+    os << c.real();
+    if (c.imag() < 0) os << "-" << -c.imag() << "i";
+    else os << "+" << c.imag() << "i";
+    return os;
+}
+
+std::to_chars_result to_chars(char *first, char *last, complex c,
+                              int precision)
+{
+    std::to_chars_result r = std::to_chars(first, last, c.real(),
+        std::chars_format::fixed, precision);
+    if (r.ec != std::errc()) return r;
+    if (r.ptr == last) return { last, std::errc::value_too_large };
+    *r.ptr++ = c.imag() < 0 ? '-' : '+';
+    r = std::to_chars(r.ptr, last, std::abs(c.imag()),
+                      std::chars_format::fixed, precision);
+    if (r.ec != std::errc()) return r;
+    if (r.ptr == last) return { last, std::errc::value_too_large };
+    *r.ptr++ = 'i';
+    return r;
+}
+
 double arg(complex c)
 {
     return std::atan2(c.imag(), c.real());
@@ -1,6 +1,52 @@
-
 #include "lambda/crc.hpp"
 
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+
+namespace lambda
+{
+
 std::vector<bool> crc(const std::vector<uint8_t> &data,
-                      const std::vector<bool> &poly);
+                      const std::vector<bool> &poly)
+{
+    if (poly.size() < 2 || poly.size() > 65 || !poly[0])
+    {
+        std::stringstream ss;
+        ss << "Cannot compute CRC with polynomial of " << poly.size()
+            << " bits, which must have degree 1 to 64";
+        throw std::invalid_argument(ss.str());
+    }
+
+    // The register holds the remainder; the leading term of the
+    // polynomial is implied by the bit shifted out of it.
+    const size_t degree = poly.size() - 1;
+    const uint64_t top = uint64_t(1) << (degree - 1);
+    const uint64_t mask = top | (top - 1);
+    uint64_t generator = 0;
+    for (size_t i = 1; i < poly.size(); ++i)
+    {
+        generator = (generator << 1) | poly[i];
+    }
+
+    uint64_t remainder = 0;
+    for (uint8_t byte : data)
+    {
+        for (int bit = 7; bit >= 0; --bit)
+        {
+            const bool feedback = ((remainder & top) != 0) ^
+                                  ((byte >> bit) & 1);
+            remainder = (remainder << 1) & mask;
+            if (feedback) remainder ^= generator;
+        }
+    }
+
+    std::vector<bool> ret(degree);
+    for (size_t i = 0; i < degree; ++i)
+    {
+        ret[i] = (remainder >> (degree - 1 - i)) & 1;
+    }
+    return ret;
+}
 
+} // namespace lambda
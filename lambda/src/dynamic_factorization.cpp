@@ -0,0 +1,718 @@
+// dynamic_factorization.cpp
+
+#include "lambda/dynamic_factorization.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+#include "lambda/gemm.hpp"
+#include "lambda/kernels.hpp"
+#include "lambda/memory.hpp"
+
+namespace lambda
+{
+
+namespace
+{
+
+/// \brief The columns below which LU and Cholesky factorizations stop
+/// halving the matrix, and factor it with vector loops instead. Every
+/// split hands the work outside the halves to gemm, with a depth of
+/// half the columns split, so almost all of the work is done by gemm.
+constexpr size_t leaf = 16;
+
+/// \brief The rows in each block of a triangular solve, and the columns
+/// in each panel of a QR factorization. Work within a block is done by
+/// vector loops, and work between blocks by gemm with this depth.
+constexpr size_t block = 64;
+
+/// \brief The columns of each band of a symmetric update, of which only
+/// the lower triangle is computed.
+constexpr size_t band = 256;
+
+/// \brief Throws an exception unless a matrix is square.
+void require_square(const dynamic_matrix &m, const char *what)
+{
+    if (m.rows() != m.columns())
+    {
+        std::stringstream ss;
+        ss << "Cannot take " << what << " of matrix of dimensions "
+            << m.rows() << "x" << m.columns();
+        throw std::invalid_argument(ss.str());
+    }
+}
+
+/// \brief Throws an exception unless B has the given number of rows.
+void require_rows(const dynamic_matrix &B, size_t rows)
+{
+    if (B.rows() != rows)
+    {
+        std::stringstream ss;
+        ss << "Cannot solve system of " << rows << " equations with "
+            << "right hand side of dimensions "
+            << B.rows() << "x" << B.columns();
+        throw std::invalid_argument(ss.str());
+    }
+}
+
+/// \brief Get the NxN identity matrix.
+dynamic_matrix identity(size_t N)
+{
+    dynamic_matrix I(N, N);
+    for (size_t i = 0; i < N; ++i)
+    {
+        I(i, i) = 1;
+    }
+    return I;
+}
+
+/// \brief Computes b -= x*a over n elements.
+void subtract_scaled(double *b, const double *a, double x, size_t n)
+{
+    size_t j = 0;
+#if defined(__AVX2__)
+    using kernels::detail::fmadd;
+    const __m256d s = _mm256_set1_pd(-x);
+    for (; j + 4 <= n; j += 4)
+    {
+        _mm256_storeu_pd(b + j, fmadd(s, _mm256_loadu_pd(a + j),
+                                      _mm256_loadu_pd(b + j)));
+    }
+#elif defined(__SSE2__)
+    using kernels::detail::fmadd;
+    const __m128d s = _mm_set1_pd(-x);
+    for (; j + 2 <= n; j += 2)
+    {
+        _mm_storeu_pd(b + j, fmadd(s, _mm_loadu_pd(a + j),
+                                   _mm_loadu_pd(b + j)));
+    }
+#endif
+    for (; j < n; ++j)
+    {
+        b[j] -= x*a[j];
+    }
+}
+
+/// \brief Writes the transpose of the rows x columns matrix a to t, in
+/// square tiles, so that the reads and writes of each tile stay in
+/// cache.
+void transpose_copy(const double *a, size_t lda, size_t rows,
+                    size_t columns, double *t, size_t ldt)
+{
+    constexpr size_t tile = 32;
+    for (size_t i0 = 0; i0 < rows; i0 += tile)
+    {
+        const size_t i1 = std::min(rows, i0 + tile);
+        for (size_t j0 = 0; j0 < columns; j0 += tile)
+        {
+            const size_t j1 = std::min(columns, j0 + tile);
+            for (size_t i = i0; i < i1; ++i)
+            {
+                for (size_t j = j0; j < j1; ++j)
+                {
+                    t[j*ldt + i] = a[i*lda + j];
+                }
+            }
+        }
+    }
+}
+
+/// \brief Solves LX = B in place, where L is the lower triangle of an
+/// NxN matrix, with a diagonal of ones if unit, and B is N x K.
+void lower_solve(const double *L, size_t ldl, size_t N, bool unit,
+                 double *B, size_t ldb, size_t K)
+{
+    for (size_t i0 = 0; i0 < N; i0 += block)
+    {
+        const size_t i1 = std::min(N, i0 + block);
+        for (size_t i = i0; i < i1; ++i)
+        {
+            double *b = B + i*ldb;
+            for (size_t p = i0; p < i; ++p)
+            {
+                subtract_scaled(b, B + p*ldb, L[i*ldl + p], K);
+            }
+            if (!unit)
+            {
+                const double scale = 1/L[i*ldl + i];
+                for (size_t j = 0; j < K; ++j) b[j] *= scale;
+            }
+        }
+        if (i1 < N)
+        {
+            gemm(N - i1, K, i1 - i0, -1, L + i1*ldl + i0, ldl,
+                 B + i0*ldb, ldb, 1, B + i1*ldb, ldb);
+        }
+    }
+}
+
+/// \brief Solves UX = B in place, where U is the upper triangle of an
+/// NxN matrix, and B is N x K.
+void upper_solve(const double *U, size_t ldu, size_t N,
+                 double *B, size_t ldb, size_t K)
+{
+    for (size_t i1 = N; i1 > 0; )
+    {
+        const size_t i0 = i1 > block ? i1 - block : 0;
+        for (size_t i = i1; i-- > i0; )
+        {
+            double *b = B + i*ldb;
+            for (size_t p = i + 1; p < i1; ++p)
+            {
+                subtract_scaled(b, B + p*ldb, U[i*ldu + p], K);
+            }
+            const double scale = 1/U[i*ldu + i];
+            for (size_t j = 0; j < K; ++j) b[j] *= scale;
+        }
+        if (i0 > 0)
+        {
+            gemm(i0, K, i1 - i0, -1, U + i0, ldu, B + i0*ldb, ldb,
+                 1, B, ldb);
+        }
+        i1 = i0;
+    }
+}
+
+/// \brief Factors columns [k0, k1) of the NxN matrix a, from row k0
+/// down, into PA = LU, choosing pivots from those rows and swapping
+/// them whole. The columns to the left must already be factored, and
+/// the columns to the right are left for the caller. Recurses on each
+/// half of the columns, updating the right half from the left with a
+/// triangular solve and gemm.
+void lu_columns(double *a, size_t N, size_t k0, size_t k1,
+                std::pmr::vector<size_t> &perm, int &sign)
+{
+    if (k1 - k0 > leaf)
+    {
+        const size_t mid = k0 + (k1 - k0)/2;
+        lu_columns(a, N, k0, mid, perm, sign);
+        lower_solve(a + k0*N + k0, N, mid - k0, true,
+                    a + k0*N + mid, N, k1 - mid);
+        gemm(N - mid, k1 - mid, mid - k0, -1, a + mid*N + k0, N,
+             a + k0*N + mid, N, 1, a + mid*N + mid, N);
+        lu_columns(a, N, mid, k1, perm, sign);
+        return;
+    }
+
+    // The leaf is factored in a compact copy, whose rows are adjacent
+    // in memory, since each column visits every row below it; swaps are
+    // then applied to the rest of each row.
+    const size_t rows = N - k0, width = k1 - k0;
+    std::pmr::vector<double> panel(rows*width, matrix_resource());
+    for (size_t r = 0; r < rows; ++r)
+    {
+        std::copy(a + (k0 + r)*N + k0, a + (k0 + r)*N + k1,
+                  panel.data() + r*width);
+    }
+    size_t pivots[leaf];
+    for (size_t k = 0; k < width; ++k)
+    {
+        double *p = panel.data();
+        size_t pivot = k;
+        for (size_t r = k + 1; r < rows; ++r)
+        {
+            if (std::abs(p[r*width + k]) > std::abs(p[pivot*width + k]))
+            {
+                pivot = r;
+            }
+        }
+        pivots[k] = pivot;
+        if (p[pivot*width + k] == 0)
+        {
+            sign = 0;
+            continue;
+        }
+        if (pivot != k)
+        {
+            std::swap_ranges(p + k*width, p + (k + 1)*width,
+                             p + pivot*width);
+            sign = -sign;
+        }
+        const double inv_pivot = 1/p[k*width + k];
+        for (size_t r = k + 1; r < rows; ++r)
+        {
+            const double l = p[r*width + k] *= inv_pivot;
+            subtract_scaled(p + r*width + k + 1, p + k*width + k + 1, l,
+                            width - k - 1);
+        }
+    }
+    for (size_t r = 0; r < rows; ++r)
+    {
+        std::copy(panel.data() + r*width, panel.data() + (r + 1)*width,
+                  a + (k0 + r)*N + k0);
+    }
+    for (size_t k = 0; k < width; ++k)
+    {
+        if (pivots[k] == k) continue;
+        double *x = a + (k0 + k)*N, *y = a + (k0 + pivots[k])*N;
+        std::swap_ranges(x, x + k0, y);
+        std::swap_ranges(x + k1, x + N, y + k1);
+        std::swap(perm[k0 + k], perm[k0 + pivots[k]]);
+    }
+}
+
+/// \brief Factors the block [k0, k1) x [k0, k1) on the diagonal of the
+/// NxN matrix a into LL^T, reading and writing its lower triangle.
+/// Recurses on each half; between them, the block of L below the first
+/// half is found by a triangular solve, and the second half updated
+/// from it by gemm.
+void cholesky_block(double *a, size_t N, size_t k0, size_t k1)
+{
+    if (k1 - k0 <= leaf)
+    {
+        for (size_t i = k0; i < k1; ++i)
+        {
+            double *l = a + i*N;
+            for (size_t j = k0; j <= i; ++j)
+            {
+                double x = l[j];
+                for (size_t p = k0; p < j; ++p)
+                {
+                    x -= l[p]*a[j*N + p];
+                }
+                if (i != j)
+                {
+                    l[j] = x/a[j*N + j];
+                }
+                else if (x > 0)
+                {
+                    l[j] = std::sqrt(x);
+                }
+                else
+                {
+                    throw std::domain_error("Cannot take Cholesky "
+                        "factorization of matrix which is not positive "
+                        "definite");
+                }
+            }
+        }
+        return;
+    }
+
+    const size_t mid = k0 + (k1 - k0)/2, b = mid - k0, M = k1 - mid;
+    cholesky_block(a, N, k0, mid);
+
+    // L21 solves X*L11^T = A21, or L11*X^T = A21^T, which is solved on
+    // a transposed copy; the copy is then the right operand of the
+    // update A22 -= L21*L21^T.
+    std::pmr::vector<double> transposed(b*M, matrix_resource());
+    transpose_copy(a + mid*N + k0, N, M, b, transposed.data(), M);
+    lower_solve(a + k0*N + k0, N, b, false, transposed.data(), M, M);
+    transpose_copy(transposed.data(), M, b, M, a + mid*N + k0, N);
+    for (size_t j0 = 0; j0 < M; j0 += band)
+    {
+        const size_t width = std::min(M - j0, band);
+        gemm(M - j0, width, b, -1, a + (mid + j0)*N + k0, N,
+             transposed.data() + j0, M, 1, a + (mid + j0)*N + mid + j0, N);
+    }
+    cholesky_block(a, N, mid, k1);
+}
+
+/// \brief Copies a panel of reflections out of the matrix y: Y, which is
+/// M x b and unit lower trapezoidal, into Y, and its transpose into Yt.
+void copy_reflections(const double *y, size_t ldy, size_t M, size_t b,
+                      std::pmr::vector<double> &Y,
+                      std::pmr::vector<double> &Yt)
+{
+    Y.resize(M*b);
+    Yt.resize(b*M);
+    for (size_t r = 0; r < M; ++r)
+    {
+        for (size_t p = 0; p < b; ++p)
+        {
+            const double v = r > p ? y[r*ldy + p] : r == p ? 1 : 0;
+            Y[r*b + p] = v;
+            Yt[p*M + r] = v;
+        }
+    }
+}
+
+/// \brief Applies the product of a panel of reflections, I - Y*T*Y^T, or
+/// its transpose, to the M x K matrix C, where Y and Yt are as copied by
+/// copy_reflections, and T is b x b and upper triangular.
+void apply_reflections(const std::pmr::vector<double> &Y,
+                       const std::pmr::vector<double> &Yt, size_t M,
+                       size_t b, const double *T, size_t ldt,
+                       bool transpose, double *C, size_t ldc, size_t K)
+{
+    if (M == 0 || b == 0 || K == 0) return;
+    std::pmr::vector<double> W(b*K, matrix_resource());
+    gemm(b, K, M, 1, Yt.data(), M, C, ldc, 0, W.data(), K);
+    if (transpose)
+    {
+        // W = T^T*W, from the bottom up, since T^T is lower triangular.
+        for (size_t i = b; i-- > 0; )
+        {
+            double *w = W.data() + i*K;
+            const double t = T[i*ldt + i];
+            for (size_t j = 0; j < K; ++j) w[j] *= t;
+            for (size_t p = 0; p < i; ++p)
+            {
+                subtract_scaled(w, W.data() + p*K, -T[p*ldt + i], K);
+            }
+        }
+    }
+    else
+    {
+        // W = T*W, from the top down.
+        for (size_t i = 0; i < b; ++i)
+        {
+            double *w = W.data() + i*K;
+            const double t = T[i*ldt + i];
+            for (size_t j = 0; j < K; ++j) w[j] *= t;
+            for (size_t p = i + 1; p < b; ++p)
+            {
+                subtract_scaled(w, W.data() + p*K, -T[i*ldt + p], K);
+            }
+        }
+    }
+    gemm(M, K, b, -1, Y.data(), b, W.data(), K, 1, C, ldc);
+}
+
+} // namespace
+
+dynamic_lu::dynamic_lu(const dynamic_matrix &m)
+    : _lu(m), _perm(m.rows(), matrix_resource()), _sign(1)
+{
+    require_square(m, "LU factorization");
+    std::iota(_perm.begin(), _perm.end(), 0);
+    if (size() == 0) return;
+    lu_columns(&_lu[0], size(), 0, size(), _perm, _sign);
+}
+
+size_t dynamic_lu::size() const
+{
+    return _perm.size();
+}
+
+bool dynamic_lu::singular() const
+{
+    return _sign == 0;
+}
+
+const dynamic_matrix& dynamic_lu::packed() const
+{
+    return _lu;
+}
+
+const std::pmr::vector<size_t>& dynamic_lu::permutation() const
+{
+    return _perm;
+}
+
+double dynamic_lu::det() const
+{
+    double product = _sign;
+    for (size_t i = 0; i < size(); ++i)
+    {
+        product *= _lu(i, i);
+    }
+    return product;
+}
+
+dynamic_matrix dynamic_lu::solve(const dynamic_matrix &B) const
+{
+    require_rows(B, size());
+    if (singular())
+    {
+        throw std::domain_error("Cannot solve system with singular matrix");
+    }
+    const size_t N = size(), K = B.columns();
+    dynamic_matrix X(N, K);
+    if (X.data().empty()) return X;
+    for (size_t i = 0; i < N; ++i)
+    {
+        const double *b = B.data().data() + _perm[i]*K;
+        std::copy(b, b + K, &X(i, 0));
+    }
+    lower_solve(_lu.data().data(), N, N, true, &X[0], K, K);
+    upper_solve(_lu.data().data(), N, N, &X[0], K, K);
+    return X;
+}
+
+dynamic_matrix dynamic_lu::inverse() const
+{
+    return solve(identity(size()));
+}
+
+dynamic_cholesky::dynamic_cholesky(const dynamic_matrix &m) : _l(m)
+{
+    require_square(m, "Cholesky factorization");
+    const size_t N = m.rows();
+    if (N == 0) return;
+    double *a = &_l[0];
+    cholesky_block(a, N, 0, N);
+    for (size_t i = 0; i < N; ++i)
+    {
+        for (size_t j = 0; j < i; ++j)
+        {
+            a[j*N + i] = a[i*N + j];
+        }
+    }
+}
+
+size_t dynamic_cholesky::size() const
+{
+    return _l.rows();
+}
+
+dynamic_matrix dynamic_cholesky::lower() const
+{
+    dynamic_matrix L = _l;
+    for (size_t i = 0; i < size(); ++i)
+    {
+        for (size_t j = i + 1; j < size(); ++j)
+        {
+            L(i, j) = 0;
+        }
+    }
+    return L;
+}
+
+double dynamic_cholesky::det() const
+{
+    double product = 1;
+    for (size_t i = 0; i < size(); ++i)
+    {
+        product *= _l(i, i)*_l(i, i);
+    }
+    return product;
+}
+
+dynamic_matrix dynamic_cholesky::solve(const dynamic_matrix &B) const
+{
+    require_rows(B, size());
+    dynamic_matrix X = B;
+    if (X.data().empty()) return X;
+    const size_t N = size(), K = X.columns();
+    lower_solve(_l.data().data(), N, N, false, &X[0], K, K);
+    upper_solve(_l.data().data(), N, N, &X[0], K, K);
+    return X;
+}
+
+dynamic_matrix dynamic_cholesky::inverse() const
+{
+    return solve(identity(size()));
+}
+
+dynamic_qr::dynamic_qr(const dynamic_matrix &m)
+    : _qr(m), _tau(m.columns(), matrix_resource()), _t(m.columns(), block)
+{
+    const size_t M = m.rows(), N = m.columns();
+    if (M < N)
+    {
+        std::stringstream ss;
+        ss << "Cannot take QR factorization of matrix of dimensions "
+            << M << "x" << N << ", which has fewer rows than columns";
+        throw std::invalid_argument(ss.str());
+    }
+    if (N == 0) return;
+    double *a = &_qr[0];
+    std::pmr::vector<double> w(block, matrix_resource());
+    std::pmr::vector<double> Y(matrix_resource()), Yt(matrix_resource());
+    std::pmr::vector<double> G(block*block, matrix_resource());
+    std::pmr::vector<double> panel(matrix_resource());
+
+    for (size_t k0 = 0; k0 < N; k0 += block)
+    {
+        const size_t k1 = std::min(N, k0 + block), b = k1 - k0;
+
+        // Find the reflection which zeros each column of the panel below
+        // the diagonal, and apply it to the rest of the panel. As in
+        // lu_columns, the panel is factored in a compact copy.
+        const size_t rows = M - k0;
+        panel.resize(rows*b);
+        for (size_t r = 0; r < rows; ++r)
+        {
+            std::copy(a + (k0 + r)*N + k0, a + (k0 + r)*N + k1,
+                      panel.data() + r*b);
+        }
+        double *p = panel.data();
+        for (size_t j = 0; j < b; ++j)
+        {
+            double norm = 0;
+            for (size_t r = j + 1; r < rows; ++r)
+            {
+                norm += p[r*b + j]*p[r*b + j];
+            }
+            const double alpha = p[j*b + j];
+            double &tau = _tau[k0 + j];
+            if (norm == 0)
+            {
+                tau = 0;
+                continue;
+            }
+            const double beta = -std::copysign(
+                std::sqrt(alpha*alpha + norm), alpha);
+            tau = (beta - alpha)/beta;
+            const double scale = 1/(alpha - beta);
+            for (size_t r = j + 1; r < rows; ++r)
+            {
+                p[r*b + j] *= scale;
+            }
+            p[j*b + j] = beta;
+
+            const size_t width = b - j - 1;
+            std::copy(p + j*b + j + 1, p + (j + 1)*b, w.begin());
+            for (size_t r = j + 1; r < rows; ++r)
+            {
+                subtract_scaled(w.data(), p + r*b + j + 1, -p[r*b + j],
+                                width);
+            }
+            for (size_t c = 0; c < width; ++c)
+            {
+                w[c] *= tau;
+            }
+            subtract_scaled(p + j*b + j + 1, w.data(), 1, width);
+            for (size_t r = j + 1; r < rows; ++r)
+            {
+                subtract_scaled(p + r*b + j + 1, w.data(), p[r*b + j],
+                                width);
+            }
+        }
+        for (size_t r = 0; r < rows; ++r)
+        {
+            std::copy(p + r*b, p + (r + 1)*b, a + (k0 + r)*N + k0);
+        }
+
+        // T, column by column: T(0:i, i) = -tau_i*T(0:i, 0:i)*G(0:i, i),
+        // where G = Y^T*Y.
+        copy_reflections(p, b, rows, b, Y, Yt);
+        gemm(b, b, M - k0, 1, Yt.data(), M - k0, Y.data(), b, 0,
+             G.data(), b);
+        double *T = &_t(k0, 0);
+        for (size_t i = 0; i < b; ++i)
+        {
+            for (size_t p = 0; p < i; ++p)
+            {
+                double x = 0;
+                for (size_t q = p; q < i; ++q)
+                {
+                    x += T[p*block + q]*G[q*b + i];
+                }
+                T[p*block + i] = -_tau[k0 + i]*x;
+            }
+            T[i*block + i] = _tau[k0 + i];
+        }
+
+        if (k1 < N)
+        {
+            apply_reflections(Y, Yt, M - k0, b, T, block, true,
+                              a + k0*N + k1, N, N - k1);
+        }
+    }
+}
+
+size_t dynamic_qr::rows() const
+{
+    return _qr.rows();
+}
+
+size_t dynamic_qr::columns() const
+{
+    return _qr.columns();
+}
+
+dynamic_matrix dynamic_qr::q() const
+{
+    const size_t M = rows(), N = columns();
+    dynamic_matrix Q(M, N);
+    for (size_t i = 0; i < N; ++i)
+    {
+        Q(i, i) = 1;
+    }
+    if (N == 0) return Q;
+    const double *qr = _qr.data().data(), *t = _t.data().data();
+    std::pmr::vector<double> Y(matrix_resource()), Yt(matrix_resource());
+    for (size_t k0 = (N - 1)/block*block; ; k0 -= block)
+    {
+        const size_t b = std::min(N - k0, block);
+        copy_reflections(qr + k0*N + k0, N, M - k0, b, Y, Yt);
+        apply_reflections(Y, Yt, M - k0, b, t + k0*block, block, false,
+                          &Q(k0, 0), N, N);
+        if (k0 == 0) break;
+    }
+    return Q;
+}
+
+dynamic_matrix dynamic_qr::r() const
+{
+    const size_t N = columns();
+    dynamic_matrix R(N, N);
+    for (size_t i = 0; i < N; ++i)
+    {
+        for (size_t j = i; j < N; ++j)
+        {
+            R(i, j) = _qr(i, j);
+        }
+    }
+    return R;
+}
+
+double dynamic_qr::det() const
+{
+    require_square(_qr, "determinant");
+    double product = 1;
+    for (size_t i = 0; i < columns(); ++i)
+    {
+        // Each reflection other than the identity has determinant -1.
+        product *= _tau[i] == 0 ? _qr(i, i) : -_qr(i, i);
+    }
+    return product;
+}
+
+dynamic_matrix dynamic_qr::solve(const dynamic_matrix &B) const
+{
+    require_rows(B, rows());
+    const size_t M = rows(), N = columns(), K = B.columns();
+    for (size_t i = 0; i < N; ++i)
+    {
+        if (_qr(i, i) == 0)
+        {
+            throw std::domain_error("Cannot solve system with matrix "
+                                    "which does not have full rank");
+        }
+    }
+
+    dynamic_matrix C = B;
+    dynamic_matrix X(N, K);
+    if (X.data().empty()) return X;
+    const double *qr = _qr.data().data(), *t = _t.data().data();
+    std::pmr::vector<double> Y(matrix_resource()), Yt(matrix_resource());
+    for (size_t k0 = 0; k0 < N; k0 += block)
+    {
+        const size_t b = std::min(N - k0, block);
+        copy_reflections(qr + k0*N + k0, N, M - k0, b, Y, Yt);
+        apply_reflections(Y, Yt, M - k0, b, t + k0*block, block, true,
+                          &C(k0, 0), K, K);
+    }
+    std::copy(&C[0], &C[0] + N*K, &X[0]);
+    upper_solve(_qr.data().data(), N, N, &X[0], K, K);
+    return X;
+}
+
+dynamic_matrix dynamic_qr::inverse() const
+{
+    require_square(_qr, "inverse");
+    return solve(identity(rows()));
+}
+
+double det(const dynamic_matrix &m)
+{
+    return dynamic_lu(m).det();
+}
+
+dynamic_matrix inverse(const dynamic_matrix &m)
+{
+    return dynamic_lu(m).inverse();
+}
+
+dynamic_matrix solve(const dynamic_matrix &A, const dynamic_matrix &B)
+{
+    return dynamic_lu(A).solve(B);
+}
+
+} // namespace lambda
@@ -1,22 +1,67 @@
 
 #include "lambda/dynamic_matrix.hpp"
+#include "lambda/gemm.hpp"
+#include "lambda/parallel.hpp"
+
+#include <cmath>
 
 /// \brief The namespace used by all lambda classes and functions.
 namespace lambda
 {
 
+namespace
+{
+
+/// \brief The fewest elements an elementwise operation gives a thread;
+/// smaller operations are bound by the cost of starting threads.
+constexpr size_t elementwise_grain = 1 << 15;
+
+/// \brief The elements reduced together by each chunk of a reduction.
+constexpr size_t reduction_chunk = 1 << 12;
+
+/// \brief Throws an exception unless two matrices are the same size.
+void require_same_size(const dynamic_matrix &left,
+                       const dynamic_matrix &right, const char *operation)
+{
+    if (left.columns() != right.columns() ||
+        left.rows() != right.rows())
+    {
+        std::stringstream ss;
+        ss << "Cannot " << operation << " matrices of dimensions "
+            << left.rows() << "x" << left.columns() << " and "
+            << right.rows() << "x" << right.columns();
+        throw std::invalid_argument(ss.str());
+    }
+}
+
+} // namespace
+
 /// \brief Copy constructor.
-dynamic_matrix::dynamic_matrix(const dynamic_matrix &other)
-    : _data(other.data()), _rows(other.rows()), _columns(other.columns()) { }
+dynamic_matrix::dynamic_matrix(const dynamic_matrix &other,
+                               std::pmr::memory_resource *resource)
+    : _data(other.data(), resource), _rows(other.rows()),
+    _columns(other.columns()) { }
+
+/// \brief Move constructor.
+dynamic_matrix::dynamic_matrix(dynamic_matrix &&other) noexcept
+    : _data(std::move(other._data)), _rows(other._rows),
+    _columns(other._columns)
+{
+    other._data.clear();
+    other._rows = other._columns = 0;
+}
 
 /// \brief Construct with dimensions only.
-dynamic_matrix::dynamic_matrix(size_t rows, size_t columns)
-    : _data(rows*columns), _rows(rows), _columns(columns) { }
+dynamic_matrix::dynamic_matrix(size_t rows, size_t columns,
+                               std::pmr::memory_resource *resource)
+    : _data(rows*columns, resource), _rows(rows), _columns(columns) { }
 
 /// \brief Construct with dimensions and contents.
 dynamic_matrix::dynamic_matrix(size_t rows, size_t columns,
-               const std::vector<double> &data)
-    : _data(data), _rows(rows), _columns(columns)
+                               const std::vector<double> &data,
+                               std::pmr::memory_resource *resource)
+    : _data(data.begin(), data.end(), resource), _rows(rows),
+    _columns(columns)
 {
     _data.resize(_rows*_columns);
 }
@@ -30,6 +75,79 @@ dynamic_matrix& dynamic_matrix::operator = (const dynamic_matrix &m)
     return *this;
 }
 
+/// \brief Move assignment operator.
+dynamic_matrix& dynamic_matrix::operator = (dynamic_matrix &&m)
+{
+    if (this == &m) return *this;
+    _data = std::move(m._data);
+    _rows = m._rows;
+    _columns = m._columns;
+    m._data.clear();
+    m._rows = m._columns = 0;
+    return *this;
+}
+
+/// \brief Add a matrix to this one, in place.
+dynamic_matrix& dynamic_matrix::operator += (const dynamic_matrix &m)
+{
+    require_same_size(*this, m, "add");
+    double *x = _data.data();
+    const double *y = m._data.data();
+    detail::parallel_for(_data.size(), elementwise_grain,
+        [x, y] (size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            x[i] += y[i];
+        }
+    });
+    return *this;
+}
+
+/// \brief Subtract a matrix from this one, in place.
+dynamic_matrix& dynamic_matrix::operator -= (const dynamic_matrix &m)
+{
+    require_same_size(*this, m, "subtract");
+    double *x = _data.data();
+    const double *y = m._data.data();
+    detail::parallel_for(_data.size(), elementwise_grain,
+        [x, y] (size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            x[i] -= y[i];
+        }
+    });
+    return *this;
+}
+
+/// \brief Multiply this matrix by a scalar, in place.
+dynamic_matrix& dynamic_matrix::operator *= (double scalar)
+{
+    double *x = _data.data();
+    detail::parallel_for(_data.size(), elementwise_grain,
+        [x, scalar] (size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            x[i] *= scalar;
+        }
+    });
+    return *this;
+}
+
+/// \brief Divide this matrix by a scalar, in place.
+dynamic_matrix& dynamic_matrix::operator /= (double divisor)
+{
+    return *this *= 1.0/divisor;
+}
+
+/// \brief Multiply this matrix on the right by another.
+dynamic_matrix& dynamic_matrix::operator *= (const dynamic_matrix &m)
+{
+    return *this = *this * m;
+}
+
 /// \brief Get the number of rows in this matrix.
 size_t dynamic_matrix::rows() const
 {
@@ -101,11 +219,17 @@ double& dynamic_matrix::at(size_t i, size_t j)
 }
 
 /// \brief Get a const ref to the underlying data of this matrix.
-const std::vector<double>& dynamic_matrix::data() const
+const std::pmr::vector<double>& dynamic_matrix::data() const
 {
     return _data;
 }
 
+/// \brief Get the memory resource this matrix allocates from.
+std::pmr::memory_resource* dynamic_matrix::resource() const
+{
+    return _data.get_allocator().resource();
+}
+
 /// \brief Throws an exception if an index is out of bounds.
 void dynamic_matrix::range_check(size_t i) const
 {
@@ -146,101 +270,141 @@ bool operator == (const dynamic_matrix &left,
 }
 
 /// \brief X basis vector.
-const dynamic_matrix dunitx()
+const dynamic_matrix& dunitx()
 {
-    static dynamic_matrix ret(3, 1, {1, 0, 0});
+    static const dynamic_matrix ret(3, 1, {1, 0, 0},
+        std::pmr::new_delete_resource());
     return ret;
 }
 
 /// \brief Y basis vector.
-const dynamic_matrix dunity()
+const dynamic_matrix& dunity()
 {
-    static dynamic_matrix ret(3, 1, {0, 1, 0});
+    static const dynamic_matrix ret(3, 1, {0, 1, 0},
+        std::pmr::new_delete_resource());
     return ret;
 }
 
 /// \brief Z basis vector.
-const dynamic_matrix dunitz()
+const dynamic_matrix& dunitz()
 {
-    static dynamic_matrix ret(3, 1, {0, 0, 1});
+    static const dynamic_matrix ret(3, 1, {0, 0, 1},
+        std::pmr::new_delete_resource());
     return ret;
 }
 
+/// \brief Write the text of a matrix into a buffer.
+std::to_chars_result to_chars(char *first, char *last,
+                              const dynamic_matrix &m)
+{
+    return detail::format_matrix(first, last, m.rows(), m.columns(),
+        [&m] (size_t i, size_t j) { return m(i, j); });
+}
+
 /// \brief Print a matrix to a std::ostream.
 std::ostream& operator << (std::ostream &os, const dynamic_matrix &m)
 {
-    const size_t M = m.rows(), N = m.columns();
-    os.precision(3);
-    os.setf(std::ios::fixed);
-    os << "[";
-    for (size_t i = 0; i < M; ++i)
-    {
-        for (size_t j = 0; j < N; ++j)
-        {
-            os << +m(i, j);
-            if (j < N - 1) os << ", ";
-        }
-        if (i < M - 1) os << "; ";
-    }
-    return os << "]";
+    return detail::print_matrix(os, m.rows(), m.columns(),
+        [&m] (size_t i, size_t j) { return m(i, j); });
 }
 
 /// \brief Produces a multiline string representation of a matrix.
 std::string pretty(const dynamic_matrix &m)
 {
-    std::stringstream ss;
-    ss.precision(3);
-    ss.setf(std::ios::fixed);
-    const size_t M = m.rows(), N = m.columns();
-
-    size_t max_len = 0;
-    for (size_t i = 0; i < M*N; ++i)
-    {
-        std::stringstream tiny;
-        tiny.precision(3);
-        tiny.setf(std::ios::fixed);
-        tiny << m[i];
-        size_t len = tiny.tellp();
-        if (len > max_len) max_len = len;
-    }
+    return detail::pretty_matrix(m.rows(), m.columns(),
+        [&m] (size_t i, size_t j) { return m(i, j); });
+}
 
-    for (size_t r = 0; r < M; ++r)
+/// \brief Get the Frobenius norm of a matrix.
+double frobenius_norm(const dynamic_matrix &m)
+{
+    const double *x = m.data().data();
+    return std::sqrt(detail::parallel_reduce(m.data().size(),
+        reduction_chunk, elementwise_grain, 0.0, [x] (size_t begin, size_t end)
     {
-        ss << "  [";
-        for (size_t c = 0; c < N; ++c)
+        double sum = 0;
+        for (size_t i = begin; i < end; ++i)
         {
-            ss << std::setw(max_len + 1) << m(r, c);
+            sum += x[i]*x[i];
         }
-        ss << " ]\n";
-    }
-
-    return ss.str();
+        return sum;
+    }, [] (double a, double b) { return a + b; }));
 }
 
 /// \brief Addition of two matrices.
 dynamic_matrix operator + (const dynamic_matrix &left,
                            const dynamic_matrix &right)
 {
-    if (left.columns() != right.columns() ||
-        left.rows() != right.rows())
-    {
-        std::stringstream ss;
-        ss << "Cannot add matrices of dimensions "
-            << left.rows() << "x" << left.columns() << " and "
-            << right.rows() << "x" << right.columns();
-        throw std::invalid_argument(ss.str());
-    }
+    require_same_size(left, right, "add");
+    dynamic_matrix ret = left;
+    ret += right;
+    return ret;
+}
+
+/// \brief Addition of two matrices, reusing the storage of left.
+dynamic_matrix operator + (dynamic_matrix &&left,
+                           const dynamic_matrix &right)
+{
+    left += right;
+    return std::move(left);
+}
+
+/// \brief Addition of two matrices, reusing the storage of right.
+dynamic_matrix operator + (const dynamic_matrix &left,
+                           dynamic_matrix &&right)
+{
+    right += left;
+    return std::move(right);
+}
+
+/// \brief Addition of two matrices, reusing the storage of left.
+dynamic_matrix operator + (dynamic_matrix &&left, dynamic_matrix &&right)
+{
+    left += right;
+    return std::move(left);
+}
 
-    const size_t M = left.rows(), N = left.columns();
-    dynamic_matrix ret(M, N);
-    for (size_t i = 0; i < M; ++i)
+/// \brief Subtraction of two matrices.
+dynamic_matrix operator - (const dynamic_matrix &left,
+                           const dynamic_matrix &right)
+{
+    require_same_size(left, right, "subtract");
+    dynamic_matrix ret = left;
+    ret -= right;
+    return ret;
+}
+
+/// \brief Subtraction of two matrices, reusing the storage of left.
+dynamic_matrix operator - (dynamic_matrix &&left,
+                           const dynamic_matrix &right)
+{
+    left -= right;
+    return std::move(left);
+}
+
+/// \brief Subtraction of two matrices, reusing the storage of right.
+dynamic_matrix operator - (const dynamic_matrix &left,
+                           dynamic_matrix &&right)
+{
+    require_same_size(left, right, "subtract");
+    const double *x = left.data().data();
+    double *y = right.data().empty() ? nullptr : &right[0];
+    detail::parallel_for(right.data().size(), elementwise_grain,
+        [x, y] (size_t begin, size_t end)
     {
-        for (size_t j = 0; j < N; ++j)
+        for (size_t i = begin; i < end; ++i)
         {
-            ret(i, j) = left(i, j) + right(i, j);
+            y[i] = x[i] - y[i];
         }
-    }
-    return ret;
+    });
+    return std::move(right);
+}
+
+/// \brief Subtraction of two matrices, reusing the storage of left.
+dynamic_matrix operator - (dynamic_matrix &&left, dynamic_matrix &&right)
+{
+    left -= right;
+    return std::move(left);
 }
 
 /// \brief Multiplication of two matrices.
@@ -256,20 +420,8 @@ dynamic_matrix operator * (const dynamic_matrix &left,
         throw std::invalid_argument(ss.str());
     }
 
-    const size_t M = left.rows(), N = left.columns(), P = right.columns();
-    dynamic_matrix ret(M, P);
-    for (size_t i = 0; i < M; ++i)
-    {
-        for (size_t j = 0; j < P; ++j)
-        {
-            double sum = 0;
-            for (size_t k = 0; k < N; ++k)
-            {
-                sum += left(i, k) * right(k, j);
-            }
-            ret(i, j) = sum;
-        }
-    }
+    dynamic_matrix ret(left.rows(), right.columns());
+    gemm(1, left, right, 0, ret);
     return ret;
 }
 
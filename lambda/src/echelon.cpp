@@ -1,14 +0,0 @@
-// echelon.cpp
-
-#include "lambda/echelon.hpp"
-
-namespace lambda
-{
-
-matrix<1, 1> rref(const matrix<1, 1> &m)
-{
-    return m;
-}
-
-} // namespace lambda
-
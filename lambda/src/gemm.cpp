@@ -0,0 +1,355 @@
+// gemm.cpp
+
+#include "lambda/gemm.hpp"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "lambda/kernels.hpp"
+#include "lambda/parallel.hpp"
+
+namespace lambda
+{
+
+namespace
+{
+
+#if defined(__AVX2__)
+/// \brief The rows and columns of the tile of C held in registers by
+/// the micro-kernel: six rows of two 4-wide vectors uses twelve of the
+/// sixteen ymm registers, leaving room for two rows of B and a
+/// broadcast element of A.
+constexpr size_t MR = 6, NR = 8;
+#else
+/// \brief The rows and columns of the tile of C held in registers by
+/// the micro-kernel.
+constexpr size_t MR = 4, NR = 4;
+#endif
+
+/// \brief The depth of the packed panels; one MRxKC panel of A and one
+/// KCxNR panel of B fit in L1 together.
+constexpr size_t KC = 256;
+/// \brief The rows of the packed block of A, which stays in L2; a
+/// multiple of MR.
+constexpr size_t MC = 72;
+/// \brief The columns of the packed block of B, which stays in L3; a
+/// multiple of NR.
+constexpr size_t NC = 4080;
+
+/// \brief Products with fewer multiply-adds than this skip packing,
+/// whose cost they would not recover.
+constexpr size_t small_product = 24*24*24;
+
+/// \brief Products with fewer multiply-adds than this run on one
+/// thread, since starting threads would cost more than it saves. Larger
+/// products are split into bands of rows, or of columns if wider than
+/// tall, one band per thread.
+constexpr size_t parallel_product = 128*128*128;
+
+/// \brief Computes the MRxNR tile c += a*b, where a is a packed panel of
+/// MR rows of A, column by column, and b a packed panel of NR columns
+/// of B, row by row, both kc deep.
+void micro_kernel(size_t kc, const double *a, const double *b,
+                  double *c, size_t ldc)
+{
+#if defined(__AVX2__)
+    using kernels::detail::fmadd;
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+    __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+    for (size_t k = 0; k < kc; ++k, a += MR, b += NR)
+    {
+        const __m256d b0 = _mm256_loadu_pd(b);
+        const __m256d b1 = _mm256_loadu_pd(b + 4);
+        __m256d ai = _mm256_broadcast_sd(a);
+        c00 = fmadd(ai, b0, c00);
+        c01 = fmadd(ai, b1, c01);
+        ai = _mm256_broadcast_sd(a + 1);
+        c10 = fmadd(ai, b0, c10);
+        c11 = fmadd(ai, b1, c11);
+        ai = _mm256_broadcast_sd(a + 2);
+        c20 = fmadd(ai, b0, c20);
+        c21 = fmadd(ai, b1, c21);
+        ai = _mm256_broadcast_sd(a + 3);
+        c30 = fmadd(ai, b0, c30);
+        c31 = fmadd(ai, b1, c31);
+        ai = _mm256_broadcast_sd(a + 4);
+        c40 = fmadd(ai, b0, c40);
+        c41 = fmadd(ai, b1, c41);
+        ai = _mm256_broadcast_sd(a + 5);
+        c50 = fmadd(ai, b0, c50);
+        c51 = fmadd(ai, b1, c51);
+    }
+    const __m256d rows[MR][2] = { { c00, c01 }, { c10, c11 }, { c20, c21 },
+                                  { c30, c31 }, { c40, c41 }, { c50, c51 } };
+    for (size_t i = 0; i < MR; ++i, c += ldc)
+    {
+        _mm256_storeu_pd(c, _mm256_add_pd(_mm256_loadu_pd(c), rows[i][0]));
+        _mm256_storeu_pd(c + 4,
+            _mm256_add_pd(_mm256_loadu_pd(c + 4), rows[i][1]));
+    }
+#elif defined(__SSE2__)
+    using kernels::detail::fmadd;
+    __m128d c00 = _mm_setzero_pd(), c01 = _mm_setzero_pd();
+    __m128d c10 = _mm_setzero_pd(), c11 = _mm_setzero_pd();
+    __m128d c20 = _mm_setzero_pd(), c21 = _mm_setzero_pd();
+    __m128d c30 = _mm_setzero_pd(), c31 = _mm_setzero_pd();
+    for (size_t k = 0; k < kc; ++k, a += MR, b += NR)
+    {
+        const __m128d b0 = _mm_loadu_pd(b);
+        const __m128d b1 = _mm_loadu_pd(b + 2);
+        __m128d ai = _mm_set1_pd(a[0]);
+        c00 = fmadd(ai, b0, c00);
+        c01 = fmadd(ai, b1, c01);
+        ai = _mm_set1_pd(a[1]);
+        c10 = fmadd(ai, b0, c10);
+        c11 = fmadd(ai, b1, c11);
+        ai = _mm_set1_pd(a[2]);
+        c20 = fmadd(ai, b0, c20);
+        c21 = fmadd(ai, b1, c21);
+        ai = _mm_set1_pd(a[3]);
+        c30 = fmadd(ai, b0, c30);
+        c31 = fmadd(ai, b1, c31);
+    }
+    const __m128d rows[MR][2] = { { c00, c01 }, { c10, c11 },
+                                  { c20, c21 }, { c30, c31 } };
+    for (size_t i = 0; i < MR; ++i, c += ldc)
+    {
+        _mm_storeu_pd(c, _mm_add_pd(_mm_loadu_pd(c), rows[i][0]));
+        _mm_storeu_pd(c + 2, _mm_add_pd(_mm_loadu_pd(c + 2), rows[i][1]));
+    }
+#else
+    double ab[MR][NR] = { };
+    for (size_t k = 0; k < kc; ++k, a += MR, b += NR)
+    {
+        for (size_t i = 0; i < MR; ++i)
+        {
+            for (size_t j = 0; j < NR; ++j)
+            {
+                ab[i][j] += a[i]*b[j];
+            }
+        }
+    }
+    for (size_t i = 0; i < MR; ++i, c += ldc)
+    {
+        for (size_t j = 0; j < NR; ++j)
+        {
+            c[j] += ab[i][j];
+        }
+    }
+#endif
+}
+
+/// \brief Copies the mcxkc block of A at a, scaled by alpha, into
+/// panels of MR rows, each stored column by column. The rows of the
+/// last panel past mc are zero.
+void pack_a(size_t mc, size_t kc, double alpha, const double *a,
+            size_t lda, double *packed)
+{
+    for (size_t i = 0; i < mc; i += MR, packed += MR*kc)
+    {
+        const size_t rows = std::min(MR, mc - i);
+        for (size_t r = 0; r < MR; ++r)
+        {
+            const double *row = a + (i + r)*lda;
+            for (size_t k = 0; k < kc; ++k)
+            {
+                packed[k*MR + r] = r < rows ? alpha*row[k] : 0;
+            }
+        }
+    }
+}
+
+/// \brief Copies the kcxnc block of B at b into panels of NR columns,
+/// each stored row by row. The columns of the last panel past nc are
+/// zero.
+void pack_b(size_t kc, size_t nc, const double *b, size_t ldb,
+            double *packed)
+{
+    for (size_t j = 0; j < nc; j += NR, packed += NR*kc)
+    {
+        const size_t cols = std::min(NR, nc - j);
+        for (size_t k = 0; k < kc; ++k)
+        {
+            const double *row = b + k*ldb + j;
+            for (size_t c = 0; c < NR; ++c)
+            {
+                packed[k*NR + c] = c < cols ? row[c] : 0;
+            }
+        }
+    }
+}
+
+/// \brief Accumulates the product of a packed mcxkc block of A and a
+/// packed kcxnc block of B into C. Tiles on the bottom and right edges
+/// are computed into a scratch tile, and only their valid part added to
+/// C.
+void macro_kernel(size_t mc, size_t nc, size_t kc, const double *a,
+                  const double *b, double *c, size_t ldc)
+{
+    for (size_t j = 0; j < nc; j += NR)
+    {
+        const size_t cols = std::min(NR, nc - j);
+        for (size_t i = 0; i < mc; i += MR)
+        {
+            const size_t rows = std::min(MR, mc - i);
+            double *tile = c + i*ldc + j;
+            if (rows == MR && cols == NR)
+            {
+                micro_kernel(kc, a + i*kc, b + j*kc, tile, ldc);
+                continue;
+            }
+            double edge[MR*NR] = { };
+            micro_kernel(kc, a + i*kc, b + j*kc, edge, NR);
+            for (size_t r = 0; r < rows; ++r)
+            {
+                for (size_t s = 0; s < cols; ++s)
+                {
+                    tile[r*ldc + s] += edge[r*NR + s];
+                }
+            }
+        }
+    }
+}
+
+/// \brief Computes C += alpha*A*B row by row, accumulating each row of
+/// C from contiguous rows of B, for products too small to pack.
+void small_gemm(size_t M, size_t N, size_t K, double alpha,
+                const double *A, size_t lda, const double *B, size_t ldb,
+                double *C, size_t ldc)
+{
+    for (size_t i = 0; i < M; ++i)
+    {
+        double *c = C + i*ldc;
+        for (size_t k = 0; k < K; ++k)
+        {
+            const double aik = alpha*A[i*lda + k];
+            const double *b = B + k*ldb;
+            for (size_t j = 0; j < N; ++j)
+            {
+                c[j] += aik*b[j];
+            }
+        }
+    }
+}
+
+/// \brief Computes C = alpha*A*B + beta*C on the calling thread, by
+/// packing or, if not pack, by small_gemm.
+void serial_gemm(size_t M, size_t N, size_t K, double alpha,
+                 const double *A, size_t lda, const double *B, size_t ldb,
+                 double beta, double *C, size_t ldc, bool pack)
+{
+    for (size_t i = 0; i < M; ++i)
+    {
+        double *c = C + i*ldc;
+        if (beta == 0) std::fill(c, c + N, 0.0);
+        else if (beta != 1) for (size_t j = 0; j < N; ++j) c[j] *= beta;
+    }
+    if (M == 0 || N == 0 || K == 0 || alpha == 0) return;
+
+    if (!pack)
+    {
+        small_gemm(M, N, K, alpha, A, lda, B, ldb, C, ldc);
+        return;
+    }
+
+    // The packing buffers are kept per thread, so that repeated
+    // products do not allocate.
+    thread_local std::vector<double> packed_a, packed_b;
+    const size_t mc_max = std::min(MC, (M + MR - 1)/MR*MR);
+    const size_t nc_max = std::min(NC, (N + NR - 1)/NR*NR);
+    const size_t kc_max = std::min(KC, K);
+    if (packed_a.size() < mc_max*kc_max) packed_a.resize(mc_max*kc_max);
+    if (packed_b.size() < kc_max*nc_max) packed_b.resize(kc_max*nc_max);
+
+    for (size_t jc = 0; jc < N; jc += NC)
+    {
+        const size_t nc = std::min(NC, N - jc);
+        for (size_t pc = 0; pc < K; pc += KC)
+        {
+            const size_t kc = std::min(KC, K - pc);
+            pack_b(kc, nc, B + pc*ldb + jc, ldb, packed_b.data());
+            for (size_t ic = 0; ic < M; ic += MC)
+            {
+                const size_t mc = std::min(MC, M - ic);
+                pack_a(mc, kc, alpha, A + ic*lda + pc, lda, packed_a.data());
+                macro_kernel(mc, nc, kc, packed_a.data(), packed_b.data(),
+                             C + ic*ldc + jc, ldc);
+            }
+        }
+    }
+}
+
+} // namespace
+
+void gemm(size_t M, size_t N, size_t K, double alpha,
+          const double *A, size_t lda, const double *B, size_t ldb,
+          double beta, double *C, size_t ldc)
+{
+    // Every element of C is accumulated in the same order whichever
+    // band of C it falls in, so the product does not depend on the
+    // thread count; the choice of kernel is made for the whole product
+    // for the same reason.
+    const size_t products = M*N*K;
+    const bool pack = products >= small_product;
+    if (products < parallel_product)
+    {
+        serial_gemm(M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, pack);
+    }
+    else if (M >= N)
+    {
+        detail::parallel_for(M, MR, [=] (size_t begin, size_t end)
+        {
+            serial_gemm(end - begin, N, K, alpha, A + begin*lda, lda,
+                        B, ldb, beta, C + begin*ldc, ldc, pack);
+        });
+    }
+    else
+    {
+        detail::parallel_for(N, NR, [=] (size_t begin, size_t end)
+        {
+            serial_gemm(M, end - begin, K, alpha, A, lda, B + begin, ldb,
+                        beta, C + begin, ldc, pack);
+        });
+    }
+}
+
+void gemm(double alpha, const dynamic_matrix &A, const dynamic_matrix &B,
+          double beta, dynamic_matrix &C)
+{
+    if (A.columns() != B.rows())
+    {
+        std::stringstream ss;
+        ss << "Cannot multiply matrices of dimensions "
+            << A.rows() << "x" << A.columns() << " and "
+            << B.rows() << "x" << B.columns();
+        throw std::invalid_argument(ss.str());
+    }
+    if (C.rows() != A.rows() || C.columns() != B.columns())
+    {
+        std::stringstream ss;
+        ss << "Cannot accumulate product of dimensions "
+            << A.rows() << "x" << B.columns() << " into matrix of dimensions "
+            << C.rows() << "x" << C.columns();
+        throw std::invalid_argument(ss.str());
+    }
+    if (C.data().empty()) return;
+    if (&C == &A || &C == &B)
+    {
+        dynamic_matrix product = C;
+        gemm(alpha, A, B, beta, product);
+        C = std::move(product);
+        return;
+    }
+    gemm(A.rows(), B.columns(), A.columns(), alpha,
+         A.data().data(), A.columns(), B.data().data(), B.columns(),
+         beta, &C[0], C.columns());
+}
+
+} // namespace lambda
@@ -0,0 +1,391 @@
+// mapped_matrix.cpp
+
+#include "lambda/mapped_matrix.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lambda/gemm.hpp"
+#include "lambda/serialization.hpp"
+
+namespace lambda
+{
+
+namespace
+{
+
+/// \brief The rows and columns of each tile copied by transpose; one
+/// tile of doubles is 32 KiB.
+constexpr size_t transpose_tile = 64;
+
+/// \brief Throws std::runtime_error describing errno.
+[[noreturn]] void system_error(const std::string &what,
+                               const std::string &path)
+{
+    std::stringstream ss;
+    ss << "Cannot " << what << " matrix file " << path << ": "
+        << std::strerror(errno);
+    throw std::runtime_error(ss.str());
+}
+
+/// \brief Closes a file descriptor when it goes out of scope; a mapping
+/// does not need its file to stay open.
+struct file_descriptor
+{
+    int fd;
+
+    ~file_descriptor()
+    {
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+/// \brief Throws an exception unless m may be written to.
+void require_writable(const mapped_matrix &m)
+{
+    if (m.mode() == map_mode::read_only)
+    {
+        throw std::invalid_argument("Cannot write to read-only mapped matrix");
+    }
+}
+
+} // namespace
+
+mapped_matrix::mapped_matrix(const std::string &path, map_mode mode)
+    : _map(nullptr), _map_size(0), _rows(0), _columns(0), _mode(mode),
+    _device(0), _inode(0)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    throw std::runtime_error(
+        "Cannot map little-endian matrix file on big-endian machine");
+#endif
+    const bool write = mode == map_mode::read_write;
+    const file_descriptor file{ ::open(path.c_str(),
+                                       write ? O_RDWR : O_RDONLY) };
+    if (file.fd < 0) system_error("open", path);
+
+    struct stat status;
+    if (::fstat(file.fd, &status) != 0) system_error("stat", path);
+    const size_t size = status.st_size;
+    if (size < detail::encoding_header_size)
+    {
+        throw std::runtime_error("Matrix file " + path +
+                                 " is shorter than its header");
+    }
+
+    const int protection = mode == map_mode::read_only ?
+        PROT_READ : PROT_READ | PROT_WRITE;
+    const int flags = mode == map_mode::copy_on_write ?
+        MAP_PRIVATE : MAP_SHARED;
+    void *map = ::mmap(nullptr, size, protection, flags, file.fd, 0);
+    if (map == MAP_FAILED) system_error("map", path);
+
+    try
+    {
+        const encoding_header header =
+            detail::decode_header(static_cast<const char*>(map));
+        const uint64_t elements = (size - detail::encoding_header_size)/
+            sizeof(double);
+        if (header.columns != 0 && header.rows > elements/header.columns)
+        {
+            std::stringstream ss;
+            ss << "Matrix file " << path << " is too short to hold a "
+                << header.rows << "x" << header.columns << " matrix";
+            throw std::runtime_error(ss.str());
+        }
+        _rows = header.rows;
+        _columns = header.columns;
+    }
+    catch (...)
+    {
+        ::munmap(map, size);
+        throw;
+    }
+    _map = map;
+    _map_size = size;
+    _device = status.st_dev;
+    _inode = status.st_ino;
+}
+
+mapped_matrix::mapped_matrix(void *map, size_t map_size, size_t rows,
+                             size_t columns, map_mode mode,
+                             uint64_t device, uint64_t inode)
+    : _map(map), _map_size(map_size), _rows(rows), _columns(columns),
+    _mode(mode), _device(device), _inode(inode) { }
+
+mapped_matrix mapped_matrix::create(const std::string &path,
+                                    size_t rows, size_t columns)
+{
+    const file_descriptor file{ ::open(path.c_str(),
+                                       O_RDWR | O_CREAT | O_TRUNC, 0644) };
+    if (file.fd < 0) system_error("create", path);
+
+    const size_t size = detail::encoding_header_size +
+        rows*columns*sizeof(double);
+    if (::ftruncate(file.fd, size) != 0) system_error("resize", path);
+    struct stat status;
+    if (::fstat(file.fd, &status) != 0) system_error("stat", path);
+    void *map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       file.fd, 0);
+    if (map == MAP_FAILED) system_error("map", path);
+    detail::encode_header(static_cast<char*>(map), { rows, columns });
+    return mapped_matrix(map, size, rows, columns, map_mode::read_write,
+                         status.st_dev, status.st_ino);
+}
+
+mapped_matrix::mapped_matrix(mapped_matrix &&other) noexcept
+    : _map(other._map), _map_size(other._map_size), _rows(other._rows),
+    _columns(other._columns), _mode(other._mode), _device(other._device),
+    _inode(other._inode)
+{
+    other._map = nullptr;
+    other._map_size = other._rows = other._columns = 0;
+}
+
+mapped_matrix& mapped_matrix::operator = (mapped_matrix &&other) noexcept
+{
+    if (this == &other) return *this;
+    if (_map) ::munmap(_map, _map_size);
+    _map = other._map;
+    _map_size = other._map_size;
+    _rows = other._rows;
+    _columns = other._columns;
+    _mode = other._mode;
+    _device = other._device;
+    _inode = other._inode;
+    other._map = nullptr;
+    other._map_size = other._rows = other._columns = 0;
+    return *this;
+}
+
+mapped_matrix::~mapped_matrix()
+{
+    if (_map) ::munmap(_map, _map_size);
+}
+
+size_t mapped_matrix::rows() const
+{
+    return _rows;
+}
+
+size_t mapped_matrix::columns() const
+{
+    return _columns;
+}
+
+map_mode mapped_matrix::mode() const
+{
+    return _mode;
+}
+
+double mapped_matrix::operator () (size_t i, size_t j) const
+{
+    return data()[_columns*i + j];
+}
+
+double& mapped_matrix::operator () (size_t i, size_t j)
+{
+    return data()[_columns*i + j];
+}
+
+double mapped_matrix::operator [] (size_t i) const
+{
+    return data()[i];
+}
+
+double& mapped_matrix::operator [] (size_t i)
+{
+    return data()[i];
+}
+
+double mapped_matrix::at(size_t i) const
+{
+    range_check(i);
+    return (*this)[i];
+}
+
+double& mapped_matrix::at(size_t i)
+{
+    range_check(i);
+    write_check();
+    return (*this)[i];
+}
+
+double mapped_matrix::at(size_t i, size_t j) const
+{
+    range_check(i, j);
+    return (*this)(i, j);
+}
+
+double& mapped_matrix::at(size_t i, size_t j)
+{
+    range_check(i, j);
+    write_check();
+    return (*this)(i, j);
+}
+
+const double* mapped_matrix::data() const
+{
+    return reinterpret_cast<const double*>(
+        static_cast<const char*>(_map) + detail::encoding_header_size);
+}
+
+double* mapped_matrix::data()
+{
+    return reinterpret_cast<double*>(
+        static_cast<char*>(_map) + detail::encoding_header_size);
+}
+
+dynamic_matrix mapped_matrix::block(size_t row, size_t column,
+                                    size_t rows, size_t columns,
+                                    std::pmr::memory_resource *resource)
+    const
+{
+    if (row + rows > _rows || column + columns > _columns)
+    {
+        std::stringstream ss;
+        ss << "Cannot copy " << rows << "x" << columns << " block at ("
+            << row << ", " << column << ") of " << _rows << "x"
+            << _columns << " matrix";
+        throw std::out_of_range(ss.str());
+    }
+    dynamic_matrix ret(rows, columns, resource);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        const double *source = data() + (row + i)*_columns + column;
+        std::copy(source, source + columns, &ret(i, 0));
+    }
+    return ret;
+}
+
+void mapped_matrix::flush()
+{
+    if (_map && _mode == map_mode::read_write &&
+        ::msync(_map, _map_size, MS_SYNC) != 0)
+    {
+        std::stringstream ss;
+        ss << "Cannot flush mapped matrix: " << std::strerror(errno);
+        throw std::runtime_error(ss.str());
+    }
+}
+
+bool mapped_matrix::shares_file(const mapped_matrix &other) const
+{
+    return _map && other._map &&
+        _device == other._device && _inode == other._inode;
+}
+
+void mapped_matrix::range_check(size_t i) const
+{
+    if (i >= _rows*_columns)
+    {
+        std::stringstream ss;
+        ss << "Cannot access element (" << i
+            << ") of " << _rows << "x" << _columns << " matrix";
+        throw std::out_of_range(ss.str());
+    }
+}
+
+void mapped_matrix::range_check(size_t i, size_t j) const
+{
+    if (i >= _rows || j >= _columns)
+    {
+        std::stringstream ss;
+        ss << "Cannot access element (" << i << ", " << j
+            << ") of " << _rows << "x" << _columns << " matrix";
+        throw std::out_of_range(ss.str());
+    }
+}
+
+void mapped_matrix::write_check() const
+{
+    require_writable(*this);
+}
+
+void multiply(const mapped_matrix &A, const mapped_matrix &B,
+              mapped_matrix &C)
+{
+    if (A.columns() != B.rows() ||
+        C.rows() != A.rows() || C.columns() != B.columns())
+    {
+        std::stringstream ss;
+        ss << "Cannot multiply matrices of dimensions "
+            << A.rows() << "x" << A.columns() << " and "
+            << B.rows() << "x" << B.columns() << " into matrix of dimensions "
+            << C.rows() << "x" << C.columns();
+        throw std::invalid_argument(ss.str());
+    }
+    if (C.shares_file(A) || C.shares_file(B))
+    {
+        throw std::invalid_argument("Cannot multiply mapped matrices "
+            "into the file of one of the operands");
+    }
+    require_writable(C);
+    gemm(A.rows(), B.columns(), A.columns(), 1, A.data(), A.columns(),
+         B.data(), B.columns(), 0, C.data(), C.columns());
+}
+
+dynamic_matrix operator * (const mapped_matrix &left,
+                           const mapped_matrix &right)
+{
+    if (left.columns() != right.rows())
+    {
+        std::stringstream ss;
+        ss << "Cannot multiply matrices of dimensions "
+            << left.rows() << "x" << left.columns() << " and "
+            << right.rows() << "x" << right.columns();
+        throw std::invalid_argument(ss.str());
+    }
+    dynamic_matrix ret(left.rows(), right.columns());
+    if (ret.data().empty()) return ret;
+    gemm(left.rows(), right.columns(), left.columns(), 1,
+         left.data(), left.columns(), right.data(), right.columns(),
+         0, &ret[0], ret.columns());
+    return ret;
+}
+
+void transpose(const mapped_matrix &A, mapped_matrix &T)
+{
+    if (T.rows() != A.columns() || T.columns() != A.rows())
+    {
+        std::stringstream ss;
+        ss << "Cannot write transpose of " << A.rows() << "x" << A.columns()
+            << " matrix to matrix of dimensions "
+            << T.rows() << "x" << T.columns();
+        throw std::invalid_argument(ss.str());
+    }
+    if (T.shares_file(A))
+    {
+        throw std::invalid_argument("Cannot transpose mapped matrix "
+            "into its own file");
+    }
+    require_writable(T);
+    const size_t M = A.rows(), N = A.columns();
+    const double *a = A.data();
+    double *t = T.data();
+    for (size_t i0 = 0; i0 < M; i0 += transpose_tile)
+    {
+        const size_t i1 = std::min(M, i0 + transpose_tile);
+        for (size_t j0 = 0; j0 < N; j0 += transpose_tile)
+        {
+            const size_t j1 = std::min(N, j0 + transpose_tile);
+            for (size_t i = i0; i < i1; ++i)
+            {
+                for (size_t j = j0; j < j1; ++j)
+                {
+                    t[j*M + i] = a[i*N + j];
+                }
+            }
+        }
+    }
+}
+
+} // namespace lambda
@@ -0,0 +1,113 @@
+// memory.cpp
+
+#include "lambda/memory.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace lambda
+{
+
+namespace
+{
+
+/// \brief The resource set by the innermost active scoped_resource of
+/// this thread, or null for the default resource.
+thread_local std::pmr::memory_resource *current_resource = nullptr;
+
+/// \brief The alignment of each block of an arena.
+constexpr size_t block_alignment = alignof(std::max_align_t);
+
+} // namespace
+
+std::pmr::memory_resource* matrix_resource()
+{
+    return current_resource ? current_resource
+                            : std::pmr::get_default_resource();
+}
+
+scoped_resource::scoped_resource(std::pmr::memory_resource *resource)
+    : _previous(current_resource)
+{
+    current_resource = resource;
+}
+
+scoped_resource::~scoped_resource()
+{
+    current_resource = _previous;
+}
+
+arena::arena(size_t initial_size, std::pmr::memory_resource *upstream)
+    : _upstream(upstream), _current(0), _offset(0), _used(0),
+    _next_size(std::max<size_t>(initial_size, block_alignment)) { }
+
+arena::~arena()
+{
+    for (const block &b : _blocks)
+    {
+        _upstream->deallocate(b.data, b.size, block_alignment);
+    }
+}
+
+void arena::release()
+{
+    _current = 0;
+    _offset = 0;
+    _used = 0;
+}
+
+size_t arena::used() const
+{
+    return _used;
+}
+
+size_t arena::capacity() const
+{
+    size_t total = 0;
+    for (const block &b : _blocks)
+    {
+        total += b.size;
+    }
+    return total;
+}
+
+void* arena::do_allocate(size_t bytes, size_t alignment)
+{
+    // Find room in the current block, or the first later block which
+    // fits, before allocating a new one.
+    for (; _current < _blocks.size(); ++_current, _offset = 0)
+    {
+        const block &b = _blocks[_current];
+        const uintptr_t start = reinterpret_cast<uintptr_t>(b.data) + _offset;
+        const size_t padding = (alignment - start % alignment) % alignment;
+        if (_offset + padding + bytes <= b.size)
+        {
+            _offset += padding + bytes;
+            _used += padding + bytes;
+            return b.data + _offset - bytes;
+        }
+        _used += b.size - _offset;
+    }
+
+    const size_t size = std::max(_next_size, bytes + alignment);
+    char *data = static_cast<char*>(
+        _upstream->allocate(size, block_alignment));
+    _blocks.push_back({ data, size });
+    _next_size = 2*size;
+    _current = _blocks.size() - 1;
+    const uintptr_t start = reinterpret_cast<uintptr_t>(data);
+    const size_t padding = (alignment - start % alignment) % alignment;
+    _offset = padding + bytes;
+    _used += _offset;
+    return data + padding;
+}
+
+void arena::do_deallocate(void*, size_t, size_t) { }
+
+bool arena::do_is_equal(const std::pmr::memory_resource &other)
+    const noexcept
+{
+    return this == &other;
+}
+
+} // namespace lambda
@@ -0,0 +1,31 @@
+// parallel.cpp
+
+#include "lambda/parallel.hpp"
+
+#include <atomic>
+
+namespace lambda
+{
+
+namespace
+{
+
+/// \brief The thread count set by set_thread_count, or zero for the
+/// default.
+std::atomic<size_t> configured_threads(0);
+
+} // namespace
+
+size_t thread_count()
+{
+    const size_t threads = configured_threads.load();
+    if (threads > 0) return threads;
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+void set_thread_count(size_t threads)
+{
+    configured_threads.store(threads);
+}
+
+} // namespace lambda
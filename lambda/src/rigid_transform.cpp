@@ -0,0 +1,230 @@
+// rigid_transform.cpp
+
+#include "lambda/rigid_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "lambda/kernels.hpp"
+
+namespace lambda
+{
+
+namespace
+{
+
+/// \brief Normalizes a quaternion, so that it is a rotation.
+quaternion unit(const quaternion &q)
+{
+    const double norm = std::sqrt(q[0]*q[0] + q[1]*q[1] +
+                                  q[2]*q[2] + q[3]*q[3]);
+    if (norm == 0)
+    {
+        std::stringstream ss;
+        ss << "Cannot construct rotation from quaternion " << q;
+        throw std::domain_error(ss.str());
+    }
+    return quaternion(q[0]/norm, q[1]/norm, q[2]/norm, q[3]/norm);
+}
+
+/// \brief Transforms count points, stored as x, y, z triples, by the
+/// row-major rotation r and the translation t. Each output point is
+/// the sum of the columns of r scaled by the coordinates of the input
+/// point; every input point is read before its output is written, so
+/// in may be out.
+void transform_points(const double *r, const double *t,
+                      const double *in, double *out, size_t count)
+{
+#if defined(__AVX2__)
+    using kernels::detail::fmadd;
+    const __m256d c0 = _mm256_setr_pd(r[0], r[3], r[6], 0);
+    const __m256d c1 = _mm256_setr_pd(r[1], r[4], r[7], 0);
+    const __m256d c2 = _mm256_setr_pd(r[2], r[5], r[8], 0);
+    const __m256d tv = _mm256_setr_pd(t[0], t[1], t[2], 0);
+    const __m256i xyz = _mm256_setr_epi64x(-1, -1, -1, 0);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const double *p = in + 3*i;
+        __m256d v = fmadd(c0, _mm256_broadcast_sd(p), tv);
+        v = fmadd(c1, _mm256_broadcast_sd(p + 1), v);
+        v = fmadd(c2, _mm256_broadcast_sd(p + 2), v);
+        _mm256_maskstore_pd(out + 3*i, xyz, v);
+    }
+#elif defined(__SSE2__)
+    using kernels::detail::fmadd;
+    const __m128d c0 = _mm_setr_pd(r[0], r[3]);
+    const __m128d c1 = _mm_setr_pd(r[1], r[4]);
+    const __m128d c2 = _mm_setr_pd(r[2], r[5]);
+    const __m128d tv = _mm_setr_pd(t[0], t[1]);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const double x = in[3*i], y = in[3*i + 1], z = in[3*i + 2];
+        __m128d v = fmadd(c0, _mm_set1_pd(x), tv);
+        v = fmadd(c1, _mm_set1_pd(y), v);
+        v = fmadd(c2, _mm_set1_pd(z), v);
+        _mm_storeu_pd(out + 3*i, v);
+        out[3*i + 2] = r[6]*x + r[7]*y + r[8]*z + t[2];
+    }
+#else
+    for (size_t i = 0; i < count; ++i)
+    {
+        const double x = in[3*i], y = in[3*i + 1], z = in[3*i + 2];
+        out[3*i]     = r[0]*x + r[1]*y + r[2]*z + t[0];
+        out[3*i + 1] = r[3]*x + r[4]*y + r[5]*z + t[1];
+        out[3*i + 2] = r[6]*x + r[7]*y + r[8]*z + t[2];
+    }
+#endif
+}
+
+/// \brief Computes one coordinate of a batch of transformed points,
+/// c = r[0]*x + r[1]*y + r[2]*z + t, from the planes of the inputs.
+void transform_plane(const double *r, double t, const double *x,
+                     const double *y, const double *z,
+                     double *__restrict c, size_t n)
+{
+    constexpr size_t lanes = detail::batch_lanes<double>;
+    for (size_t line = 0; line < n; line += lanes)
+    {
+#pragma GCC unroll 16
+        for (size_t k = line; k < line + lanes; ++k)
+        {
+            c[k] = r[0]*x[k] + r[1]*y[k] + r[2]*z[k] + t;
+        }
+    }
+}
+
+} // namespace
+
+rigid_transform::rigid_transform()
+    : _rotation(identity<3, 3>()), _translation() { }
+
+rigid_transform::rigid_transform(const quaternion &q,
+                                 const column_vector<3> &t)
+    : _rotation(unit(q)), _translation(t) { }
+
+rigid_transform::rigid_transform(const axis_angle &aa,
+                                 const column_vector<3> &t)
+    : _rotation(unit(quaternion(aa))), _translation(t) { }
+
+rigid_transform::rigid_transform(const matrix<3, 3> &rotation,
+                                 const column_vector<3> &t)
+    : _rotation(rotation), _translation(t) { }
+
+const matrix<3, 3>& rigid_transform::rotation() const
+{
+    return _rotation;
+}
+
+const column_vector<3>& rigid_transform::translation() const
+{
+    return _translation;
+}
+
+matrix<4, 4> rigid_transform::homogeneous() const
+{
+    const matrix<3, 3> &r = _rotation;
+    const column_vector<3> &t = _translation;
+    return matrix<4, 4>(r(0, 0), r(0, 1), r(0, 2), t[0],
+                        r(1, 0), r(1, 1), r(1, 2), t[1],
+                        r(2, 0), r(2, 1), r(2, 2), t[2],
+                              0,       0,       0,    1);
+}
+
+void rigid_transform::apply(const double *in, double *out, size_t count,
+                            size_t threads) const
+{
+    const double *r = _rotation.data().data();
+    const double *t = _translation.data().data();
+    threads = std::max<size_t>(1, std::min(threads, count));
+    if (threads == 1)
+    {
+        transform_points(r, t, in, out, count);
+        return;
+    }
+
+    const size_t chunk = (count + threads - 1)/threads;
+    std::vector<std::thread> workers;
+    for (size_t begin = chunk; begin < count; begin += chunk)
+    {
+        const size_t n = std::min(chunk, count - begin);
+        workers.emplace_back(transform_points, r, t,
+                             in + 3*begin, out + 3*begin, n);
+    }
+    transform_points(r, t, in, out, std::min(chunk, count));
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+std::vector<column_vector<3>> rigid_transform::apply(
+    const std::vector<column_vector<3>> &points, size_t threads) const
+{
+    static_assert(sizeof(column_vector<3>) == 3*sizeof(double),
+        "Points must be stored contiguously");
+    std::vector<column_vector<3>> ret(points.size());
+    if (!points.empty())
+    {
+        apply(points[0].data().data(), &ret[0][0], points.size(), threads);
+    }
+    return ret;
+}
+
+void rigid_transform::apply(const vector_batch<3> &points,
+                            vector_batch<3> &out) const
+{
+    if (&out == &points)
+    {
+        throw std::invalid_argument(
+            "Cannot transform batch of points in place");
+    }
+    if (out.size() != points.size())
+    {
+        out = vector_batch<3>(points.size(), detail::uninitialized_t());
+    }
+    for (size_t i = 0; i < 3; ++i)
+    {
+        transform_plane(_rotation.data().data() + 3*i, _translation[i],
+            points.plane(0), points.plane(1), points.plane(2),
+            out.plane(i), out.stride());
+    }
+}
+
+rigid_transform operator * (const rigid_transform &left,
+                            const rigid_transform &right)
+{
+    return rigid_transform(
+        matrix<3, 3>(left.rotation() * right.rotation()),
+        left * right.translation());
+}
+
+column_vector<3> operator * (const rigid_transform &tf,
+                             const column_vector<3> &p)
+{
+    return tf.rotation() * p + tf.translation();
+}
+
+vector_batch<3> operator * (const rigid_transform &tf,
+                            const vector_batch<3> &points)
+{
+    vector_batch<3> ret(points.size(), detail::uninitialized_t());
+    tf.apply(points, ret);
+    return ret;
+}
+
+rigid_transform inverse(const rigid_transform &tf)
+{
+    const matrix<3, 3> rt = transpose(tf.rotation());
+    return rigid_transform(rt, -(rt * tf.translation()));
+}
+
+std::ostream& operator << (std::ostream &os, const rigid_transform &tf)
+{
+    return os << "[R: " << tf.rotation()
+        << ", t: " << tf.translation() << "]";
+}
+
+} // namespace lambda
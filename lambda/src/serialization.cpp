@@ -0,0 +1,181 @@
+// serialization.cpp
+
+#include "lambda/serialization.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace lambda
+{
+
+namespace
+{
+
+/// \brief Whether doubles are stored little-endian on this machine,
+/// in which case elements are copied to and from streams as they are.
+constexpr bool little_endian =
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    false;
+#else
+    true;
+#endif
+
+/// \brief The number of elements swapped or read at a time.
+constexpr size_t chunk_size = 512;
+
+const char magic[4] = { 'L', 'M', 'A', 'T' };
+
+void store(char *bytes, uint64_t value, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        bytes[i] = static_cast<char>((value >> 8*i) & 0xFF);
+    }
+}
+
+uint64_t load(const char *bytes, size_t count)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        value |= uint64_t(static_cast<unsigned char>(bytes[i])) << 8*i;
+    }
+    return value;
+}
+
+/// \brief Reverse the bytes of each of count doubles.
+void swap_bytes(double *data, size_t count)
+{
+    for (size_t k = 0; k < count; ++k)
+    {
+        char bytes[sizeof(double)];
+        std::memcpy(bytes, data + k, sizeof(double));
+        std::reverse(bytes, bytes + sizeof(double));
+        std::memcpy(data + k, bytes, sizeof(double));
+    }
+}
+
+/// \brief Read exactly count bytes, or throw.
+void read_bytes(std::istream &is, char *bytes, size_t count)
+{
+    is.read(bytes, count);
+    if (static_cast<size_t>(is.gcount()) != count)
+    {
+        std::stringstream ss;
+        ss << "Encoded matrix ends after " << is.gcount() << " of "
+            << count << " expected bytes";
+        throw std::runtime_error(ss.str());
+    }
+}
+
+} // namespace
+
+namespace detail
+{
+
+void write_elements(std::ostream &os, const double *data, size_t count)
+{
+    if (little_endian)
+    {
+        os.write(reinterpret_cast<const char*>(data),
+                 count*sizeof(double));
+        return;
+    }
+    std::array<double, chunk_size> buffer;
+    for (size_t k = 0; k < count; k += chunk_size)
+    {
+        const size_t n = std::min(chunk_size, count - k);
+        std::copy(data + k, data + k + n, buffer.begin());
+        swap_bytes(buffer.data(), n);
+        os.write(reinterpret_cast<const char*>(buffer.data()),
+                 n*sizeof(double));
+    }
+}
+
+void read_elements(std::istream &is, double *data, size_t count)
+{
+    read_bytes(is, reinterpret_cast<char*>(data), count*sizeof(double));
+    if (!little_endian) swap_bytes(data, count);
+}
+
+void encode_header(char *bytes, const encoding_header &header)
+{
+    std::memcpy(bytes, magic, sizeof(magic));
+    store(bytes + 4, encoding_version, 4);
+    store(bytes + 8, header.rows, 8);
+    store(bytes + 16, header.columns, 8);
+}
+
+encoding_header decode_header(const char *bytes)
+{
+    if (std::memcmp(bytes, magic, sizeof(magic)) != 0)
+    {
+        throw std::invalid_argument("Stream does not hold an encoded matrix");
+    }
+    const uint64_t version = load(bytes + 4, 4);
+    if (version != encoding_version)
+    {
+        std::stringstream ss;
+        ss << "Cannot read matrix encoding version " << version;
+        throw std::invalid_argument(ss.str());
+    }
+    return { load(bytes + 8, 8), load(bytes + 16, 8) };
+}
+
+} // namespace detail
+
+void write_header(std::ostream &os, const encoding_header &header)
+{
+    char bytes[detail::encoding_header_size];
+    detail::encode_header(bytes, header);
+    os.write(bytes, sizeof(bytes));
+}
+
+encoding_header read_header(std::istream &is)
+{
+    char bytes[detail::encoding_header_size];
+    read_bytes(is, bytes, sizeof(bytes));
+    return detail::decode_header(bytes);
+}
+
+void write(std::ostream &os, const dynamic_matrix &m)
+{
+    write_header(os, { m.rows(), m.columns() });
+    detail::write_elements(os, m.data().data(), m.data().size());
+}
+
+void read(std::istream &is, dynamic_matrix &m)
+{
+    const encoding_header header = read_header(is);
+    const uint64_t max_size = std::vector<double>().max_size();
+    if (header.columns != 0 && header.rows > max_size/header.columns)
+    {
+        std::stringstream ss;
+        ss << "Cannot read encoded matrix of size " << header.rows
+            << "x" << header.columns;
+        throw std::invalid_argument(ss.str());
+    }
+    const size_t count = header.rows*header.columns;
+
+    if (header.rows == m.rows() && header.columns == m.columns())
+    {
+        if (count > 0) detail::read_elements(is, &m[0], count);
+        return;
+    }
+
+    // Read a chunk at a time, so that a corrupt or truncated stream
+    // throws before a large allocation for elements which aren't there.
+    std::vector<double> data;
+    for (size_t k = 0; k < count; k += chunk_size)
+    {
+        const size_t n = std::min(chunk_size, count - k);
+        data.resize(k + n);
+        detail::read_elements(is, data.data() + k, n);
+    }
+    m = dynamic_matrix(header.rows, header.columns, data, m.resource());
+}
+
+} // namespace lambda
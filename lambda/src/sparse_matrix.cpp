@@ -0,0 +1,486 @@
+// sparse_matrix.cpp
+
+#include "lambda/sparse_matrix.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include "lambda/parallel.hpp"
+
+namespace lambda
+{
+
+namespace
+{
+
+/// \brief The fewest multiply-adds a sparse product gives a thread;
+/// smaller products are bound by the cost of starting threads.
+constexpr size_t sparse_grain = 1 << 15;
+
+/// \brief Throws an exception unless two matrices are the same size.
+void require_same_size(const sparse_matrix &left,
+                       const sparse_matrix &right, const char *operation)
+{
+    if (left.columns() != right.columns() ||
+        left.rows() != right.rows())
+    {
+        std::stringstream ss;
+        ss << "Cannot " << operation << " matrices of dimensions "
+            << left.rows() << "x" << left.columns() << " and "
+            << right.rows() << "x" << right.columns();
+        throw std::invalid_argument(ss.str());
+    }
+}
+
+/// \brief Calls f(j, a, b) for each column j stored in row i of left
+/// or right, in order, where a and b are their elements, or zero where
+/// not stored.
+template <class F> void merge_row(const sparse_matrix &left,
+                                  const sparse_matrix &right, size_t i, F f)
+{
+    const auto &li = left.column_indices(), &ri = right.column_indices();
+    const auto &lv = left.values(), &rv = right.values();
+    size_t l = left.row_offsets()[i], r = right.row_offsets()[i];
+    const size_t l_end = left.row_offsets()[i + 1];
+    const size_t r_end = right.row_offsets()[i + 1];
+    while (l < l_end || r < r_end)
+    {
+        if (r == r_end || (l < l_end && li[l] < ri[r]))
+        {
+            f(li[l], lv[l], 0.0);
+            ++l;
+        }
+        else if (l == l_end || ri[r] < li[l])
+        {
+            f(ri[r], 0.0, rv[r]);
+            ++r;
+        }
+        else
+        {
+            f(li[l], lv[l], rv[r]);
+            ++l;
+            ++r;
+        }
+    }
+}
+
+/// \brief Get the rows of a band which hold about sparse_grain
+/// multiply-adds, for a product with work multiply-adds over rows.
+size_t row_grain(size_t work, size_t rows)
+{
+    return work == 0 ? rows : std::max<size_t>(1, sparse_grain*rows/work);
+}
+
+} // namespace
+
+sparse_matrix::sparse_matrix(size_t rows, size_t columns,
+                             std::pmr::memory_resource *resource)
+    : _offsets(rows + 1, 0, resource), _indices(resource),
+    _values(resource), _rows(rows), _columns(columns) { }
+
+sparse_matrix::sparse_matrix(const sparse_matrix &other,
+                             std::pmr::memory_resource *resource)
+    : _offsets(other._offsets, resource), _indices(other._indices, resource),
+    _values(other._values, resource), _rows(other._rows),
+    _columns(other._columns) { }
+
+sparse_matrix::sparse_matrix(const dynamic_matrix &dense,
+                             std::pmr::memory_resource *resource)
+    : sparse_matrix(dense.rows(), dense.columns(), resource)
+{
+    const size_t count = dense.data().size() - std::count(
+        dense.data().begin(), dense.data().end(), 0.0);
+    _indices.reserve(count);
+    _values.reserve(count);
+    for (size_t i = 0; i < _rows; ++i)
+    {
+        for (size_t j = 0; j < _columns; ++j)
+        {
+            const double x = dense(i, j);
+            if (x == 0) continue;
+            _indices.push_back(j);
+            _values.push_back(x);
+        }
+        _offsets[i + 1] = _indices.size();
+    }
+}
+
+sparse_matrix::sparse_matrix(size_t rows, size_t columns,
+                             std::pmr::vector<size_t> row_offsets,
+                             std::pmr::vector<size_t> column_indices,
+                             std::pmr::vector<double> values)
+    : _offsets(std::move(row_offsets)), _indices(std::move(column_indices)),
+    _values(std::move(values)), _rows(rows), _columns(columns)
+{
+    const char *problem = nullptr;
+    if (_offsets.size() != rows + 1 || _offsets.front() != 0 ||
+        _offsets.back() != _indices.size())
+    {
+        problem = "row offsets do not match";
+    }
+    else if (_values.size() != _indices.size())
+    {
+        problem = "values do not match column indices of";
+    }
+    for (size_t i = 0; i < rows && !problem; ++i)
+    {
+        if (_offsets[i] > _offsets[i + 1] ||
+            _offsets[i + 1] > _indices.size())
+        {
+            problem = "row offsets decrease or overrun";
+        }
+    }
+    for (size_t i = 0; i < rows && !problem; ++i)
+    {
+        for (size_t k = _offsets[i]; k < _offsets[i + 1]; ++k)
+        {
+            if (_indices[k] >= columns ||
+                (k > _offsets[i] && _indices[k] <= _indices[k - 1]))
+            {
+                problem = "column indices are not sorted and in range for";
+                break;
+            }
+        }
+    }
+    if (problem)
+    {
+        std::stringstream ss;
+        ss << "Cannot construct sparse matrix: " << problem << " "
+            << rows << "x" << columns << " matrix";
+        throw std::invalid_argument(ss.str());
+    }
+}
+
+sparse_matrix& sparse_matrix::operator *= (double scalar)
+{
+    for (double &x : _values)
+    {
+        x *= scalar;
+    }
+    return *this;
+}
+
+size_t sparse_matrix::rows() const
+{
+    return _rows;
+}
+
+size_t sparse_matrix::columns() const
+{
+    return _columns;
+}
+
+size_t sparse_matrix::nonzeros() const
+{
+    return _values.size();
+}
+
+double sparse_matrix::operator () (size_t i, size_t j) const
+{
+    const auto first = _indices.begin() + _offsets[i];
+    const auto last = _indices.begin() + _offsets[i + 1];
+    const auto found = std::lower_bound(first, last, j);
+    if (found == last || *found != j) return 0;
+    return _values[found - _indices.begin()];
+}
+
+double sparse_matrix::at(size_t i, size_t j) const
+{
+    if (i >= _rows || j >= _columns)
+    {
+        std::stringstream ss;
+        ss << "Cannot access element (" << i << ", " << j
+            << ") of " << _rows << "x" << _columns << " matrix";
+        throw std::out_of_range(ss.str());
+    }
+    return (*this)(i, j);
+}
+
+const std::pmr::vector<size_t>& sparse_matrix::row_offsets() const
+{
+    return _offsets;
+}
+
+const std::pmr::vector<size_t>& sparse_matrix::column_indices() const
+{
+    return _indices;
+}
+
+const std::pmr::vector<double>& sparse_matrix::values() const
+{
+    return _values;
+}
+
+std::pmr::memory_resource* sparse_matrix::resource() const
+{
+    return _values.get_allocator().resource();
+}
+
+sparse_builder::sparse_builder(size_t rows, size_t columns)
+    : _rows(rows), _columns(columns) { }
+
+void sparse_builder::add(size_t i, size_t j, double value)
+{
+    if (i >= _rows || j >= _columns)
+    {
+        std::stringstream ss;
+        ss << "Cannot add element (" << i << ", " << j
+            << ") to " << _rows << "x" << _columns << " matrix";
+        throw std::out_of_range(ss.str());
+    }
+    _triplets.push_back({ i, j, value });
+}
+
+void sparse_builder::reserve(size_t count)
+{
+    _triplets.reserve(count);
+}
+
+size_t sparse_builder::size() const
+{
+    return _triplets.size();
+}
+
+sparse_matrix sparse_builder::build(std::pmr::memory_resource *resource)
+    const
+{
+    // Counting sort by row, which keeps the order elements were added
+    // in, then a stable sort of each row by column, so that repeated
+    // elements are always summed in the same order.
+    std::vector<size_t> next(_rows + 1, 0);
+    for (const triplet &t : _triplets)
+    {
+        ++next[t.row + 1];
+    }
+    std::partial_sum(next.begin(), next.end(), next.begin());
+    const std::vector<size_t> start = next;
+    std::vector<std::pair<size_t, double>> sorted(_triplets.size());
+    for (const triplet &t : _triplets)
+    {
+        sorted[next[t.row]++] = { t.column, t.value };
+    }
+
+    std::pmr::vector<size_t> offsets(_rows + 1, 0, resource);
+    std::pmr::vector<size_t> indices(resource);
+    std::pmr::vector<double> values(resource);
+    indices.reserve(sorted.size());
+    values.reserve(sorted.size());
+    for (size_t i = 0; i < _rows; ++i)
+    {
+        const auto first = sorted.begin() + start[i];
+        const auto last = sorted.begin() + start[i + 1];
+        std::stable_sort(first, last, [] (const auto &a, const auto &b)
+        {
+            return a.first < b.first;
+        });
+        for (auto e = first; e != last; ++e)
+        {
+            if (e != first && e->first == indices.back())
+            {
+                values.back() += e->second;
+                continue;
+            }
+            indices.push_back(e->first);
+            values.push_back(e->second);
+        }
+        offsets[i + 1] = indices.size();
+    }
+    return sparse_matrix(_rows, _columns, std::move(offsets),
+                         std::move(indices), std::move(values));
+}
+
+bool operator == (const sparse_matrix &left, const sparse_matrix &right)
+{
+    if (left.rows() != right.rows() || left.columns() != right.columns())
+    {
+        return false;
+    }
+    bool equal = true;
+    for (size_t i = 0; i < left.rows() && equal; ++i)
+    {
+        merge_row(left, right, i, [&] (size_t, double a, double b)
+        {
+            equal = equal && a == b;
+        });
+    }
+    return equal;
+}
+
+dynamic_matrix to_dense(const sparse_matrix &m,
+                        std::pmr::memory_resource *resource)
+{
+    dynamic_matrix ret(m.rows(), m.columns(), resource);
+    for (size_t i = 0; i < m.rows(); ++i)
+    {
+        for (size_t k = m.row_offsets()[i]; k < m.row_offsets()[i + 1]; ++k)
+        {
+            ret(i, m.column_indices()[k]) = m.values()[k];
+        }
+    }
+    return ret;
+}
+
+sparse_matrix transpose(const sparse_matrix &m)
+{
+    // Counting sort by column; visiting rows in order leaves each row
+    // of the transpose sorted.
+    std::pmr::vector<size_t> offsets(m.columns() + 1, 0, matrix_resource());
+    for (size_t j : m.column_indices())
+    {
+        ++offsets[j + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+    std::pmr::vector<size_t> indices(m.nonzeros(), matrix_resource());
+    std::pmr::vector<double> values(m.nonzeros(), matrix_resource());
+    for (size_t i = 0; i < m.rows(); ++i)
+    {
+        for (size_t k = m.row_offsets()[i]; k < m.row_offsets()[i + 1]; ++k)
+        {
+            const size_t t = next[m.column_indices()[k]]++;
+            indices[t] = i;
+            values[t] = m.values()[k];
+        }
+    }
+    return sparse_matrix(m.columns(), m.rows(), std::move(offsets),
+                         std::move(indices), std::move(values));
+}
+
+dynamic_matrix operator * (const sparse_matrix &left,
+                           const dynamic_matrix &right)
+{
+    if (left.columns() != right.rows())
+    {
+        std::stringstream ss;
+        ss << "Cannot multiply matrices of dimensions "
+            << left.rows() << "x" << left.columns() << " and "
+            << right.rows() << "x" << right.columns();
+        throw std::invalid_argument(ss.str());
+    }
+
+    const size_t N = right.columns();
+    dynamic_matrix ret(left.rows(), N);
+    if (ret.data().empty()) return ret;
+    const size_t *offsets = left.row_offsets().data();
+    const size_t *indices = left.column_indices().data();
+    const double *values = left.values().data();
+    const double *b = right.data().data();
+    double *c = &ret[0];
+
+    detail::parallel_for(left.rows(),
+        row_grain(left.nonzeros()*N, left.rows()),
+        [=] (size_t begin, size_t end)
+    {
+        if (N == 1)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                double sum = 0;
+                for (size_t k = offsets[i]; k < offsets[i + 1]; ++k)
+                {
+                    sum += values[k]*b[indices[k]];
+                }
+                c[i] = sum;
+            }
+            return;
+        }
+        for (size_t i = begin; i < end; ++i)
+        {
+            double *ci = c + i*N;
+            for (size_t k = offsets[i]; k < offsets[i + 1]; ++k)
+            {
+                const double v = values[k];
+                const double *bk = b + indices[k]*N;
+                for (size_t j = 0; j < N; ++j)
+                {
+                    ci[j] += v*bk[j];
+                }
+            }
+        }
+    });
+    return ret;
+}
+
+dynamic_matrix transpose_multiply(const sparse_matrix &left,
+                                  const dynamic_matrix &right)
+{
+    if (left.rows() != right.rows())
+    {
+        std::stringstream ss;
+        ss << "Cannot multiply transpose of matrix of dimensions "
+            << left.rows() << "x" << left.columns() << " and matrix of "
+            << "dimensions " << right.rows() << "x" << right.columns();
+        throw std::invalid_argument(ss.str());
+    }
+
+    // Each row of right is scattered into the rows of the result given
+    // by the columns of the same row of left. Threads would collide on
+    // those rows, so they take bands of columns instead.
+    const size_t N = right.columns();
+    dynamic_matrix ret(left.columns(), N);
+    if (ret.data().empty()) return ret;
+    const size_t *offsets = left.row_offsets().data();
+    const size_t *indices = left.column_indices().data();
+    const double *values = left.values().data();
+    const double *b = right.data().data();
+    double *c = &ret[0];
+    const size_t rows = left.rows();
+
+    detail::parallel_for(N, row_grain(left.nonzeros()*N, N),
+        [=] (size_t begin, size_t end)
+    {
+        for (size_t i = 0; i < rows; ++i)
+        {
+            const double *bi = b + i*N;
+            for (size_t k = offsets[i]; k < offsets[i + 1]; ++k)
+            {
+                const double v = values[k];
+                double *ck = c + indices[k]*N;
+                for (size_t j = begin; j < end; ++j)
+                {
+                    ck[j] += v*bi[j];
+                }
+            }
+        }
+    });
+    return ret;
+}
+
+sparse_matrix operator + (const sparse_matrix &left,
+                          const sparse_matrix &right)
+{
+    require_same_size(left, right, "add");
+    std::pmr::vector<size_t> offsets(left.rows() + 1, 0, matrix_resource());
+    std::pmr::vector<size_t> indices(matrix_resource());
+    std::pmr::vector<double> values(matrix_resource());
+    indices.reserve(std::max(left.nonzeros(), right.nonzeros()));
+    values.reserve(indices.capacity());
+    for (size_t i = 0; i < left.rows(); ++i)
+    {
+        merge_row(left, right, i, [&] (size_t j, double a, double b)
+        {
+            indices.push_back(j);
+            values.push_back(a + b);
+        });
+        offsets[i + 1] = indices.size();
+    }
+    return sparse_matrix(left.rows(), left.columns(), std::move(offsets),
+                         std::move(indices), std::move(values));
+}
+
+sparse_matrix operator * (const sparse_matrix &m, double scalar)
+{
+    sparse_matrix ret = m;
+    ret *= scalar;
+    return ret;
+}
+
+sparse_matrix operator * (double scalar, const sparse_matrix &m)
+{
+    return m*scalar;
+}
+
+} // namespace lambda
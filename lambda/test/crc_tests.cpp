@@ -0,0 +1,36 @@
+#include <catch2/catch.hpp>
+#include <lambda/crc.hpp>
+
+#include <string>
+
+namespace
+{
+
+std::vector<bool> bits(uint64_t value, size_t count)
+{
+    std::vector<bool> ret(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        ret[i] = (value >> (count - 1 - i)) & 1;
+    }
+    return ret;
+}
+
+} // namespace
+
+TEST_CASE("Cyclic redundancy checks.", "[crc]")
+{
+    const std::string check = "123456789";
+    const std::vector<uint8_t> data(check.begin(), check.end());
+
+    REQUIRE( lambda::crc(data, bits(0x107, 9)) == bits(0xF4, 8) );
+    REQUIRE( lambda::crc(data, bits(0x11021, 17)) == bits(0x31C3, 16) );
+    REQUIRE( lambda::crc(data, bits(0x104C11DB7, 33)) ==
+             bits(0x89A1897F, 32) );
+    REQUIRE( lambda::crc({ 0x80 }, bits(0b1011, 4)) == bits(0b011, 3) );
+    REQUIRE( lambda::crc({}, bits(0b1011, 4)) == bits(0, 3) );
+
+    REQUIRE_THROWS_AS(lambda::crc(data, bits(0x07, 9)),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(lambda::crc(data, bits(1, 1)), std::invalid_argument);
+}
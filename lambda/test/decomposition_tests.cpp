@@ -3,10 +3,198 @@
 
 #include <Eigen/Core>
 
-#if 0
+#include <random>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+
+/// \brief Checks that two expressions agree elementwise, to within
+/// margin.
+template <class A, class B>
+void require_close(const A &a, const B &b, double margin = 1e-12)
+{
+    for (size_t i = 0; i < A::rows*A::cols; ++i)
+    {
+        REQUIRE( a[i] == Approx(b[i]).margin(margin) );
+    }
+}
+
+} // namespace
+
+TEST_CASE("LU factorization with partial pivoting.", "[decomposition]")
+{
+    using Catch::Matchers::Contains;
+
+    const lambda::matrix<5, 5> A(1, -14, 11,  -6,  -5,
+                                 6,  -3, 10,  -8, -10,
+                                -2,  11,  9, -11,  11,
+                                 4,  12, -6,  -1,   7,
+                                -5,   4,  6,  -4, -10);
+    const auto lu = lambda::decompose_lu(A);
+    REQUIRE( !lu.singular() );
+
+    // PA = LU, with L unit lower and U upper triangular.
+    const auto L = lu.lower();
+    const auto U = lu.upper();
+    const lambda::matrix<5, 5> LU = L*U;
+    for (size_t i = 0; i < 5; ++i)
+    {
+        REQUIRE( L(i, i) == 1 );
+        for (size_t j = 0; j < 5; ++j)
+        {
+            if (j > i) REQUIRE( L(i, j) == 0 );
+            if (j < i) REQUIRE( U(i, j) == 0 );
+            REQUIRE( LU(i, j) == Approx(A(lu.permutation()[i], j)) );
+        }
+    }
+    REQUIRE( lu.det() == Approx(lambda::det(A)) );
+
+    // One right-hand side, and several at once.
+    const lambda::column_vector<5> b(1, 2, 3, 4, 5);
+    const auto x = lu.solve(b);
+    const lambda::column_vector<5> Ax = A*x;
+    for (size_t i = 0; i < 5; ++i)
+    {
+        REQUIRE( Ax[i] == Approx(b[i]) );
+    }
+    const lambda::matrix<5, 3> B(1, 0, -2,
+                                 2, 1,  7,
+                                 3, 0,  1,
+                                 4, 1, -3,
+                                 5, 0,  4);
+    const lambda::matrix<5, 3> AX = A*lu.solve(B);
+    for (size_t i = 0; i < 15; ++i)
+    {
+        REQUIRE( AX[i] == Approx(B[i]).margin(1e-12) );
+    }
+
+    const auto inv = lu.inverse();
+    const auto ref = lambda::inverse(A);
+    for (size_t i = 0; i < 25; ++i)
+    {
+        REQUIRE( inv[i] == Approx(ref[i]) );
+    }
+
+    const lambda::lu_factorization<3, float> singular(
+        lambda::matrix<3, 3, float>(1, 2, 3, 4, 5, 6, 1, 2, 3));
+    REQUIRE( singular.singular() );
+    REQUIRE( singular.det() == 0 );
+    REQUIRE_THROWS_WITH(singular.inverse(), Contains("singular"));
+}
+
+TEST_CASE("Cholesky, LDL^T and LDU factorizations.", "[decomposition]")
+{
+    using Catch::Matchers::Contains;
+
+    const lambda::matrix<4, 4> B(2, -1,  0,  3,
+                                 1,  4, -2,  0,
+                                 0,  1,  3, -1,
+                                -2,  0,  1,  2);
+    const lambda::symmetric_matrix<4> A(B*lambda::transpose(B) +
+                                        lambda::identity<4, 4>());
+
+    auto chol = lambda::decompose_cholesky(A);
+    REQUIRE( chol.positive_definite() );
+    const auto LLt = lambda::symmetric_product(chol.lower());
+    for (size_t i = 0; i < 16; ++i)
+    {
+        REQUIRE( LLt[i] == Approx(A[i]) );
+    }
+    REQUIRE( chol.det() == Approx(lambda::det(lambda::matrix<4, 4>(A))) );
+
+    const lambda::matrix<4, 2> b(1, -1,
+                                 2,  0,
+                                 3,  5,
+                                 4,  2);
+    const lambda::matrix<4, 2> Ax = lambda::matrix<4, 4>(A)*chol.solve(b);
+    for (size_t i = 0; i < 8; ++i)
+    {
+        REQUIRE( Ax[i] == Approx(b[i]).margin(1e-12) );
+    }
+    const auto inv = lambda::inverse(lambda::matrix<4, 4>(A));
+    for (size_t i = 0; i < 16; ++i)
+    {
+        REQUIRE( chol.inverse()[i] == Approx(inv[i]) );
+    }
+
+    // Updating and downdating by v agree with factoring A + vv^T, and
+    // take the factor back to that of A.
+    const lambda::column_vector<4> v(0.5, -1, 2, 1);
+    const lambda::cholesky_factorization<4> updated(
+        A + lambda::symmetric_matrix<4>(v*lambda::transpose(v)));
+    chol.update(v);
+    for (size_t i = 0; i < 16; ++i)
+    {
+        REQUIRE( chol.lower()[i] == Approx(updated.lower()[i]) );
+    }
+    REQUIRE( chol.downdate(v) );
+    for (size_t i = 0; i < 16; ++i)
+    {
+        REQUIRE( lambda::symmetric_product(chol.lower())[i] ==
+                 Approx(A[i]) );
+    }
+    const auto before = chol.lower();
+    REQUIRE( !chol.downdate(10.0*v) );
+    REQUIRE( chol.lower() == before );
+
+    // An indefinite matrix has no Cholesky factor, but has an LDL^T one.
+    const lambda::symmetric_matrix<3> S(lambda::matrix<3, 3>(
+        4,  2, -2,
+        2, -3,  1,
+       -2,  1,  5));
+    const lambda::cholesky_factorization<3> indefinite(S);
+    REQUIRE( !indefinite.positive_definite() );
+    REQUIRE_THROWS_WITH(indefinite.solve(lambda::column_vector<3>()),
+                        Contains("not positive definite"));
+
+    const auto ldlt = lambda::decompose_ldlt(S);
+    REQUIRE( !ldlt.zero_pivot() );
+    REQUIRE( !ldlt.positive_definite() );
+    const auto &L = ldlt.lower();
+    const auto &d = ldlt.diagonal();
+    for (size_t i = 0; i < 3; ++i)
+    {
+        REQUIRE( L(i, i) == 1 );
+        for (size_t j = 0; j < 3; ++j)
+        {
+            double sum = 0;
+            for (size_t k = 0; k < 3; ++k)
+            {
+                sum += L(i, k)*d[k]*L(j, k);
+            }
+            REQUIRE( sum == Approx(S(i, j)) );
+        }
+    }
+    REQUIRE( ldlt.det() == Approx(lambda::det(lambda::matrix<3, 3>(S))) );
+    const lambda::column_vector<3> c(1, 2, 3);
+    const lambda::column_vector<3> Sx =
+        lambda::matrix<3, 3>(S)*ldlt.solve(c);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        REQUIRE( Sx[i] == Approx(c[i]) );
+    }
+
+    lambda::matrix<4, 4> Lu, D, U;
+    std::tie(Lu, D, U) = lambda::decompose_ldu(B);
+    const lambda::matrix<4, 4> LDU = Lu*D*U;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        REQUIRE( Lu(i, i) == 1 );
+        REQUIRE( U(i, i) == 1 );
+        for (size_t j = 0; j < 4; ++j)
+        {
+            REQUIRE( LDU(i, j) == Approx(B(i, j)).margin(1e-12) );
+        }
+    }
+    REQUIRE_THROWS_WITH(lambda::decompose_ldu(
+        lambda::matrix<2, 2>(0, 1, 1, 0)), Contains("zero pivot"));
+}
+
 TEST_CASE("Singular value decomposition.", "[decomposition]")
 {
-    lambda::matrix<4, 5> test(
+    const lambda::matrix<4, 5> test(
         1, 0, 0, 0, 2,
         0, 0, 3, 0, 0,
         0, 0, 0, 0, 0,
@@ -17,22 +205,270 @@ TEST_CASE("Singular value decomposition.", "[decomposition]")
     lambda::matrix<5, 5> V_star;
     std::tie(U, sigma, V_star) = lambda::svd(test);
 
-    REQUIRE( U == lambda::matrix<4, 4>(0, 0, 1,  0,
-                                       0, 1, 0,  0,
-                                       0, 0, 0, -1,
-                                       1, 0, 0,  0) );
-    REQUIRE( sigma == lambda::matrix<4, 5>(2, 0, 1, 0, 0,
-                                           0, 3, 0, 0, 0,
-                                           0, 0, 2.23606797749979, 0, 0,
-                                           0, 0, 0, 0, 0) );
-
-    REQUIRE( test == U*sigma*V_star );
-    REQUIRE( U*lambda::transpose(U) == lambda::identity<4, 4>() );
-    REQUIRE( lambda::is_unitary(U) );
-    REQUIRE( V_star*lambda::transpose(V_star) == lambda::identity<5, 5>() );
-    REQUIRE( lambda::is_unitary(V_star) );
+    require_close(sigma, lambda::matrix<4, 5>(
+        3, 0, 0, 0, 0,
+        0, 2.23606797749979, 0, 0, 0,
+        0, 0, 2, 0, 0,
+        0, 0, 0, 0, 0));
+    require_close(lambda::matrix<4, 5>(U*sigma*V_star), test);
+    require_close(lambda::matrix<4, 4>(U*lambda::transpose(U)),
+                  lambda::identity<4, 4>());
+    require_close(lambda::matrix<5, 5>(V_star*lambda::transpose(V_star)),
+                  lambda::identity<5, 5>());
+
+    // The pseudo-inverse of a matrix of full column rank is its left
+    // inverse, and agrees with the normal equations.
+    const lambda::matrix<5, 3> A(2, -1,  0,
+                                 1,  3, -2,
+                                 0,  5,  4,
+                                -3,  1,  1,
+                                 2,  2, -1);
+    const lambda::matrix<3, 5> At = lambda::transpose(A);
+    const lambda::matrix<3, 5> normal =
+        lambda::inverse(lambda::matrix<3, 3>(At*A))*At;
+    require_close(lambda::pinv(A), normal);
+    require_close(lambda::matrix<3, 3>(lambda::pinv(A)*A),
+                  lambda::identity<3, 3>());
+
+    // A rank one matrix has a single nonzero singular value.
+    const lambda::matrix<3, 3> outer(1, 2, 3, 2, 4, 6, 3, 6, 9);
+    const auto values = lambda::singular_values(outer);
+    REQUIRE( values[0] == Approx(14) );
+    REQUIRE( values[1] == Approx(0).margin(1e-12) );
+    REQUIRE( values[2] == Approx(0).margin(1e-12) );
+    require_close(lambda::matrix<3, 3>(outer*lambda::pinv(outer)*outer),
+                  outer);
+}
+
+TEST_CASE("QR factorization and least squares.", "[decomposition]")
+{
+    using Catch::Matchers::Contains;
+
+    const lambda::matrix<5, 3> A(2, -1,  0,
+                                 1,  3, -2,
+                                 0,  5,  4,
+                                -3,  1,  1,
+                                 2,  2, -1);
+    const auto qr = lambda::decompose_qr(A);
+    REQUIRE( qr.full_rank() );
+    const lambda::matrix<5, 5> Q = qr.q();
+    const lambda::matrix<5, 3> R = qr.r();
+    require_close(lambda::matrix<5, 3>(Q*R), A);
+    require_close(lambda::matrix<5, 5>(Q*lambda::transpose(Q)),
+                  lambda::identity<5, 5>());
+    for (size_t i = 0; i < 5; ++i)
+    {
+        for (size_t j = 0; j < i && j < 3; ++j)
+        {
+            REQUIRE( R(i, j) == 0 );
+        }
+    }
+
+    // The residual of the least squares solution is orthogonal to the
+    // columns of A, and the solution agrees with the pseudo-inverse.
+    const lambda::matrix<5, 2> B(1,  0,
+                                 2, -1,
+                                -1,  3,
+                                 0,  2,
+                                 4,  1);
+    const lambda::matrix<3, 2> X = lambda::least_squares(A, B);
+    require_close(X, lambda::matrix<3, 2>(lambda::pinv(A)*B));
+    require_close(lambda::matrix<3, 2>(lambda::transpose(A)*(A*X - B)),
+                  lambda::matrix<3, 2>());
+
+    // A square system is solved exactly.
+    const lambda::matrix<3, 3> S(4, -2, 1, 3, 6, -4, 2, 1, 8);
+    const lambda::column_vector<3> b(12, -25, 32);
+    require_close(lambda::column_vector<3>(lambda::least_squares(S, b)),
+                  lambda::decompose_lu(S).solve(b));
+
+    const lambda::matrix<4, 2> dependent(1, 2, 2, 4, 3, 6, 4, 8);
+    REQUIRE_FALSE( lambda::decompose_qr(dependent).full_rank() );
+    REQUIRE_THROWS_WITH(lambda::least_squares(dependent,
+        lambda::column_vector<4>(1, 2, 3, 4)),
+        Contains("full column rank"));
+
+    // Batches agree with the scalar solver, including the padding of a
+    // partial last line.
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<double> dist(-1, 1);
+    std::vector<lambda::matrix<12, 4>> As(37);
+    std::vector<lambda::column_vector<12>> bs(37);
+    for (size_t k = 0; k < As.size(); ++k)
+    {
+        for (size_t i = 0; i < 48; ++i)
+        {
+            As[k][i] = dist(gen);
+        }
+        for (size_t i = 0; i < 12; ++i)
+        {
+            bs[k][i] = dist(gen);
+        }
+    }
+    const lambda::matrix_batch<12, 4> batch_A(As);
+    const lambda::vector_batch<12> batch_b(bs);
+    const lambda::vector_batch<4> batch_x =
+        lambda::least_squares(batch_A, batch_b);
+    REQUIRE( batch_x.size() == 37 );
+    for (size_t k = 0; k < As.size(); ++k)
+    {
+        require_close(batch_x.gather(k), lambda::least_squares(As[k], bs[k]));
+    }
+    REQUIRE_THROWS_AS(lambda::least_squares(batch_A,
+        lambda::vector_batch<12>(36)), std::invalid_argument);
+}
+
+TEST_CASE("Fast 3x3 singular value decomposition.", "[decomposition]")
+{
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> dist(-1, 1);
+    std::vector<lambda::matrix<3, 3>> mats(19);
+    for (auto &m : mats)
+    {
+        for (size_t i = 0; i < 9; ++i)
+        {
+            m[i] = dist(gen);
+        }
+    }
+    // A singular matrix, and a reflection whose sigma must stay positive.
+    mats[5] = lambda::matrix<3, 3>(1, 2, 3, 2, 4, 6, 0, 1, 1);
+    mats[6] = lambda::matrix<3, 3>(-2, 0, 0, 0, 1, 0, 0, 0, 0.5);
+
+    const lambda::matrix_batch<3, 3> batch(mats);
+    lambda::matrix_batch<3, 3> batch_U, batch_V_star;
+    lambda::vector_batch<3> batch_sigma;
+    std::tie(batch_U, batch_sigma, batch_V_star) = lambda::fast_svd(batch);
+
+    // The signs of the singular vectors of a zero singular value may
+    // differ between the two, so each is checked against the definition.
+    const auto check = [] (const lambda::matrix<3, 3> &U,
+                           const lambda::matrix<3, 3> &sigma,
+                           const lambda::matrix<3, 3> &V_star,
+                           const lambda::matrix<3, 3> &m)
+    {
+        const auto reference = lambda::singular_values(m);
+        for (size_t i = 0; i < 3; ++i)
+        {
+            REQUIRE( sigma(i, i) == Approx(reference[i]).margin(1e-12) );
+        }
+        require_close(lambda::matrix<3, 3>(U*sigma*V_star), m);
+        require_close(lambda::matrix<3, 3>(U*lambda::transpose(U)),
+                      lambda::identity<3, 3>());
+        require_close(lambda::matrix<3, 3>(V_star*lambda::transpose(V_star)),
+                      lambda::identity<3, 3>());
+    };
+    for (size_t k = 0; k < mats.size(); ++k)
+    {
+        lambda::matrix<3, 3> U, sigma, V_star;
+        std::tie(U, sigma, V_star) = lambda::fast_svd(mats[k]);
+        check(U, sigma, V_star, mats[k]);
+
+        lambda::matrix<3, 3> batch_diagonal;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            batch_diagonal(i, i) = batch_sigma(k, i, 0);
+        }
+        check(batch_U.gather(k), batch_diagonal, batch_V_star.gather(k),
+              mats[k]);
+    }
+}
+
+TEST_CASE("Symmetric eigendecomposition.", "[decomposition]")
+{
+    // Checks A = V diag(lambda) V^T, V orthogonal, and lambda
+    // increasing.
+    const auto check = [] (const auto &values, const auto &vectors,
+                           const auto &a)
+    {
+        using matrix_type = std::decay_t<decltype(vectors)>;
+        constexpr size_t N = matrix_type::rows;
+        matrix_type diagonal;
+        for (size_t i = 0; i < N; ++i)
+        {
+            diagonal(i, i) = values[i];
+            if (i > 0)
+            {
+                REQUIRE( values[i - 1] <= values[i] );
+            }
+        }
+        require_close(matrix_type(vectors*diagonal*
+                                  lambda::transpose(vectors)), a);
+        require_close(matrix_type(vectors*lambda::transpose(vectors)),
+                      lambda::identity<N, N>());
+    };
+
+    lambda::column_vector<2> values2;
+    lambda::matrix<2, 2> vectors2;
+    const lambda::matrix<2, 2> a2(2, 1, 1, 2);
+    std::tie(values2, vectors2) = lambda::symmetric_eigen(a2);
+    REQUIRE( values2[0] == Approx(1) );
+    REQUIRE( values2[1] == Approx(3) );
+    check(values2, vectors2, a2);
+    const lambda::matrix<2, 2> diagonal2(3, 0, 0, -1);
+    std::tie(values2, vectors2) = lambda::symmetric_eigen(diagonal2);
+    check(values2, vectors2, diagonal2);
+
+    // The second difference matrix, whose eigenvalues are 2 - sqrt(2),
+    // 2 and 2 + sqrt(2), both ways, and read from a symmetric_matrix.
+    const lambda::matrix<3, 3> a3(2, -1, 0, -1, 2, -1, 0, -1, 2);
+    lambda::column_vector<3> values3;
+    lambda::matrix<3, 3> vectors3;
+    std::tie(values3, vectors3) =
+        lambda::symmetric_eigen(lambda::symmetric_matrix<3>(a3));
+    REQUIRE( values3[0] == Approx(2 - std::sqrt(2.0)) );
+    REQUIRE( values3[1] == Approx(2) );
+    REQUIRE( values3[2] == Approx(2 + std::sqrt(2.0)) );
+    check(values3, vectors3, a3);
+    std::tie(values3, vectors3) = lambda::fast_symmetric_eigen(a3);
+    REQUIRE( values3[0] == Approx(2 - std::sqrt(2.0)) );
+    REQUIRE( values3[1] == Approx(2) );
+    REQUIRE( values3[2] == Approx(2 + std::sqrt(2.0)) );
+    check(values3, vectors3, a3);
+
+    // Random matrices, and in 3x3 a double root, a diagonal matrix and
+    // zero, for which fast_symmetric_eigen has separate paths.
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> dist(-1, 1);
+    lambda::matrix<6, 6> a6;
+    for (size_t i = 0; i < 6; ++i)
+    {
+        for (size_t j = 0; j <= i; ++j)
+        {
+            a6(i, j) = a6(j, i) = dist(gen);
+        }
+    }
+    lambda::column_vector<6> values6;
+    lambda::matrix<6, 6> vectors6;
+    std::tie(values6, vectors6) = lambda::symmetric_eigen(a6);
+    check(values6, vectors6, a6);
+
+    std::vector<lambda::matrix<3, 3>> mats(20);
+    for (auto &m : mats)
+    {
+        for (size_t i = 0; i < 3; ++i)
+        {
+            for (size_t j = 0; j <= i; ++j)
+            {
+                m(i, j) = m(j, i) = dist(gen);
+            }
+        }
+    }
+    const lambda::matrix<3, 3> rotation = std::get<0>(lambda::svd(mats[0]));
+    mats[1] = rotation*lambda::matrix<3, 3>(1, 0, 0, 0, 1, 0, 0, 0, 2)*
+        lambda::transpose(rotation);
+    mats[2] = lambda::matrix<3, 3>(4, 0, 0, 0, -2, 0, 0, 0, 1);
+    mats[3] = lambda::matrix<3, 3>();
+    for (const auto &m : mats)
+    {
+        lambda::column_vector<3> reference, values;
+        lambda::matrix<3, 3> vectors;
+        std::tie(reference, vectors) = lambda::symmetric_eigen(m);
+        check(reference, vectors, m);
+        std::tie(values, vectors) = lambda::fast_symmetric_eigen(m);
+        require_close(values, reference);
+        check(values, vectors, m);
+    }
 }
-#endif
 
 TEST_CASE("Using Eigen3", "[decomposition]")
 {
@@ -0,0 +1,153 @@
+#include <catch2/catch.hpp>
+#include <lambda/lambda.hpp>
+
+#include <random>
+
+namespace
+{
+
+/// \brief A matrix of uniform random elements in [-1, 1], which has full
+/// rank (almost surely).
+lambda::dynamic_matrix pattern(size_t rows, size_t columns, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> dist(-1, 1);
+    lambda::dynamic_matrix m(rows, columns);
+    for (size_t i = 0; i < rows*columns; ++i)
+    {
+        m[i] = dist(gen);
+    }
+    return m;
+}
+
+/// \brief A symmetric positive definite matrix, B^T*B + N*I.
+lambda::dynamic_matrix spd(size_t N, unsigned seed)
+{
+    const auto b = pattern(N, N, seed);
+    lambda::dynamic_matrix bt(N, N);
+    for (size_t i = 0; i < N; ++i)
+    {
+        for (size_t j = 0; j < N; ++j) bt(i, j) = b(j, i);
+    }
+    auto a = bt*b;
+    for (size_t i = 0; i < N; ++i) a(i, i) += N;
+    return a;
+}
+
+void require_close(const lambda::dynamic_matrix &a,
+                   const lambda::dynamic_matrix &b, double margin = 1E-9)
+{
+    REQUIRE( a.rows() == b.rows() );
+    REQUIRE( a.columns() == b.columns() );
+    for (size_t i = 0; i < a.data().size(); ++i)
+    {
+        REQUIRE( a[i] == Approx(b[i]).margin(margin) );
+    }
+}
+
+lambda::dynamic_matrix identity(size_t N)
+{
+    lambda::dynamic_matrix I(N, N);
+    for (size_t i = 0; i < N; ++i) I(i, i) = 1;
+    return I;
+}
+
+} // namespace
+
+TEST_CASE("Dynamic LU factorization.", "[dynamic-factorization]")
+{
+    const lambda::dynamic_matrix small(3, 3, { 2, 1, 1,
+                                               4, 3, 3,
+                                               8, 7, 9 });
+    const lambda::dynamic_lu f(small);
+    REQUIRE( f.det() == Approx(4) );
+    REQUIRE( lambda::det(small) == Approx(4) );
+    REQUIRE( f.permutation()[0] == 2 );
+    require_close(small*f.inverse(), identity(3));
+
+    lambda::arena scratch;
+    {
+        lambda::scoped_resource scope(&scratch);
+        REQUIRE( lambda::dynamic_lu(small).permutation().get_allocator()
+                 .resource() == &scratch );
+    }
+
+    // Sizes which leave partial panels, and span several of them.
+    for (size_t N : { 1, 63, 64, 150, 200 })
+    {
+        const auto A = pattern(N, N, 37), B = pattern(N, 5, 71);
+        const lambda::dynamic_lu lu(A);
+        REQUIRE_FALSE( lu.singular() );
+        require_close(A*lu.solve(B), B);
+        require_close(A*lambda::inverse(A), identity(N));
+    }
+
+    const lambda::dynamic_matrix singular(3, 3, { 1, 2, 3,
+                                                  2, 4, 6,
+                                                  1, 0, 1 });
+    const lambda::dynamic_lu s(singular);
+    REQUIRE( s.singular() );
+    REQUIRE( s.det() == 0 );
+    REQUIRE_THROWS_AS(s.solve(pattern(3, 1, 1)), std::domain_error);
+    REQUIRE_THROWS_AS(lambda::dynamic_lu(pattern(3, 2, 1)),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(f.solve(pattern(2, 1, 1)), std::invalid_argument);
+}
+
+TEST_CASE("Dynamic Cholesky and QR factorizations.",
+          "[dynamic-factorization]")
+{
+    for (size_t N : { 1, 64, 150, 300 })
+    {
+        const auto A = spd(N, 53), B = pattern(N, 3, 29);
+        const lambda::dynamic_cholesky chol(A);
+        require_close(A*chol.solve(B), B);
+        require_close(A*chol.inverse(), identity(N));
+        const auto L = chol.lower();
+        REQUIRE( L(0, N - 1) == (N == 1 ? L(0, 0) : 0) );
+        REQUIRE( chol.det() == Approx(lambda::det(A)).epsilon(1E-9) );
+    }
+    REQUIRE_THROWS_AS(lambda::dynamic_cholesky(
+        lambda::dynamic_matrix(2, 2, { 1, 2, 2, 1 })), std::domain_error);
+
+    for (size_t N : { 1, 40, 64, 130 })
+    {
+        // A tall system, solved in the least squares sense: the residual
+        // is orthogonal to the columns of A.
+        const size_t M = N + 37;
+        const auto A = pattern(M, N, 61), B = pattern(M, 2, 43);
+        const lambda::dynamic_qr qr(A);
+        const auto X = qr.solve(B);
+        const auto residual = A*X - B;
+        for (size_t j = 0; j < N; ++j)
+        {
+            for (size_t c = 0; c < 2; ++c)
+            {
+                double dot = 0;
+                for (size_t i = 0; i < M; ++i) dot += A(i, j)*residual(i, c);
+                REQUIRE( dot == Approx(0).margin(1E-9) );
+            }
+        }
+
+        const auto Q = qr.q(), R = qr.r();
+        require_close(Q*R, A);
+        for (size_t i = 0; i < N; ++i)
+        {
+            for (size_t j = 0; j < N; ++j)
+            {
+                double dot = 0;
+                for (size_t r = 0; r < M; ++r) dot += Q(r, i)*Q(r, j);
+                REQUIRE( dot == Approx(i == j ? 1 : 0).margin(1E-12) );
+            }
+        }
+
+        const auto S = pattern(N, N, 83);
+        const lambda::dynamic_qr square(S);
+        REQUIRE( square.det() == Approx(lambda::det(S)).epsilon(1E-9) );
+        require_close(S*square.inverse(), identity(N));
+    }
+    REQUIRE_THROWS_AS(lambda::dynamic_qr(pattern(2, 3, 1)),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(lambda::dynamic_qr(pattern(3, 2, 1)).det(),
+                      std::invalid_argument);
+}
@@ -54,6 +54,44 @@ TEST_CASE("Dynamic matrix arithmetic.", "[dynamic-matrix]")
     REQUIRE( m == lambda::dynamic_matrix(3, 1, {3, 2, 1}) );
 }
 
+TEST_CASE("Dynamic matrix moves and in-place arithmetic.", "[dynamic-matrix]")
+{
+    const lambda::dynamic_matrix a(2, 2, {1, 2, 3, 4});
+    const lambda::dynamic_matrix b(2, 2, {5, 6, 7, 8});
+
+    lambda::dynamic_matrix m = a;
+    const double *storage = m.data().data();
+    lambda::dynamic_matrix n = std::move(m);
+    REQUIRE( n.data().data() == storage );
+    REQUIRE( m.rows() == 0 );
+    REQUIRE( m.columns() == 0 );
+    REQUIRE( m.data().empty() );
+
+    // Each expiring operand's storage is passed along to the result.
+    n = std::move(n) + b;
+    REQUIRE( n.data().data() == storage );
+    n = a - std::move(n);
+    REQUIRE( n.data().data() == storage );
+    n = 2*std::move(n) - b*3 + a/2;
+    REQUIRE( n.data().data() == storage );
+    REQUIRE( n == lambda::dynamic_matrix(2, 2, {-24.5, -29, -33.5, -38}) );
+
+    n += a;
+    n -= b;
+    n *= -2;
+    n /= 4;
+    REQUIRE( n.data().data() == storage );
+    REQUIRE( n == lambda::dynamic_matrix(2, 2, {14.25, 16.5, 18.75, 21}) );
+
+    n *= lambda::dynamic_matrix(2, 1, {2, -1});
+    REQUIRE( n == lambda::dynamic_matrix(2, 1, {12, 16.5}) );
+
+    REQUIRE_THROWS_WITH( n += a,
+        "Cannot add matrices of dimensions 2x1 and 2x2");
+    REQUIRE_THROWS_WITH( a - std::move(n),
+        "Cannot subtract matrices of dimensions 2x2 and 2x1");
+}
+
 TEST_CASE("Throw dynamic matrix out of bounds exception.", "[dynamic-matrix]")
 {
     lambda::dynamic_matrix m(3, 4);
@@ -0,0 +1,82 @@
+#include <catch2/catch.hpp>
+#include <lambda/lambda.hpp>
+
+#include <cmath>
+#include <vector>
+
+#include "test_matrices.hpp"
+
+namespace
+{
+
+void require_near(const lambda::dynamic_matrix &actual,
+                  const lambda::dynamic_matrix &expected)
+{
+    REQUIRE( actual.rows() == expected.rows() );
+    REQUIRE( actual.columns() == expected.columns() );
+    for (size_t i = 0; i < actual.rows()*actual.columns(); ++i)
+    {
+        REQUIRE( actual[i] == Approx(expected[i]).margin(1e-10) );
+    }
+}
+
+} // namespace
+
+TEST_CASE("Blocked matrix multiplication.", "[gemm]")
+{
+    // Sizes on either side of the register tile, the small product
+    // cutoff and each cache block.
+    const size_t sizes[][3] = { { 1, 1, 1 }, { 3, 5, 2 }, { 6, 8, 4 },
+        { 7, 9, 31 }, { 25, 24, 23 }, { 145, 17, 40 }, { 13, 300, 257 },
+        { 50, 2100, 3 }, { 150, 61, 520 } };
+    for (const auto &size : sizes)
+    {
+        const auto a = pattern(size[0], size[2], 0.7);
+        const auto b = pattern(size[2], size[1], 1.3);
+        require_near(a*b, naive(a, b));
+
+        auto c = pattern(size[0], size[1], 2.1);
+        const auto expected = naive(a, b)*-0.5 + c*3;
+        lambda::gemm(-0.5, a, b, 3, c);
+        require_near(c, expected);
+    }
+}
+
+TEST_CASE("General matrix multiply in place.", "[gemm]")
+{
+    const auto a = pattern(40, 40, 0.3);
+    auto b = pattern(40, 40, 0.9);
+
+    // beta = 0 ignores the contents of C, even if not finite.
+    lambda::dynamic_matrix c(40, 40, std::vector<double>(1600, NAN));
+    lambda::gemm(1, a, b, 0, c);
+    require_near(c, naive(a, b));
+
+    // C may be an operand.
+    const auto expected = naive(a, b)*2 + b;
+    lambda::gemm(2, a, b, 1, b);
+    require_near(b, expected);
+
+    // Leading dimensions select a block of a larger matrix.
+    const auto big = pattern(30, 30, 0.5);
+    std::vector<double> out(10*12, 0);
+    lambda::gemm(10, 10, 20, 1, big.data().data() + 31, 30,
+                 big.data().data() + 5*30 + 2, 30, 0, out.data(), 12);
+    for (size_t i = 0; i < 10; ++i)
+    {
+        for (size_t j = 0; j < 10; ++j)
+        {
+            double sum = 0;
+            for (size_t k = 0; k < 20; ++k)
+            {
+                sum += big(1 + i, 1 + k)*big(5 + k, 2 + j);
+            }
+            REQUIRE( out[12*i + j] == Approx(sum).margin(1e-12) );
+        }
+    }
+
+    lambda::dynamic_matrix wrong(3, 3);
+    REQUIRE_THROWS_AS(lambda::gemm(1, a, b, 0, wrong), std::invalid_argument);
+    REQUIRE_THROWS_AS(lambda::gemm(1, a, wrong, 0, wrong),
+                      std::invalid_argument);
+}
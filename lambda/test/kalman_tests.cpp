@@ -5,3 +5,95 @@ TEST_CASE("Kalman test.", "[basic kalman]")
 {
     lambda::kf<5, 3> kf;
 }
+
+TEST_CASE("Kalman filter prediction.", "[basic kalman]")
+{
+    lambda::matrix<2, 2> F(1, 0.5,
+                           0, 1);
+
+    lambda::kf<1, 2> kf(
+        lambda::column_vector<2>(2, 3),
+        lambda::identity<2, 2>(),
+        F,
+        lambda::row_vector<2>(1, 0),
+        lambda::matrix<1, 1>(0.1),
+        lambda::identity<2, 2>() * 0.01);
+
+    auto state = kf.predict();
+
+    REQUIRE( state(0, 0) == Approx(3.5) );
+    REQUIRE( state(1, 0) == Approx(3) );
+
+    lambda::matrix<2, 2> expected = F * lambda::transpose(F);
+    expected(0, 0) += 0.01;
+    expected(1, 1) += 0.01;
+    for (size_t i = 0; i < 4; ++i)
+    {
+        REQUIRE( kf.state_covariance[i] == Approx(expected[i]) );
+    }
+}
+
+TEST_CASE("Kalman filter measurement update.", "[basic kalman]")
+{
+    lambda::kf<1, 2> kf(
+        lambda::column_vector<2>(2, 3),
+        lambda::identity<2, 2>(),
+        lambda::identity<2, 2>(),
+        lambda::row_vector<2>(1, 0),
+        lambda::matrix<1, 1>(0.1),
+        lambda::identity<2, 2>() * 0.01);
+
+    // S = 1.1, so the gain is K = [1/1.1, 0]^T.
+    auto state = kf.update(lambda::column_vector<1>(2.5));
+
+    REQUIRE( state(0, 0) == Approx(2 + 0.5/1.1) );
+    REQUIRE( state(1, 0) == Approx(3) );
+    REQUIRE( kf.state_covariance(0, 0) == Approx(0.1/1.1) );
+    REQUIRE( kf.state_covariance(0, 1) == Approx(0).margin(1e-15) );
+    REQUIRE( kf.state_covariance(1, 1) == Approx(1) );
+}
+
+TEST_CASE("Kalman filter in single precision.", "[basic kalman]")
+{
+    lambda::kf<1, 2, float> kf(
+        lambda::column_vector<2, float>(2, 3),
+        lambda::identity<2, 2, float>(),
+        lambda::matrix<2, 2, float>(1, 0.5, 0, 1),
+        lambda::row_vector<2, float>(1, 0),
+        lambda::matrix<1, 1, float>(0.1),
+        lambda::identity<2, 2, float>() * 0.01f);
+
+    const lambda::column_vector<2, float> &state = kf.predict();
+
+    REQUIRE( state(0, 0) == Approx(3.5f) );
+    REQUIRE( state(1, 0) == Approx(3.0f) );
+}
+
+TEST_CASE("Kalman filter discretized over varying timesteps.", "[basic kalman]")
+{
+    // Constant acceleration model, x = [position, velocity, acceleration]
+    lambda::matrix<3, 3> A(0, 1, 0,
+                           0, 0, 1,
+                           0, 0, 0);
+
+    lambda::kf<1, 3> kf(
+        lambda::column_vector<3>(0, 1, 2),
+        lambda::identity<3, 3>(),
+        lambda::identity<3, 3>(),
+        lambda::row_vector<3>(1, 0, 0),
+        lambda::matrix<1, 1>(0.1),
+        lambda::identity<3, 3>() * 0.01);
+
+    double t = 0;
+    for (double dt : { 0.1, 0.25, 0.05, 0.6 })
+    {
+        kf.discretize(A, dt);
+        REQUIRE( kf.state_transition(0, 2) == Approx(dt*dt/2) );
+        kf.predict();
+        t += dt;
+    }
+
+    REQUIRE( kf.state(0, 0) == Approx(t + t*t) );
+    REQUIRE( kf.state(1, 0) == Approx(1 + 2*t) );
+    REQUIRE( kf.state(2, 0) == Approx(2) );
+}
@@ -0,0 +1,135 @@
+#include <catch2/catch.hpp>
+#include <lambda/lambda.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+#include "test_matrices.hpp"
+
+namespace
+{
+
+/// \brief A file path which is removed when it goes out of scope.
+struct temporary_file
+{
+    std::string path;
+
+    explicit temporary_file(const std::string &name)
+        : path("/tmp/lambda_" + name + "_" + std::to_string(::getpid())) { }
+
+    ~temporary_file()
+    {
+        std::remove(path.c_str());
+    }
+};
+
+void save(const std::string &path, const lambda::dynamic_matrix &m)
+{
+    std::ofstream out(path, std::ios::binary);
+    lambda::write(out, m);
+}
+
+} // namespace
+
+TEST_CASE("Mapping matrix files.", "[mapped-matrix]")
+{
+    const temporary_file file("map");
+    const auto m = pattern(30, 20, 0.3);
+    save(file.path, m);
+
+    {
+        const lambda::mapped_matrix mapped(file.path);
+        REQUIRE( mapped.rows() == 30 );
+        REQUIRE( mapped.columns() == 20 );
+        REQUIRE( mapped.mode() == lambda::map_mode::read_only );
+        for (size_t i = 0; i < 600; ++i) REQUIRE( mapped[i] == m[i] );
+        REQUIRE( mapped(29, 19) == m(29, 19) );
+        REQUIRE( mapped.block(2, 3, 4, 5) == [&] ()
+        {
+            lambda::dynamic_matrix b(4, 5);
+            for (size_t i = 0; i < 20; ++i) b[i] = m(2 + i / 5, 3 + i % 5);
+            return b;
+        }() );
+        REQUIRE_THROWS_AS(mapped.at(30, 0), std::out_of_range);
+        REQUIRE_THROWS_AS(mapped.block(28, 0, 3, 1), std::out_of_range);
+    }
+
+    // Changes to a copy-on-write map are not written to the file.
+    {
+        lambda::mapped_matrix mapped(file.path, lambda::map_mode::copy_on_write);
+        mapped(0, 0) = 42;
+        REQUIRE( mapped.at(0) == 42 );
+        lambda::mapped_matrix other(file.path);
+        REQUIRE( other(0, 0) == m(0, 0) );
+
+        lambda::mapped_matrix moved = std::move(mapped);
+        REQUIRE( moved(0, 0) == 42 );
+        REQUIRE( mapped.rows() == 0 );
+        REQUIRE_THROWS_AS(other.at(0, 0) = 1, std::invalid_argument);
+    }
+
+    // Changes to a read-write map are.
+    {
+        lambda::mapped_matrix mapped(file.path, lambda::map_mode::read_write);
+        mapped.at(1, 2) = -7;
+        mapped.flush();
+    }
+    std::ifstream in(file.path, std::ios::binary);
+    lambda::dynamic_matrix read(1, 1);
+    lambda::read(in, read);
+    REQUIRE( read(1, 2) == -7 );
+    REQUIRE( read(0, 0) == m(0, 0) );
+
+    REQUIRE_THROWS_AS(lambda::mapped_matrix("/nonexistent/matrix"),
+                      std::runtime_error);
+    const temporary_file bad("bad");
+    std::ofstream(bad.path) << "not a matrix, but long enough to have a header";
+    REQUIRE_THROWS_AS(lambda::mapped_matrix(bad.path), std::invalid_argument);
+    {
+        std::ofstream out(bad.path, std::ios::binary);
+        lambda::write_header(out, { 100, 100 });
+    }
+    REQUIRE_THROWS_AS(lambda::mapped_matrix(bad.path), std::runtime_error);
+}
+
+TEST_CASE("Blocked operations on mapped matrices.", "[mapped-matrix]")
+{
+    const temporary_file a_file("a"), b_file("b"), c_file("c"), t_file("t");
+    const auto a = pattern(150, 70, 0.7), b = pattern(70, 130, 1.1);
+    save(a_file.path, a);
+    save(b_file.path, b);
+
+    const lambda::mapped_matrix A(a_file.path), B(b_file.path);
+    lambda::mapped_matrix C = lambda::mapped_matrix::create(c_file.path,
+                                                            150, 130);
+    lambda::multiply(A, B, C);
+    const auto expected = a*b;
+    for (size_t i = 0; i < 150*130; ++i) REQUIRE( C[i] == expected[i] );
+    REQUIRE( A*B == expected );
+
+    lambda::mapped_matrix T = lambda::mapped_matrix::create(t_file.path,
+                                                            70, 150);
+    lambda::transpose(A, T);
+    for (size_t i = 0; i < 150; ++i)
+    {
+        for (size_t j = 0; j < 70; ++j) REQUIRE( T(j, i) == a(i, j) );
+    }
+
+    REQUIRE_THROWS_AS(lambda::multiply(A, A, C), std::invalid_argument);
+    lambda::mapped_matrix readonly(t_file.path);
+    REQUIRE_THROWS_AS(lambda::transpose(A, readonly), std::invalid_argument);
+
+    lambda::mapped_matrix S = lambda::mapped_matrix::create(c_file.path,
+                                                            70, 70);
+    REQUIRE_THROWS_AS(lambda::multiply(S, S, S), std::invalid_argument);
+    REQUIRE_THROWS_AS(lambda::transpose(S, S), std::invalid_argument);
+
+    const lambda::mapped_matrix same(c_file.path);
+    REQUIRE( S.shares_file(same) );
+    REQUIRE_FALSE( S.shares_file(A) );
+    REQUIRE_THROWS_AS(lambda::multiply(same, same, S), std::invalid_argument);
+    REQUIRE_THROWS_AS(lambda::transpose(same, S), std::invalid_argument);
+}
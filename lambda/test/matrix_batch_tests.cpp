@@ -0,0 +1,133 @@
+#include <catch2/catch.hpp>
+#include <lambda/lambda.hpp>
+
+#include <cstdint>
+
+namespace
+{
+
+template <size_t M, size_t N>
+lambda::matrix<M, N> numbered(size_t k)
+{
+    lambda::matrix<M, N> m;
+    for (size_t p = 0; p < M*N; ++p)
+    {
+        m[p] = 0.5*k - 0.25*p + (k*p % 7);
+    }
+    return m;
+}
+
+template <size_t M, size_t N>
+void require_matrix(const lambda::matrix<M, N> &actual,
+                    const lambda::matrix<M, N> &expected)
+{
+    for (size_t p = 0; p < M*N; ++p)
+    {
+        REQUIRE( actual[p] == Approx(expected[p]) );
+    }
+}
+
+} // namespace
+
+TEST_CASE("Matrix batch layout.", "[matrix-batch]")
+{
+    lambda::matrix_batch<3, 3> batch(21);
+    REQUIRE( batch.size() == 21 );
+    REQUIRE( batch.stride() == 24 );
+
+    for (size_t p = 0; p < 9; ++p)
+    {
+        auto address = reinterpret_cast<std::uintptr_t>(batch.plane(p));
+        REQUIRE( address % 64 == 0 );
+    }
+
+    for (size_t k = 0; k < batch.size(); ++k)
+    {
+        batch.scatter(k, numbered<3, 3>(k));
+    }
+    REQUIRE( batch(5, 1, 2) == numbered<3, 3>(5)(1, 2) );
+    REQUIRE( batch.plane(1, 2)[5] == numbered<3, 3>(5)(1, 2) );
+    REQUIRE( batch.gather(20) == numbered<3, 3>(20) );
+
+    batch.resize(40);
+    REQUIRE( batch.gather(20) == numbered<3, 3>(20) );
+    REQUIRE( batch.gather(39) == lambda::matrix<3, 3>() );
+
+    REQUIRE_THROWS_AS(batch.gather(40), std::out_of_range);
+}
+
+TEST_CASE("Batched arithmetic.", "[matrix-batch]")
+{
+    const size_t K = 37;
+    std::vector<lambda::matrix<3, 3>> a, b;
+    std::vector<lambda::matrix<3, 2>> c;
+    for (size_t k = 0; k < K; ++k)
+    {
+        a.push_back(numbered<3, 3>(k));
+        b.push_back(numbered<3, 3>(2*k + 1));
+        c.push_back(numbered<3, 2>(k + 3));
+    }
+    lambda::matrix_batch<3, 3> A(a), B(b);
+    lambda::matrix_batch<3, 2> C(c);
+    const lambda::matrix<3, 3> R(0, -1, 0,
+                                 1,  0, 0,
+                                 0,  0, 1);
+
+    auto sum = A + B;
+    auto difference = A - B;
+    auto product = A * B;
+    auto rectangular = A * C;
+    auto rotated = R * C;
+    auto flipped = transpose(C);
+    auto right = A * R;
+    for (size_t k = 0; k < K; ++k)
+    {
+        require_matrix(sum.gather(k), lambda::matrix<3, 3>(a[k] + b[k]));
+        require_matrix(difference.gather(k),
+                       lambda::matrix<3, 3>(a[k] - b[k]));
+        require_matrix(product.gather(k), lambda::matrix<3, 3>(a[k] * b[k]));
+        require_matrix(rectangular.gather(k),
+                       lambda::matrix<3, 2>(a[k] * c[k]));
+        require_matrix(rotated.gather(k), lambda::matrix<3, 2>(R * c[k]));
+        require_matrix(flipped.gather(k),
+                       lambda::matrix<2, 3>(transpose(c[k])));
+        require_matrix(right.gather(k), lambda::matrix<3, 3>(a[k] * R));
+    }
+
+    lambda::matrix_batch<3, 3> short_batch(K - 1);
+    REQUIRE_THROWS_AS(A + short_batch, std::invalid_argument);
+    REQUIRE_THROWS_AS(A * short_batch, std::invalid_argument);
+}
+
+TEST_CASE("Batched vector operations.", "[matrix-batch]")
+{
+    const size_t K = 70;
+    std::vector<lambda::column_vector<3>> u, v;
+    for (size_t k = 0; k < K; ++k)
+    {
+        u.push_back(numbered<3, 1>(k) + lambda::unitx);
+        v.push_back(numbered<3, 1>(3*k + 2) + lambda::unitz);
+    }
+    lambda::vector_batch<3> U(u), V(v);
+
+    auto dot = inner_product(U, V);
+    auto cross = cross_product(U, V);
+    auto unit = normalize(U);
+    for (size_t k = 0; k < K; ++k)
+    {
+        REQUIRE( dot(k, 0, 0) == Approx(lambda::inner_product(u[k], v[k])) );
+        require_matrix(cross.gather(k), lambda::cross_product(u[k], v[k]));
+        require_matrix(unit.gather(k), lambda::normalize(u[k]));
+    }
+    REQUIRE( unit.stride() > K );
+    for (size_t i = 0; i < 3; ++i)
+    {
+        for (size_t k = K; k < unit.stride(); ++k)
+        {
+            REQUIRE( unit.plane(i)[k] == 0 );
+        }
+    }
+
+    U.scatter(12, lambda::column_vector<3>());
+    REQUIRE_THROWS_AS(normalize(U), std::domain_error);
+}
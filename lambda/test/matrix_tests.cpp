@@ -112,6 +112,171 @@ TEST_CASE("Inverse of non-invertible matrix.", "[matrix_inverse]")
     REQUIRE_THROWS_WITH(lambda::inverse(m2), Contains("Cannot invert matrix"));
 }
 
+TEST_CASE("Closed-form inverses of 3x3 and 4x4 matrices.", "[matrix_inverse]")
+{
+    const lambda::matrix<3, 3> A(2, -1,  0,
+                                 1,  3, -2,
+                                 0,  5,  4);
+    const auto A_inv = lambda::inverse(A);
+    const lambda::matrix<3, 3> I3 = A*A_inv;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        for (size_t j = 0; j < 3; ++j)
+        {
+            REQUIRE( I3(i, j) == Approx(i == j ? 1 : 0).margin(1e-12) );
+        }
+    }
+
+    const lambda::matrix<4, 4> B(4, -2,  1, 0,
+                                 3,  6, -4, 2,
+                                 2,  1,  8, 1,
+                                -1,  0,  3, 5);
+    double d = 0;
+    const auto B_lu = lambda::inverse(B, d);
+    const auto B_inv = lambda::inverse(B);
+    for (size_t i = 0; i < 16; ++i)
+    {
+        REQUIRE( B_inv[i] == Approx(B_lu[i]) );
+    }
+    REQUIRE( lambda::det(B) == Approx(d) );
+}
+
+TEST_CASE("Determinants of larger matrices.", "[matrix]")
+{
+    // det(I + u v^T) = 1 + v.u
+    lambda::matrix<12, 12> A = lambda::identity<12, 12>();
+    double dot = 1;
+    for (size_t i = 0; i < 12; ++i)
+    {
+        for (size_t j = 0; j < 12; ++j)
+        {
+            A(i, j) += 0.1*(i + 1) * 0.2*(12 - j);
+        }
+        dot += 0.1*(i + 1) * 0.2*(12 - i);
+    }
+    REQUIRE( lambda::det(A) == Approx(dot) );
+
+    // Needs a row exchange to avoid a zero pivot.
+    lambda::matrix<4, 4> B(0, 2, 1, 3,
+                           1, 0, 2, 1,
+                           3, 1, 0, 2,
+                           2, 3, 1, 0);
+    lambda::matrix<5, 5> C = lambda::identity<5, 5>();
+    for (size_t i = 0; i < 4; ++i)
+    {
+        for (size_t j = 0; j < 4; ++j)
+        {
+            C(i + 1, j + 1) = B(i, j);
+        }
+    }
+    REQUIRE( lambda::det(B) == Approx(-62) );
+    REQUIRE( lambda::det(C) == Approx(-62) );
+
+    lambda::matrix<5, 5> D = C;
+    for (size_t j = 0; j < 5; ++j)
+    {
+        D(4, j) = D(1, j) + 2*D(2, j);
+    }
+    REQUIRE( lambda::det(D) == Approx(0).margin(1e-12) );
+}
+
+TEST_CASE("Inverse and determinant from one factorization.", "[matrix_inverse]")
+{
+    lambda::matrix<3, 3> A(2, 0, 1,
+                           1, 3, 2,
+                           1, 1, 2);
+    double d = 0;
+    auto inv = lambda::inverse(A, d);
+    REQUIRE( d == Approx(6) );
+    lambda::matrix<3, 3> I = A * inv;
+    for (size_t i = 0; i < 9; ++i)
+    {
+        REQUIRE( I[i] == Approx(lambda::identity<3, 3>()[i]).margin(1e-12) );
+    }
+
+    lambda::matrix<2, 2> B(4, 7, 2, 6);
+    lambda::matrix<2, 2> ref(0.6, -0.7, -0.2, 0.4);
+    auto binv = lambda::inverse(B);
+    for (size_t i = 0; i < 4; ++i)
+    {
+        REQUIRE( binv[i] == Approx(ref[i]) );
+    }
+}
+
+TEST_CASE("Matrix inverse in place, with pivoting", "[matrix_inverse]")
+{
+    using Catch::Matchers::Contains;
+
+    // Without row exchanges, the tiny pivot swamps the other elements.
+    lambda::matrix<2, 2> A(1e-20, 1,
+                           1,     1);
+    lambda::invert(A);
+    REQUIRE( A(0, 0) == Approx(-1) );
+    REQUIRE( A(0, 1) == Approx(1) );
+    REQUIRE( A(1, 0) == Approx(1) );
+    REQUIRE( A(1, 1) == Approx(0).margin(1e-12) );
+
+    lambda::matrix<4, 4> B(0, 2, 1, 3,
+                           1, 0, 2, 1,
+                           3, 1, 0, 2,
+                           2, 3, 1, 0);
+    lambda::matrix<4, 4> inv = B;
+    lambda::invert(inv);
+    lambda::matrix<4, 4> I = B * inv;
+    for (size_t i = 0; i < 16; ++i)
+    {
+        REQUIRE( I[i] == Approx(lambda::identity<4, 4>()[i]).margin(1e-12) );
+    }
+
+    lambda::matrix<3, 3> C(1, 2, 3, 4, 5, 6, 1, 2, 3);
+    REQUIRE_THROWS_WITH(lambda::invert(C), Contains("singular"));
+}
+
+TEST_CASE("Solve linear systems without inverting.", "[matrix_inverse]")
+{
+    using Catch::Matchers::Contains;
+
+    lambda::matrix<3, 3> A(0, 2, 1,
+                           1, 1, 1,
+                           2, 1, 3);
+    lambda::column_vector<3> x(1, -2, 3);
+    lambda::column_vector<3> b = A * x;
+    auto solved = lambda::solve(A, b);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        REQUIRE( solved[i] == Approx(x[i]) );
+    }
+
+    lambda::matrix<3, 2> X(1, 4,
+                           2, 5,
+                           3, 6);
+    lambda::matrix<3, 2> B = A * X;
+    auto many = lambda::solve(A, B);
+    for (size_t i = 0; i < 6; ++i)
+    {
+        REQUIRE( many[i] == Approx(X[i]) );
+    }
+
+    lambda::matrix<2, 2> S(1, 2, 2, 4);
+    REQUIRE_THROWS_WITH(lambda::solve(S, lambda::column_vector<2>(1, 1)),
+                        Contains("singular"));
+}
+
+TEST_CASE("Reduced row echelon form exchanges rows.", "[matrix]")
+{
+    lambda::matrix<2, 3> A(0, 1, 2,
+                           1, 0, 3);
+    REQUIRE( lambda::rref(A) == lambda::matrix<2, 3>(1, 0, 3,
+                                                     0, 1, 2) );
+
+    lambda::matrix<3, 3> B(0, 1, 1,
+                           0, 2, 2,
+                           0, 0, 3);
+    REQUIRE( lambda::rref(B) == lambda::matrix<3, 3>(0, 1, 0,
+                                                     0, 0, 1,
+                                                     0, 0, 0) );
+}
+
 TEST_CASE("Matrix power calculation.", "[matrix]")
 {
     lambda::matrix<3, 3> m(3.4,  2.1, -5.0,
@@ -164,6 +329,65 @@ TEST_CASE("Matrix power calculation.", "[matrix]")
     REQUIRE(m5(2, 2) == Approx(-2406.84));
 }
 
+TEST_CASE("Matrix power by squaring.", "[matrix]")
+{
+    lambda::matrix<4, 4> shift(0, 1, 0, 0,
+                               0, 0, 1, 0,
+                               0, 0, 0, 1,
+                               1, 0, 0, 0);
+    REQUIRE( lambda::pow(shift, 4) == lambda::identity<4, 4>() );
+    REQUIRE( lambda::pow(shift, 1001) == shift );
+    REQUIRE( lambda::pow(shift, 6) == shift * shift );
+
+    lambda::matrix<2, 2> fibonacci(1, 1, 1, 0);
+    auto f = lambda::pow(fibonacci, 40);
+    REQUIRE( f(0, 1) == 102334155 );
+    REQUIRE( f(0, 0) == 165580141 );
+}
+
+TEST_CASE("Matrix exponential.", "[matrix]")
+{
+    REQUIRE( lambda::expm(lambda::matrix<3, 3>()) ==
+             lambda::identity<3, 3>() );
+
+    // Constant velocity model; exp(A dt) is exactly I + A dt.
+    lambda::matrix<2, 2> A(0, 1,
+                           0, 0);
+    auto F = lambda::expm(lambda::matrix<2, 2>(A * 0.25));
+    REQUIRE( F(0, 0) == Approx(1) );
+    REQUIRE( F(0, 1) == Approx(0.25) );
+    REQUIRE( F(1, 0) == Approx(0).margin(1e-15) );
+    REQUIRE( F(1, 1) == Approx(1) );
+
+    // The exponential of a skew-symmetric matrix is a rotation.
+    for (double angle : { 1e-4, 0.1, 1.0, 3.0, 20.0 })
+    {
+        lambda::column_vector<3> axis(0, 0, angle);
+        auto R = lambda::expm(lambda::skew_symmetric(axis));
+        REQUIRE( R(0, 0) == Approx(std::cos(angle)) );
+        REQUIRE( R(0, 1) == Approx(-std::sin(angle)) );
+        REQUIRE( R(1, 0) == Approx(std::sin(angle)) );
+        REQUIRE( R(1, 1) == Approx(std::cos(angle)) );
+        REQUIRE( R(2, 2) == Approx(1) );
+    }
+
+    // Moler and Van Loan's example, which needs scaling and squaring.
+    lambda::matrix<2, 2> B(-49, 24,
+                           -64, 31);
+    lambda::matrix<2, 2> ref(-0.735758758144742, 0.551819099658089,
+                             -1.471517599088239, 1.103638240715556);
+    auto E = lambda::expm(B);
+    for (size_t i = 0; i < 4; ++i)
+    {
+        REQUIRE( E[i] == Approx(ref[i]).epsilon(1e-10) );
+    }
+
+    B(0, 1) = INFINITY;
+    REQUIRE_THROWS_AS(lambda::expm(B), std::domain_error);
+    B(0, 1) = NAN;
+    REQUIRE_THROWS_AS(lambda::expm(B), std::domain_error);
+}
+
 TEST_CASE("Test skew-symmetric matrix.", "[matrix]")
 {
     lambda::vector<3> vec(4, 5, -2);
@@ -176,3 +400,196 @@ TEST_CASE("Test skew-symmetric matrix.", "[matrix]")
     REQUIRE( skew == expected );
 }
 
+
+TEST_CASE("Matrix expressions evaluate on assignment.", "[matrix]")
+{
+    lambda::matrix<2, 3> A(1, 2, 3,
+                           4, 5, 6);
+    lambda::matrix<3, 2> B(7,  8,
+                           9,  10,
+                           11, 12);
+    lambda::matrix<2, 2> Q(1, 0,
+                           0, 1);
+
+    lambda::matrix<2, 2> C = A * B + Q;
+    REQUIRE( C == lambda::matrix<2, 2>(59, 64, 139, 155) );
+
+    lambda::matrix<3, 3> D = lambda::transpose(A) * A - 2 * B * A;
+    REQUIRE( D == lambda::matrix<3, 3>(-61,  -86, -111,
+                                       -76, -107, -138,
+                                       -91, -128, -165) );
+
+    lambda::matrix<2, 2> E = -(A * B) / 2;
+    REQUIRE( E == lambda::matrix<2, 2>(-29, -32, -69.5, -77) );
+
+    lambda::matrix<2, 2> F = A * lambda::transpose(lambda::transpose(B));
+    REQUIRE( F == lambda::matrix<2, 2>(58, 64, 139, 154) );
+}
+
+TEST_CASE("Matrix expressions which alias their destination.", "[matrix]")
+{
+    lambda::matrix<2, 2> A(1, 2,
+                           3, 4);
+
+    A = A * A;
+    REQUIRE( A == lambda::matrix<2, 2>(7, 10, 15, 22) );
+
+    A = lambda::transpose(A);
+    REQUIRE( A == lambda::matrix<2, 2>(7, 15, 10, 22) );
+
+    A += lambda::transpose(A);
+    REQUIRE( A == lambda::matrix<2, 2>(14, 25, 25, 44) );
+
+    A -= A * lambda::identity<2, 2>();
+    REQUIRE( A == lambda::matrix<2, 2>() );
+
+    lambda::column_vector<2> x(1, 1);
+    lambda::matrix<2, 2> F(1, 1,
+                           0, 1);
+    x = F * x;
+    x = F * x;
+    REQUIRE( x == lambda::column_vector<2>(3, 1) );
+}
+
+template <size_t M, size_t N, size_t P> void check_multiply_kernel()
+{
+    lambda::matrix<M, N> A;
+    lambda::matrix<N, P> B;
+    for (size_t i = 0; i < M*N; ++i) A[i] = 0.5*i - 3.0;
+    for (size_t i = 0; i < N*P; ++i) B[i] = 1.0 - 0.25*i;
+
+    lambda::matrix<M, P> C = A * B;
+
+    for (size_t i = 0; i < M; ++i)
+    {
+        for (size_t j = 0; j < P; ++j)
+        {
+            double expected = 0;
+            for (size_t k = 0; k < N; ++k)
+            {
+                expected += A(i, k) * B(k, j);
+            }
+            REQUIRE( C(i, j) == Approx(expected) );
+        }
+    }
+}
+
+TEST_CASE("Specialized multiplication kernels.", "[matrix]")
+{
+    check_multiply_kernel<3, 3, 3>();
+    check_multiply_kernel<4, 4, 4>();
+    check_multiply_kernel<6, 6, 6>();
+    check_multiply_kernel<9, 9, 9>();
+    check_multiply_kernel<3, 3, 1>();
+    check_multiply_kernel<4, 4, 1>();
+    check_multiply_kernel<6, 6, 1>();
+    check_multiply_kernel<9, 9, 1>();
+    check_multiply_kernel<5, 7, 2>();
+}
+
+namespace
+{
+
+// A mounting rotation and a calibration matrix, fixed at compile time.
+constexpr lambda::matrix<3, 3> mount(0, -1, 0,
+                                     1,  0, 0,
+                                     0,  0, 1);
+constexpr lambda::matrix<3, 3> calibration(2, 0, 0,
+                                           0, 3, 0,
+                                           1, 0, 4);
+constexpr lambda::matrix<3, 3> mounted = calibration * mount;
+constexpr lambda::column_vector<3> boresight = mount * lambda::unitx;
+
+static_assert(mounted(0, 1) == -2 && mounted(1, 0) == 3 &&
+              mounted(2, 1) == -1 && mounted(2, 2) == 4,
+              "Product of constant matrices");
+static_assert(boresight == lambda::unity, "Rotated basis vector");
+static_assert(lambda::transpose(mount) * mount ==
+              lambda::identity<3, 3>(), "Transpose of a rotation");
+static_assert(lambda::is_unitary(mount), "Rotation is unitary");
+static_assert(lambda::det(mount) == 1, "Determinant of a rotation");
+static_assert(lambda::det(calibration) == 24, "Determinant");
+static_assert(lambda::det(lambda::matrix<5, 5>(0, 0, 0, 0, 2,
+                                               0, 0, 0, 4, 0,
+                                               0, 0, 1, 0, 0,
+                                               0, 8, 0, 0, 0,
+                                               2, 0, 0, 0, 0)) == 128,
+              "Determinant by LU factorization");
+static_assert(lambda::trace(lambda::eval(calibration + 2*mount)) == 11,
+              "Trace");
+static_assert(lambda::cross_product(lambda::unitx, lambda::unity) ==
+              lambda::unitz, "Cross product of basis vectors");
+static_assert(lambda::augment(mount, lambda::unitz)(2, 3) == 1,
+              "Augmented matrix");
+static_assert(lambda::pow(mount, 4) == lambda::identity<3, 3>(),
+              "Power of a rotation");
+static_assert(lambda::inner_product(lambda::unitx, boresight) == 0,
+              "Inner product");
+
+}
+
+TEST_CASE("Matrices evaluated at compile time.", "[matrix]")
+{
+    REQUIRE( mounted == lambda::matrix<3, 3>(0, -2, 0,
+                                             3,  0, 0,
+                                             0, -1, 4) );
+    REQUIRE( boresight == lambda::unity );
+}
+
+TEST_CASE("Matrices of float and long double.", "[matrix]")
+{
+    lambda::matrix<2, 2, float> A(1, 2,
+                                  3, 4);
+    lambda::column_vector<2, float> x(1, -1);
+
+    static_assert(sizeof(A) == 4*sizeof(float), "Packed float storage");
+
+    lambda::column_vector<2, float> y = A * x * 2 + x;
+    REQUIRE( y == lambda::column_vector<2, float>(-1, -3) );
+    REQUIRE( lambda::det(A) == -2.0f );
+    REQUIRE( lambda::euclidean_norm(x) == Approx(std::sqrt(2.0f)) );
+
+    auto inv = lambda::inverse(lambda::matrix<3, 3, float>(
+        2, 0, 0, 0, 4, 0, 0, 0, 8));
+    REQUIRE( inv(0, 0) == 0.5f );
+    REQUIRE( inv(1, 1) == 0.25f );
+    REQUIRE( inv(2, 2) == 0.125f );
+
+    lambda::matrix<3, 3, long double> B(2, 0, 1,
+                                        1, 3, 0,
+                                        0, 1, 4);
+    REQUIRE( lambda::det(B) == 25.0L );
+    REQUIRE( lambda::trace(B) == 9.0L );
+}
+
+TEST_CASE("Matrices of complex numbers.", "[matrix]")
+{
+    using lambda::complex;
+
+    lambda::matrix<2, 2, complex> A(complex(1, 1), complex(0, 2),
+                                    complex(3, 0), complex(1, -1));
+    lambda::column_vector<2, complex> x(complex(0, 1), 1);
+
+    lambda::column_vector<2, complex> y = A * x;
+    REQUIRE( y == lambda::column_vector<2, complex>(
+        complex(-1, 3), complex(1, 2)) );
+
+    // (1+i)(1-i) - (2i)(3) = 2 - 6i
+    REQUIRE( lambda::det(A) == complex(2, -6) );
+    REQUIRE( lambda::euclidean_norm(x) == Approx(std::sqrt(2)) );
+    REQUIRE( lambda::inner_product(x, x) == complex(2, 0) );
+
+    lambda::matrix<3, 3, complex> B(complex(2, 0), 0, 0,
+                                    0, complex(0, 1), 0,
+                                    1, 0, 1);
+    auto inv = lambda::inverse(B);
+    lambda::matrix<3, 3, complex> I = B * inv;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        for (size_t j = 0; j < 3; ++j)
+        {
+            REQUIRE( I(i, j).real() == Approx(i == j ? 1 : 0) );
+            REQUIRE( I(i, j).imag() == Approx(0) );
+        }
+    }
+}
@@ -0,0 +1,127 @@
+#include <catch2/catch.hpp>
+#include <lambda/lambda.hpp>
+
+#include <cstdint>
+#include <memory_resource>
+
+namespace
+{
+
+/// \brief Counts the allocations passed on to another resource.
+class counting_resource : public std::pmr::memory_resource
+{
+    public:
+
+    size_t allocations = 0;
+
+    private:
+
+    std::pmr::memory_resource *_upstream = std::pmr::new_delete_resource();
+
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        ++allocations;
+        return _upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t alignment) override
+    {
+        _upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other)
+        const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+/// \brief Installs a default memory resource for its lifetime, so that
+/// a failed assertion does not leave a dangling one behind.
+class default_resource_guard
+{
+    public:
+
+    explicit default_resource_guard(std::pmr::memory_resource *resource) :
+        _previous(std::pmr::set_default_resource(resource)) { }
+
+    ~default_resource_guard()
+    {
+        std::pmr::set_default_resource(_previous);
+    }
+
+    default_resource_guard(const default_resource_guard&) = delete;
+    default_resource_guard& operator = (const default_resource_guard&) = delete;
+
+    private:
+
+    std::pmr::memory_resource *_previous;
+};
+
+} // namespace
+
+TEST_CASE("Arena allocation.", "[memory]")
+{
+    counting_resource upstream;
+    lambda::arena scratch(4096, &upstream);
+    REQUIRE( scratch.capacity() == 0 );
+
+    void *a = scratch.allocate(100, 8);
+    void *b = scratch.allocate(100, 64);
+    REQUIRE( reinterpret_cast<uintptr_t>(b) % 64 == 0 );
+    REQUIRE( static_cast<char*>(b) >= static_cast<char*>(a) + 100 );
+    void *c = scratch.allocate(5000, 8);
+    REQUIRE( upstream.allocations == 2 );
+    REQUIRE( scratch.used() >= 5200 );
+
+    // After a release, the same allocations reuse the same blocks.
+    scratch.release();
+    REQUIRE( scratch.used() == 0 );
+    REQUIRE( scratch.allocate(100, 8) == a );
+    REQUIRE( scratch.allocate(100, 64) == b );
+    REQUIRE( scratch.allocate(5000, 8) == c );
+    REQUIRE( upstream.allocations == 2 );
+}
+
+TEST_CASE("Dynamic matrices in a steady-state loop.", "[memory]")
+{
+    counting_resource heap, fallback;
+    const default_resource_guard guard(&fallback);
+
+    const lambda::dynamic_matrix A(40, 40, std::vector<double>(1600, 0.01),
+                                   &heap);
+    lambda::dynamic_matrix x(40, 1, std::vector<double>(40, 1), &heap);
+    REQUIRE( x.resource() == &heap );
+    const size_t setup = heap.allocations;
+
+    lambda::arena scratch(1024, &heap);
+    size_t warm = 0;
+    for (size_t step = 0; step < 10; ++step)
+    {
+        {
+            lambda::scoped_resource scope(&scratch);
+            REQUIRE( lambda::matrix_resource() == &scratch );
+            lambda::dynamic_matrix dx = A*x*0.5 - x/10;
+            REQUIRE( dx.resource() == &scratch );
+            dx += A*dx;
+            x = x + dx*lambda::frobenius_norm(dx);
+            REQUIRE( x.resource() == &heap );
+        }
+        scratch.release();
+        // Only the first step grows the arena.
+        if (step == 0)
+        {
+            REQUIRE( heap.allocations > setup );
+            warm = heap.allocations;
+        }
+        REQUIRE( heap.allocations == warm );
+        REQUIRE( lambda::matrix_resource() == &fallback );
+    }
+    {
+        lambda::scoped_resource scope(&scratch);
+        x = x + A*x;
+    }
+    scratch.release();
+    REQUIRE( heap.allocations == warm );
+    REQUIRE( fallback.allocations == 0 );
+}
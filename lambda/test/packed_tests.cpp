@@ -0,0 +1,116 @@
+#include <catch2/catch.hpp>
+#include <lambda/lambda.hpp>
+
+#include <utility>
+
+namespace
+{
+
+template <size_t M, size_t N>
+lambda::matrix<M, N> numbered(size_t k)
+{
+    lambda::matrix<M, N> m;
+    for (size_t p = 0; p < M*N; ++p)
+    {
+        m[p] = 0.5*k - 0.25*p + (k*p % 7);
+    }
+    return m;
+}
+
+template <size_t M, size_t N, class E>
+void require_matrix(const lambda::matrix_expression<E> &actual,
+                    const lambda::matrix<M, N> &expected)
+{
+    const lambda::matrix<M, N> dense(actual.self());
+    for (size_t p = 0; p < M*N; ++p)
+    {
+        REQUIRE( dense[p] == Approx(expected[p]) );
+    }
+}
+
+} // namespace
+
+TEST_CASE("Symmetric matrix storage.", "[packed]")
+{
+    static_assert(sizeof(lambda::symmetric_matrix<18>) == 171*sizeof(double),
+                  "Only the upper triangle is stored");
+
+    lambda::symmetric_matrix<3> s;
+    s(0, 2) = 4;
+    s(1, 0) = -1;
+    s(2, 2) = 7;
+    REQUIRE( s(2, 0) == 4 );
+    REQUIRE( s(0, 1) == -1 );
+    REQUIRE( s[8] == 7 );
+    REQUIRE( lambda::matrix<3, 3>(s) == lambda::matrix<3, 3>( 0, -1, 4,
+                                                             -1,  0, 0,
+                                                              4,  0, 7) );
+
+    // Conversion from a dense matrix keeps its symmetric part.
+    lambda::matrix<2, 2> a(1, 2,
+                           4, 3);
+    lambda::symmetric_matrix<2> sa(a);
+    REQUIRE( sa == lambda::matrix<2, 2>(1, 3,
+                                        3, 3) );
+    REQUIRE( lambda::symmetric_matrix<2>(sa + lambda::identity<2, 2>()) ==
+             lambda::matrix<2, 2>(2, 3,
+                                  3, 4) );
+
+    lambda::symmetric_matrix<2> sum = sa + sa*2.0;
+    REQUIRE( sum == 3.0*a*0.5 + 1.5*lambda::transpose(a) );
+    sum -= sa;
+    REQUIRE( sum == 2*sa );
+    REQUIRE( lambda::transpose(sum) == sum );
+}
+
+TEST_CASE("Symmetric products.", "[packed]")
+{
+    const lambda::matrix<18, 18> F =
+        lambda::identity<18, 18>() + numbered<18, 18>(3)*0.01;
+    lambda::matrix<18, 18> P = numbered<18, 18>(5);
+    P = P * lambda::transpose(P);
+    const lambda::symmetric_matrix<18> S(P);
+
+    const lambda::matrix<18, 18> expected = F * P * lambda::transpose(F);
+    require_matrix(lambda::symmetric_product(F, S), expected);
+    require_matrix(lambda::symmetric_product(F, S) + S,
+                   lambda::matrix<18, 18>(expected + P));
+
+    const lambda::matrix<2, 4> H = numbered<2, 4>(1);
+    const lambda::symmetric_matrix<4> R(numbered<4, 4>(2));
+    require_matrix(lambda::symmetric_product(H, R),
+        lambda::matrix<2, 2>(H * R * lambda::transpose(H)));
+}
+
+TEST_CASE("Triangular matrix storage.", "[packed]")
+{
+    const lambda::matrix<3, 3> a(1, 2, 3,
+                                 4, 5, 6,
+                                 7, 8, 9);
+    const lambda::lower_triangular<3> L(a);
+    const lambda::upper_triangular<3> U(a);
+
+    REQUIRE( L == lambda::matrix<3, 3>(1, 0, 0,
+                                       4, 5, 0,
+                                       7, 8, 9) );
+    REQUIRE( U == lambda::matrix<3, 3>(1, 2, 3,
+                                       0, 5, 6,
+                                       0, 0, 9) );
+    REQUIRE( lambda::transpose(L) == lambda::transpose(lambda::matrix<3, 3>(L)) );
+    REQUIRE( L + 2.0*L == 3*lambda::matrix<3, 3>(L) );
+
+    const lambda::matrix<3, 2> b = numbered<3, 2>(4);
+    REQUIRE( L * b == lambda::matrix<3, 3>(L) * b );
+    REQUIRE( U * b == lambda::matrix<3, 3>(U) * b );
+
+    require_matrix(lambda::symmetric_product(L),
+        lambda::matrix<3, 3>(L * lambda::transpose(L)));
+
+    lambda::lower_triangular<3> M(L);
+    M(2, 0) = -7;
+    REQUIRE( M(2, 0) == -7 );
+    REQUIRE( M(1, 1) == 5 );
+    REQUIRE_THROWS_AS(M(0, 2), std::out_of_range);
+    REQUIRE_THROWS_AS(M(0, 2) = 1, std::out_of_range);
+    REQUIRE( std::as_const(M)(0, 2) == 0 );
+}
@@ -0,0 +1,68 @@
+#include <catch2/catch.hpp>
+#include <lambda/lambda.hpp>
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "test_matrices.hpp"
+
+TEST_CASE("Splitting loops between threads.", "[parallel]")
+{
+    lambda::set_thread_count(3);
+    REQUIRE( lambda::thread_count() == 3 );
+
+    // Catch's assertions are not thread-safe, so the workers only count.
+    std::vector<std::atomic<int>> visits(1000);
+    std::atomic<int> ranges(0), misaligned(0);
+    lambda::detail::parallel_for(visits.size(), 64,
+        [&] (size_t begin, size_t end)
+    {
+        ++ranges;
+        if (begin % 64 != 0) ++misaligned;
+        for (size_t i = begin; i < end; ++i) ++visits[i];
+    });
+    REQUIRE( ranges == 3 );
+    REQUIRE( misaligned == 0 );
+    for (const auto &v : visits) REQUIRE( v == 1 );
+
+    lambda::set_thread_count(0);
+    REQUIRE( lambda::thread_count() ==
+             std::max(1u, std::thread::hardware_concurrency()) );
+}
+
+TEST_CASE("Results do not depend on the thread count.", "[parallel]")
+{
+    const auto a = pattern(200, 180, 0.7), b = pattern(180, 150, 1.1);
+    const auto wide = pattern(40, 300, 0.2), square = pattern(300, 300, 0.4);
+
+    auto compute = [&] (size_t threads)
+    {
+        lambda::set_thread_count(threads);
+        std::vector<lambda::dynamic_matrix> results = { a*b, wide*square,
+            square + square*2, square - 3*square };
+        auto c = square;
+        c *= 0.5;
+        c -= square;
+        results.push_back(c);
+        results.push_back(lambda::dynamic_matrix(1, 1,
+            { lambda::frobenius_norm(square) }));
+        return results;
+    };
+
+    const auto serial = compute(1);
+    for (size_t threads : { 2, 5, 16 })
+    {
+        const auto parallel = compute(threads);
+        for (size_t i = 0; i < serial.size(); ++i)
+        {
+            REQUIRE( parallel[i] == serial[i] );
+        }
+    }
+    lambda::set_thread_count(0);
+
+    double sum = 0;
+    for (double x : square.data()) sum += x*x;
+    REQUIRE( serial.back()[0] == Approx(std::sqrt(sum)) );
+}
@@ -0,0 +1,100 @@
+#include <catch2/catch.hpp>
+#include <lambda/lambda.hpp>
+
+#include <cmath>
+
+namespace
+{
+
+template <size_t M, size_t N>
+void require_matrix(const lambda::matrix<M, N> &actual,
+                    const lambda::matrix<M, N> &expected)
+{
+    for (size_t p = 0; p < M*N; ++p)
+    {
+        REQUIRE( actual[p] == Approx(expected[p]).margin(1e-12) );
+    }
+}
+
+lambda::column_vector<3> point(size_t k)
+{
+    return lambda::column_vector<3>(0.5*k - 3, std::sin(0.1*k), 1.0/(k + 1));
+}
+
+} // namespace
+
+TEST_CASE("Rigid transform composition and inverse.", "[rigid-transform]")
+{
+    const lambda::se3 a(lambda::quaternion(1, 2, -1, 0.5),
+                        lambda::column_vector<3>(1, -2, 3));
+    const lambda::se3 b(lambda::axis_angle(lambda::unitz, M_PI/2),
+                        lambda::column_vector<3>(0, 0, -1));
+
+    require_matrix(b.rotation(), lambda::matrix<3, 3>(0, -1, 0,
+                                                      1,  0, 0,
+                                                      0,  0, 1));
+    require_matrix(lambda::matrix<3, 3>(
+        a.rotation() * lambda::transpose(a.rotation())),
+        lambda::identity<3, 3>());
+
+    const lambda::column_vector<3> p(4, 5, 6);
+    require_matrix(b * p, lambda::column_vector<3>(-5, 4, 5));
+    require_matrix((a * b) * p, a * (b * p));
+    require_matrix((a * b).homogeneous(),
+        lambda::matrix<4, 4>(a.homogeneous() * b.homogeneous()));
+
+    require_matrix(lambda::inverse(a) * (a * p), p);
+    require_matrix((a * lambda::inverse(a)).homogeneous(),
+                   lambda::identity<4, 4>());
+    require_matrix(lambda::se3() * p, p);
+
+    REQUIRE_THROWS_AS(lambda::se3(lambda::quaternion(),
+        lambda::column_vector<3>()), std::domain_error);
+}
+
+TEST_CASE("Rigid transform of point clouds.", "[rigid-transform]")
+{
+    const lambda::se3 tf(lambda::quaternion(0.3, -0.2, 0.9, 0.1),
+                         lambda::column_vector<3>(10, 20, -5));
+    const size_t K = 1001;
+
+    std::vector<lambda::column_vector<3>> points;
+    for (size_t k = 0; k < K; ++k)
+    {
+        points.push_back(point(k));
+    }
+    lambda::vector_batch<3> batch(points);
+
+    const auto single = tf.apply(points);
+    const auto threaded = tf.apply(points, 4);
+    const auto batched = tf * batch;
+    REQUIRE( single.size() == K );
+    for (size_t k = 0; k < K; ++k)
+    {
+        const lambda::column_vector<3> expected = tf * points[k];
+        require_matrix(single[k], expected);
+        REQUIRE( threaded[k] == single[k] );
+        require_matrix(batched.gather(k), expected);
+    }
+
+    // Transforming in place over raw x, y, z triples.
+    std::vector<double> xyz;
+    for (const auto &p : points)
+    {
+        xyz.insert(xyz.end(), { p[0], p[1], p[2] });
+    }
+    tf.apply(xyz.data(), xyz.data(), K, 3);
+    for (size_t k = 0; k < K; ++k)
+    {
+        require_matrix(lambda::column_vector<3>(
+            xyz[3*k], xyz[3*k + 1], xyz[3*k + 2]), single[k]);
+    }
+
+    lambda::vector_batch<3> out(5);
+    tf.apply(batch, out);
+    REQUIRE( out.size() == K );
+    REQUIRE( out.gather(K - 1) == batched.gather(K - 1) );
+    REQUIRE_THROWS_AS(tf.apply(batch, batch), std::invalid_argument);
+
+    REQUIRE( tf.apply(std::vector<lambda::column_vector<3>>()).empty() );
+}
@@ -0,0 +1,95 @@
+#include <catch2/catch.hpp>
+#include <lambda/lambda.hpp>
+#include <lambda/serialization.hpp>
+
+#include <array>
+#include <limits>
+#include <sstream>
+#include <string>
+
+TEST_CASE("Formatting matrices into a buffer.", "[serialization]")
+{
+    const lambda::matrix<2, 3> m(1, -2.5, 1.0/3,
+                                 1e6, 0, -0.0004);
+    const std::string text =
+        "[1.000, -2.500, 0.333; 1000000.000, 0.000, -0.000]";
+
+    std::array<char, 128> buffer;
+    auto r = lambda::to_chars(buffer.data(),
+                              buffer.data() + buffer.size(), m);
+    REQUIRE( r.ec == std::errc() );
+    REQUIRE( std::string(buffer.data(), r.ptr) == text );
+
+    r = lambda::to_chars(buffer.data(), buffer.data() + text.size() - 1, m);
+    REQUIRE( r.ec == std::errc::value_too_large );
+    REQUIRE( r.ptr == buffer.data() + text.size() - 1 );
+
+    const lambda::dynamic_matrix d(m);
+    r = lambda::to_chars(buffer.data(), buffer.data() + buffer.size(), d);
+    REQUIRE( r.ec == std::errc() );
+    REQUIRE( std::string(buffer.data(), r.ptr) == text );
+
+    // Printing leaves the stream's formatting alone.
+    std::stringstream ss;
+    ss << m << " " << d << " " << 0.125;
+    REQUIRE( ss.str() == text + " " + text + " 0.125" );
+    REQUIRE( ss.precision() == 6 );
+
+    REQUIRE( lambda::pretty(lambda::matrix<2, 2>(1, -20, 300, 4)) ==
+        "  [   1.000 -20.000 ]\n"
+        "  [ 300.000   4.000 ]\n" );
+    REQUIRE( lambda::pretty(d) == lambda::pretty(m) );
+
+    const lambda::matrix<1, 2, lambda::complex> c(
+        lambda::complex(1, -2), lambda::complex(0.5, 0.25));
+    ss.str("");
+    ss << c;
+    REQUIRE( ss.str() == "[1.000-2.000i, 0.500+0.250i]" );
+
+    const lambda::matrix<1, 2, int> i(-7, 42);
+    r = lambda::to_chars(buffer.data(), buffer.data() + buffer.size(), i);
+    REQUIRE( std::string(buffer.data(), r.ptr) == "[-7, 42]" );
+}
+
+TEST_CASE("Binary encoding of matrices.", "[serialization]")
+{
+    const lambda::matrix<2, 3> m(1, -2.5, 1.0/3,
+        std::numeric_limits<double>::max(), 0, -1e-300);
+    lambda::dynamic_matrix d(3, 2, { 6, 5, 4, 3, 2, 1 });
+
+    std::stringstream ss;
+    lambda::write(ss, m);
+    lambda::write(ss, d);
+    REQUIRE( ss.str().size() == 2*(24 + 6*sizeof(double)) );
+    REQUIRE( ss.str().substr(0, 12) ==
+             std::string("LMAT\x01\0\0\0\x02\0\0\0", 12) );
+
+    lambda::matrix<2, 3> m2;
+    lambda::dynamic_matrix d2(1, 1);
+    lambda::read(ss, m2);
+    lambda::read(ss, d2);
+    REQUIRE( m2 == m );
+    REQUIRE( d2 == d );
+
+    // A matrix of the same size is read in place.
+    ss.clear();
+    ss.seekg(0);
+    lambda::dynamic_matrix d3(2, 3);
+    const double *data = d3.data().data();
+    lambda::read(ss, d3);
+    REQUIRE( d3 == lambda::dynamic_matrix(m) );
+    REQUIRE( d3.data().data() == data );
+
+    // Reading as the wrong size, from a truncated stream, or from
+    // something other than an encoded matrix.
+    ss.clear();
+    ss.seekg(0);
+    lambda::matrix<3, 2> wrong;
+    REQUIRE_THROWS_AS(lambda::read(ss, wrong), std::invalid_argument);
+
+    std::stringstream truncated(ss.str().substr(0, 40));
+    REQUIRE_THROWS_AS(lambda::read(truncated, m2), std::runtime_error);
+
+    std::stringstream text("[1.000, 2.000; 3.000, 4.000]");
+    REQUIRE_THROWS_AS(lambda::read(text, d2), std::invalid_argument);
+}
@@ -0,0 +1,111 @@
+#include <catch2/catch.hpp>
+#include <lambda/lambda.hpp>
+
+#include "test_matrices.hpp"
+
+namespace
+{
+
+/// \brief A matrix with roughly one element in seven nonzero.
+lambda::dynamic_matrix scattered(size_t rows, size_t columns, double seed)
+{
+    lambda::dynamic_matrix m = pattern(rows, columns, seed);
+    for (size_t i = 0; i < rows*columns; ++i)
+    {
+        if ((i*i + 3*i) % 7 != 0) m[i] = 0;
+    }
+    return m;
+}
+
+void require_close(const lambda::dynamic_matrix &a,
+                   const lambda::dynamic_matrix &b)
+{
+    REQUIRE( a.rows() == b.rows() );
+    REQUIRE( a.columns() == b.columns() );
+    for (size_t i = 0; i < a.data().size(); ++i)
+    {
+        REQUIRE( a[i] == Approx(b[i]).margin(1E-12) );
+    }
+}
+
+} // namespace
+
+TEST_CASE("Building sparse matrices.", "[sparse-matrix]")
+{
+    lambda::sparse_builder builder(3, 4);
+    builder.add(2, 3, 5);
+    builder.add(0, 1, 1);
+    builder.add(2, 0, -2);
+    builder.add(0, 1, 2);
+    REQUIRE( builder.size() == 4 );
+    REQUIRE_THROWS_AS(builder.add(3, 0, 1), std::out_of_range);
+
+    const lambda::sparse_matrix S = builder.build();
+    REQUIRE( S.rows() == 3 );
+    REQUIRE( S.columns() == 4 );
+    REQUIRE( S.nonzeros() == 3 );
+    REQUIRE( S.row_offsets() == std::pmr::vector<size_t>{ 0, 1, 1, 3 } );
+    REQUIRE( S.column_indices() == std::pmr::vector<size_t>{ 1, 0, 3 } );
+    REQUIRE( S(0, 1) == 3 );
+    REQUIRE( S(2, 0) == -2 );
+    REQUIRE( S(1, 2) == 0 );
+    REQUIRE_THROWS_AS(S.at(0, 4), std::out_of_range);
+
+    const lambda::dynamic_matrix dense(3, 4, { 0, 3, 0, 0,
+                                               0, 0, 0, 0,
+                                              -2, 0, 0, 5 });
+    REQUIRE( lambda::to_dense(S) == dense );
+    REQUIRE( lambda::sparse_matrix(dense) == S );
+    REQUIRE( lambda::to_dense(lambda::transpose(S)) ==
+             lambda::dynamic_matrix(4, 3, { 0, 0, -2,
+                                            3, 0,  0,
+                                            0, 0,  0,
+                                            0, 0,  5 }) );
+    REQUIRE( lambda::to_dense(S + 2*S) == dense*3 );
+    REQUIRE( S + lambda::sparse_matrix(3, 4) == S );
+    REQUIRE_THROWS_AS(S + lambda::sparse_matrix(4, 3),
+                      std::invalid_argument);
+
+    lambda::arena scratch;
+    {
+        lambda::scoped_resource scope(&scratch);
+        REQUIRE( (S + S).resource() == &scratch );
+        REQUIRE( transpose(S).resource() == &scratch );
+    }
+
+    REQUIRE_THROWS_AS(lambda::sparse_matrix(2, 2, { 0, 1, 2 }, { 1, 2 },
+                                            { 1, 1 }), std::invalid_argument);
+    REQUIRE_THROWS_AS(lambda::sparse_matrix(2, 2, { 0, 2, 2 }, { 1, 0 },
+                                            { 1, 1 }), std::invalid_argument);
+    REQUIRE_THROWS_AS(lambda::sparse_matrix(2, 2, { 0, 100000000, 2 },
+                                            { 0, 1 }, { 1, 1 }),
+                      std::invalid_argument);
+}
+
+TEST_CASE("Sparse matrix products.", "[sparse-matrix]")
+{
+    // Large enough that the products are split between threads.
+    const auto a = scattered(700, 500, 0.3);
+    const lambda::sparse_matrix A(a);
+    const auto x = pattern(500, 1, 0.7), X = pattern(500, 9, 1.1);
+    const auto y = pattern(700, 1, 0.5), Y = pattern(700, 9, 0.9);
+
+    lambda::set_thread_count(1);
+    const auto serial = A*X;
+    for (size_t threads : { 1, 2, 3, 4 })
+    {
+        lambda::set_thread_count(threads);
+        require_close(A*x, a*x);
+        require_close(A*X, a*X);
+        REQUIRE( A*X == serial );
+        require_close(lambda::transpose_multiply(A, y),
+                      lambda::to_dense(lambda::transpose(A))*y);
+        require_close(lambda::transpose_multiply(A, Y),
+                      lambda::to_dense(lambda::transpose(A))*Y);
+    }
+    lambda::set_thread_count(0);
+
+    REQUIRE_THROWS_AS(A*y, std::invalid_argument);
+    REQUIRE_THROWS_AS(lambda::transpose_multiply(A, x),
+                      std::invalid_argument);
+}
@@ -0,0 +1,43 @@
+#ifndef LAMBDA_TEST_MATRICES_HPP
+#define LAMBDA_TEST_MATRICES_HPP
+
+#include <lambda/lambda.hpp>
+
+#include <cmath>
+
+/*!
+    \file
+    \brief Dynamic matrices shared by the tests of operations on them.
+*/
+
+/// \brief A dense matrix of distinct, reproducible elements.
+inline lambda::dynamic_matrix pattern(size_t rows, size_t columns,
+                                      double seed)
+{
+    lambda::dynamic_matrix m(rows, columns);
+    for (size_t i = 0; i < rows*columns; ++i)
+    {
+        m[i] = std::sin(seed*(i + 1));
+    }
+    return m;
+}
+
+/// \brief The reference product, by the definition.
+inline lambda::dynamic_matrix naive(const lambda::dynamic_matrix &a,
+                                    const lambda::dynamic_matrix &b)
+{
+    lambda::dynamic_matrix c(a.rows(), b.columns());
+    for (size_t i = 0; i < a.rows(); ++i)
+    {
+        for (size_t j = 0; j < b.columns(); ++j)
+        {
+            for (size_t k = 0; k < a.columns(); ++k)
+            {
+                c(i, j) += a(i, k)*b(k, j);
+            }
+        }
+    }
+    return c;
+}
+
+#endif // LAMBDA_TEST_MATRICES_HPP
@@ -0,0 +1,118 @@
+#include <catch2/catch.hpp>
+#include <lambda/lambda.hpp>
+
+TEST_CASE("Views read the viewed matrix.", "[view]")
+{
+    lambda::matrix<3, 4> m(1,  2,  3,  4,
+                           5,  6,  7,  8,
+                           9, 10, 11, 12);
+
+    REQUIRE( lambda::block<2, 2>(m, 1, 2) == lambda::matrix<2, 2>(7,  8,
+                                                                11, 12) );
+    REQUIRE( lambda::row(m, 1) == lambda::row_vector<4>(5, 6, 7, 8) );
+    REQUIRE( lambda::col(m, 3) == lambda::column_vector<3>(4, 8, 12) );
+    REQUIRE( lambda::diagonal(m) == lambda::column_vector<3>(1, 6, 11) );
+
+    const lambda::matrix<3, 4> &c = m;
+    REQUIRE( lambda::row(c, 2)[3] == 12 );
+    REQUIRE( lambda::block<3, 1>(c, 0, 0) == lambda::col(m, 0) );
+
+    // Views refer to the matrix, so see later changes to it.
+    auto r = lambda::row(m, 0);
+    m(0, 1) = -2;
+    REQUIRE( r(0, 1) == -2 );
+
+    REQUIRE_THROWS_AS((lambda::block<2, 2>(m, 2, 0)), std::out_of_range);
+    REQUIRE_THROWS_AS((lambda::block<2, 2>(m, 0, 3)), std::out_of_range);
+}
+
+TEST_CASE("Views take part in arithmetic.", "[view]")
+{
+    lambda::matrix<6, 6> P;
+    for (size_t i = 0; i < 36; ++i)
+    {
+        P[i] = i % 7 + 0.5*i;
+    }
+    lambda::matrix<3, 3> F(1, 2, 0,
+                           0, 1, 3,
+                           4, 0, 1);
+
+    // Propagate only the position block of a 6x6 covariance.
+    lambda::matrix<3, 3> position = lambda::block<3, 3>(P, 0, 0);
+    lambda::matrix<3, 3> expected = F * position * lambda::transpose(F);
+    lambda::matrix<3, 3> propagated =
+        F * lambda::block<3, 3>(P, 0, 0) * lambda::transpose(F);
+    REQUIRE( propagated == expected );
+
+    lambda::column_vector<6> x = lambda::col(P, 2) + 2*lambda::col(P, 4);
+    for (size_t i = 0; i < 6; ++i)
+    {
+        REQUIRE( x[i] == P(i, 2) + 2*P(i, 4) );
+    }
+
+    REQUIRE( lambda::trace(P) == Approx(
+        lambda::inner_product(lambda::column_vector<6>(lambda::diagonal(P)),
+                              lambda::column_vector<6>(1, 1, 1, 1, 1, 1))) );
+
+    lambda::row_vector<6> sum = lambda::row(P, 0) + lambda::row(P, 5);
+    REQUIRE( sum[3] == P(0, 3) + P(5, 3) );
+}
+
+TEST_CASE("Assigning through views.", "[view]")
+{
+    lambda::matrix<4, 4> m;
+
+    lambda::block<2, 2>(m, 0, 2) = lambda::matrix<2, 2>(1, 2, 3, 4);
+    REQUIRE( m == lambda::matrix<4, 4>(0, 0, 1, 2,
+                                       0, 0, 3, 4,
+                                       0, 0, 0, 0,
+                                       0, 0, 0, 0) );
+
+    lambda::diagonal(m) = lambda::column_vector<4>(5, 6, 7, 8);
+    lambda::row(m, 3) += lambda::row_vector<4>(1, 1, 1, 1);
+    lambda::col(m, 0) *= 2;
+    REQUIRE( m == lambda::matrix<4, 4>(10, 0, 1, 2,
+                                        0, 6, 3, 4,
+                                        0, 0, 7, 0,
+                                        2, 1, 1, 9) );
+
+    // Reading the viewed matrix while writing it goes through a
+    // temporary, so swapping blocks by transposing is safe.
+    lambda::block<2, 2>(m, 0, 0) =
+        lambda::transpose(lambda::block<2, 2>(m, 0, 0)) +
+        lambda::block<2, 2>(m, 2, 2);
+    REQUIRE( lambda::block<2, 2>(m, 0, 0) ==
+             lambda::matrix<2, 2>(17, 0, 1, 15) );
+
+    lambda::row(m, 0) = lambda::row(m, 1);
+    REQUIRE( lambda::row(m, 0) == lambda::row(m, 1) );
+
+    m = lambda::transpose(m) * lambda::diagonal(m)(1, 0);
+    REQUIRE( m(3, 2) == 0 );
+    REQUIRE( m(0, 3) == 2*15 );
+
+    lambda::matrix<3, 3> a = lambda::identity<3, 3>();
+    m = lambda::identity<4, 4>();
+    lambda::block<3, 3>(m, 1, 1) -= 2*a;
+    REQUIRE( lambda::diagonal(m) == lambda::column_vector<4>(1, -1, -1, -1) );
+}
+
+namespace
+{
+
+constexpr lambda::matrix<3, 3> with_row_swapped()
+{
+    lambda::matrix<3, 3> m(1, 2, 3,
+                           4, 5, 6,
+                           7, 8, 9);
+    lambda::row(m, 0) = lambda::row(m, 2);
+    lambda::diagonal(m) *= 10;
+    return m;
+}
+
+static_assert(with_row_swapped() == lambda::matrix<3, 3>(70, 8, 9,
+                                                           4, 50, 6,
+                                                           7, 8, 90),
+              "Views in constant expressions");
+
+}